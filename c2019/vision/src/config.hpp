@@ -1,9 +1,11 @@
 #pragma once
 
+// windows, trackbars and drawing, except in the headless build
+#ifndef HEADLESS
 #define DEBUG
+#endif
 
 #include <string>
-#include <wpi/Twine.h>
 
 namespace team114
 {
@@ -23,6 +25,15 @@ const int MJPEG_FPS = 15;
 
 const std::string RIO_VISION_ADDR("0.0.0.0");
 const std::string RIO_VISION_PORT("5808");
+// where the RIO sends clock sync pings, see copcomp/clock_sync.hpp
+const std::string VISION_SYNC_PORT("5810");
+
+// tuning over HTTP, see param_server.hpp, and where the values are kept
+const int PARAM_HTTP_PORT = 5807;
+const std::string PARAMS_PATH("vision-params.txt");
+
+// the forward camera's calibration from cam-calibration, see lens.hpp
+const std::string LENS_CALIBRATION_PATH("2018042100000030_1.xml");
 
 } // namespace vision
 } // namespace c2019
@@ -12,7 +12,7 @@
 using namespace cs;
 using namespace team114::c2019::vision;
 
-int main(int argc, char **argv)
+int main()
 {
     wpi::outs() << "hostname: " << cs::GetHostname() << '\n';
     wpi::outs() << "IPv4 network addresses:\n";
@@ -21,12 +21,15 @@ int main(int argc, char **argv)
 
     UsbCamera fcam{"ForwardCamera", CAM_FORWARD_ID};
     fcam.SetVideoMode(cs::VideoMode::kMJPEG, MJPEG_WIDTH, MJPEG_HEIGHT, MJPEG_FPS);
+    // the MJPEG goes out as the camera sent it, no need to copy it out first
+    fcam.GetProperty("zero_copy").Set(1);
     cs::MjpegServer fMjpegServer{"ForwardHTTPMjpeg", MJPEG_FORWARD_PORT};
     fMjpegServer.SetSource(fcam);
     fMjpegServer.SetFPS(MJPEG_FPS);
 
     UsbCamera rcam{"ReverseCamera", CAM_REVERSE_ID};
     fcam.SetVideoMode(cs::VideoMode::kMJPEG, MJPEG_WIDTH, MJPEG_HEIGHT, MJPEG_FPS);
+    rcam.GetProperty("zero_copy").Set(1);
     cs::MjpegServer rMjpegServer{"ReverseHTTPMjpeg", MJPEG_REVERSE_PORT};
     rMjpegServer.SetSource(rcam);
     rMjpegServer.SetFPS(MJPEG_FPS);
@@ -35,7 +38,7 @@ int main(int argc, char **argv)
 #ifdef DEBUG
     std::cout << std::fixed << std::showpoint << std::setprecision(4);
     cs::AddListener(
-        [&](const cs::RawEvent &event) {
+        [&](const cs::RawEvent &) {
             std::cout << "FFPS=" << fcam.GetActualFPS() << " FMBPS=" << (fcam.GetActualDataRate() / 1000000.0) << std::endl;
             std::cout << "RFPS=" << rcam.GetActualFPS() << " RMBPS=" << (rcam.GetActualDataRate() / 1000000.0) << std::endl;
         },
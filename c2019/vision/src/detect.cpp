@@ -0,0 +1,185 @@
+#include "detect.hpp"
+
+#include <cmath>
+#include <iostream>
+
+#include "macros.hpp"
+
+using namespace cv;
+using namespace std;
+
+namespace team114
+{
+namespace c2019
+{
+namespace vision
+{
+
+void threshold(Frame &frame, const Params &params, ThresholdScratch &scratch)
+{
+    SHOW("raw", frame.raw);
+
+    resize(frame.raw, frame.resized, RESIZED_SIZE);
+    SHOW("resized", frame.resized);
+
+    // the lens is left in, detect() undistorts the points it reports
+
+#ifdef DEBUG
+    GaussianBlur(frame.resized, scratch.blurred, Size(3, 3), 0, 0);
+    SHOW("blurred", scratch.blurred);
+    cvtColor(scratch.blurred, scratch.hsv, CV_RGB2HSV);
+    SHOW("hsv", scratch.hsv);
+#endif
+
+    // blur, HSV conversion and inRange in one pass, see hsv_threshold.hpp
+    frame.roi &= Rect(Point(), frame.resized.size());
+    HsvRange range{params.hlow, params.hhigh, params.slow, params.shigh, params.vlow, params.vhigh};
+    if (frame.roi.area() == 0) {
+        hsv_threshold(frame.resized, frame.mask, range, true, scratch.fused);
+    } else {
+        // the blur reflects at the roi's edges rather than reading past them,
+        // which only changes pixels a target is not expected to touch
+        frame.mask.create(frame.resized.size(), CV_8UC1);
+#ifdef DEBUG
+        frame.mask.setTo(0);
+#endif
+        Mat mask = frame.mask(frame.roi);
+        hsv_threshold(frame.resized(frame.roi), mask, range, true, scratch.fused);
+    }
+    SHOW("mask", frame.mask);
+}
+
+void detect(Frame &frame, const Params &params, const Lens &lens, DetectScratch &scratch)
+{
+    auto &contours = scratch.contours;
+    auto &targets = scratch.targets;
+    auto &matched = scratch.matched;
+
+    contours.clear();
+    if (frame.roi.area() == 0) {
+        findContours(frame.mask, contours, RETR_EXTERNAL, CHAIN_APPROX_TC89_KCOS);
+    } else {
+        findContours(frame.mask(frame.roi), contours, RETR_EXTERNAL, CHAIN_APPROX_TC89_KCOS, frame.roi.tl());
+    }
+#ifdef DEBUG
+    if (frame.roi.area() > 0) {
+        rectangle(frame.resized, frame.roi, Scalar(255, 0, 255));
+    }
+#endif
+
+#ifdef DEBUG
+    drawContours(frame.resized, contours, -1, Scalar(255, 255, 0));
+#endif
+    SHOW("contours", frame.resized);
+
+    targets.clear();
+    for (auto &cnt : contours) {
+        // determine if contour is a valid target
+        scratch.convex_cnt.clear();
+        convexHull(cnt, scratch.convex_cnt);
+        RotatedRect rect = minAreaRect(scratch.convex_cnt);
+
+        if (rect.size.area() < params.minTargetRectArea) {
+            DBP("area too small");
+            continue;
+        }
+        float area = static_cast<float>(contourArea(scratch.convex_cnt));
+        if (area / rect.size.area() < static_cast<float>(params.minTargetFullness) / 1000) {
+            DBP("fullness too low");
+            continue;
+        }
+
+        targets.push_back(rect);
+    }
+
+    // preprocess rectangles for system solving
+    for (RotatedRect &rect : targets) {
+#ifdef DEBUG
+        Point2f rect_points[4];
+        rect.points(rect_points);
+        for (int j = 0; j < 4; j++)
+            line(frame.resized, rect_points[j], rect_points[(j + 1) % 4], Scalar(0, 0, 255), 1, 8);
+#endif
+        // remember, opencv coordinate system has a flipped y, angles are still from +x towards +y
+        // ensures the angle is to the positive side of the rect
+        if (rect.size.width < rect.size.height) {
+            rect.angle -= 90;
+        } else {
+            // means height < width
+            // ensure height > width
+            auto temp = rect.size.height;
+            rect.size.height = rect.size.width;
+            rect.size.width = temp;
+        }
+#ifdef DEBUG
+        putText(frame.resized, to_string(rect.size.width > rect.size.height), rect.center, CV_FONT_HERSHEY_PLAIN, 1.0, Scalar(0, 255, 255));
+        putText(frame.resized, to_string(static_cast<int>(rect.center.x)), rect.center, CV_FONT_HERSHEY_PLAIN, 1.0, Scalar(0, 0, 255));
+#endif
+    }
+    SHOW("boxes", frame.resized);
+    DBP("tlen" << targets.size());
+
+    // pair them up, see match.hpp
+    scratch.strips.clear();
+    for (const RotatedRect &rect : targets) {
+        scratch.strips.push(rect.center.x, rect.center.y, rect.size.width, rect.angle);
+    }
+    match_pairs(scratch.strips, params.maxHorizontalDistanceFactor, scratch.match, matched);
+#ifdef DEBUG
+    for (size_t i = 0; i < targets.size(); ++i) {
+        const Point2f &c = targets[i].center;
+        line(frame.resized, c, Point(c.x + 300 * scratch.match.dx[i], c.y + 300 * scratch.match.dy[i]), Scalar(0, 255, 0));
+    }
+    for (const Match &m : matched) {
+        line(frame.resized, Point(m.center_x, 0), Point(m.center_x, 200), Scalar(0, 255, 0));
+    }
+#endif
+    SHOW("targeted", frame.resized);
+
+    frame.packets.clear();
+    frame.found = Rect();
+    scratch.corners.clear();
+    for (const Match &m : matched) {
+        Rect box = targets[m.left].boundingRect() | targets[m.right].boundingRect();
+        frame.found = frame.found.area() == 0 ? box : (frame.found | box);
+        // find the bottom inside point of each rotated rect
+        auto &lr = targets[m.left];
+        double _angle = lr.angle * CV_PI / 180.;
+        float b = (float)sin(_angle) * -0.5f;
+        float a = (float)cos(_angle) * 0.5f;
+        Point2f left;
+        left.x = lr.center.x - a * lr.size.height + b * lr.size.width;
+        left.y = lr.center.y + b * lr.size.height + a * lr.size.width;
+
+        auto &rr = targets[m.right];
+        _angle = rr.angle * CV_PI / 180.;
+        b = (float)sin(_angle) * -0.5f;
+        a = (float)cos(_angle) * 0.5f;
+        Point2f right;
+        right.x = rr.center.x - a * rr.size.height - b * rr.size.width;
+        right.y = rr.center.y + b * rr.size.height - a * rr.size.width;
+
+#ifdef DEBUG
+        circle(frame.resized, (left + right) * 0.5f, 2, Scalar(255, 255, 0), -1);
+#endif
+        scratch.corners.push_back(left);
+        scratch.corners.push_back(right);
+    }
+    SHOW("spoints", frame.resized);
+
+    // only these points need undistorting, not the image they were found in
+    lens.undistort(scratch.corners, scratch.undistorted);
+    for (size_t i = 0; i + 1 < scratch.undistorted.size(); i += 2) {
+        // take the mean of the points
+        Point2f mean = (scratch.undistorted[i] + scratch.undistorted[i + 1]) * 0.5f;
+        Packet packet;
+        packet.micros = frame.capture_micros;
+        packet.x = mean.x;
+        packet.y = mean.y;
+        frame.packets.push_back(packet);
+    }
+}
+
+} // namespace vision
+} // namespace c2019
+} // namespace team114
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <copcomp/2019packet.hpp>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "config.hpp"
+#include "hsv_threshold.hpp"
+#include "lens.hpp"
+#include "match.hpp"
+#include "params.hpp"
+
+namespace team114
+{
+namespace c2019
+{
+namespace vision
+{
+
+// what raw is scaled to before any processing
+const cv::Size RESIZED_SIZE(320, 240);
+
+// One camera frame and everything derived from it, handed between the stages
+// of the headless pipeline. Frames are reused, so the Mats and vectors keep
+// their allocations from one frame to the next.
+struct Frame {
+    uint64_t seq = 0;
+    int64_t capture_micros = 0; // V4L2 buffer stamp, monotonic
+    int64_t grabbed_micros = 0; // when capture returned it
+    int64_t thresholded_micros = 0;
+    int64_t detected_micros = 0;
+    int64_t search_micros = 0; // thresholding and detecting, less queue waits
+    Params params;             // taken at capture, so every stage of a frame agrees
+    cv::Mat raw;
+    cv::Mat resized;        // also the canvas for DEBUG drawing
+    cv::Mat mask;           // only valid within roi
+    cv::Rect roi;           // the part of resized searched, empty for all of it
+    cv::Rect found;         // bounds of the matched targets, empty for none
+    bool fell_back = false; // the roi missed and all of resized was searched
+    std::vector<Packet> packets;
+};
+
+// per stage temporaries, one per thread running the stage
+struct ThresholdScratch {
+    HsvScratch fused;
+#ifdef DEBUG
+    // only for showing the intermediate steps, the mask does not use them
+    cv::Mat blurred;
+    cv::Mat hsv;
+#endif
+};
+
+struct DetectScratch {
+    std::vector<std::vector<cv::Point>> contours;
+    std::vector<cv::Point> convex_cnt;
+    std::vector<cv::RotatedRect> targets;
+    Strips strips;
+    MatchScratch match;
+    std::vector<Match> matched;
+    std::vector<cv::Point2f> corners; // the inner bottom corner of each matched strip
+    std::vector<cv::Point2f> undistorted;
+};
+
+// raw into resized and the HSV threshold mask, within roi
+void threshold(Frame &frame, const Params &params, ThresholdScratch &scratch);
+
+// mask within roi into packets for each matched pair of tape strips, stamped with the
+// frame's capture time, at undistorted pixel coordinates if lens is calibrated
+void detect(Frame &frame, const Params &params, const Lens &lens, DetectScratch &scratch);
+
+} // namespace vision
+} // namespace c2019
+} // namespace team114
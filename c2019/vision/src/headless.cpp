@@ -0,0 +1,241 @@
+// Headless vision for the TX1. Capture, thresholding, target detection and
+// sending each run on their own thread, joined by DropQueues that keep only the
+// newest frame, so throughput is set by the slowest stage instead of the sum
+// of them. Every REPORT_PERIOD it prints the frame rate, drops and latency
+// from the V4L2 capture stamp to the packets leaving.
+//
+//     c2019-vision-headless [camera index | video file]
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <copcomp/copcomp.hpp>
+#include <csignal>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "config.hpp"
+#include "detect.hpp"
+#include "param_server.hpp"
+#include "pipeline.hpp"
+#include "track.hpp"
+
+using namespace cv;
+using namespace std;
+using namespace team114;
+using namespace team114::c2019::vision;
+
+namespace
+{
+
+// each stage queue holds just the newest frame
+const size_t QUEUE_DEPTH = 1;
+// a frame in each of the 4 stages and 3 queues, and one spare for capture
+const size_t POOL_SIZE = 8;
+const chrono::seconds REPORT_PERIOD(5);
+// how long the send stage waits for a frame before answering sync pings anyway
+const chrono::milliseconds SEND_POLL(20);
+
+atomic<bool> running(true);
+
+void stop(int) { running = false; }
+
+// the pool holds every frame, so it never drops
+void recycle(DropQueue<Frame *> &pool, Frame *frame)
+{
+    Frame *unused;
+    pool.push(frame, unused);
+}
+
+// hands frames down the pipeline, recycling the ones a queue dropped
+void forward(DropQueue<Frame *> &to, DropQueue<Frame *> &pool, Frame *frame)
+{
+    Frame *dropped;
+    if (to.push(frame, dropped)) {
+        recycle(pool, dropped);
+    }
+}
+
+struct Latencies {
+    vector<int64_t> end_to_end; // capture stamp to sent
+    int64_t grab = 0;           // capture stamp to capture returning
+    int64_t threshold = 0;
+    int64_t detect = 0;
+    int64_t send = 0; // detect to sent, including the wait in the queue
+    uint64_t frames = 0;
+    uint64_t targets = 0;
+    TrackStats tracking; // since start, a window may have no full searches to compare with
+
+    void add(const Frame &f, int64_t sent)
+    {
+        tracking.add(f, f.search_micros);
+        end_to_end.push_back(sent - f.capture_micros);
+        grab += f.grabbed_micros - f.capture_micros;
+        threshold += f.thresholded_micros - f.grabbed_micros;
+        detect += f.detected_micros - f.thresholded_micros;
+        send += sent - f.detected_micros;
+        frames++;
+        targets += f.packets.size();
+    }
+
+    void report(double seconds, uint64_t captured, uint64_t dropped)
+    {
+        cout << fixed << setprecision(1) << "captured " << captured / seconds << " fps, sent " << frames / seconds << " fps, dropped "
+             << dropped << ", targets " << targets;
+        if (frames > 0) {
+            sort(end_to_end.begin(), end_to_end.end());
+            int64_t sum = 0;
+            for (int64_t l : end_to_end) {
+                sum += l;
+            }
+            double n = static_cast<double>(frames);
+            cout << "\n  latency ms mean " << sum / n / 1000 << " p50 " << end_to_end[end_to_end.size() / 2] / 1000.0 << " p99 "
+                 << end_to_end[end_to_end.size() * 99 / 100] / 1000.0 << " max " << end_to_end.back() / 1000.0 << "\n  stage ms grab "
+                 << grab / n / 1000 << " threshold " << threshold / n / 1000 << " detect " << detect / n / 1000 << " send "
+                 << send / n / 1000 << "\n  ";
+            tracking.report(cout);
+        }
+        cout << endl;
+        end_to_end.clear();
+        grab = threshold = detect = send = 0;
+        frames = targets = 0;
+    }
+};
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+
+    VideoCapture cam;
+    // only a camera's stamps are on the monotonic clock, a file's are its
+    // position in the video
+    bool camera =
+        argc < 2 || all_of(argv[1], argv[1] + strlen(argv[1]), [](char c) { return isdigit(static_cast<unsigned char>(c)) != 0; });
+    if (argc < 2) {
+        cam.open(0);
+    } else if (camera) {
+        cam.open(stoi(argv[1]));
+    } else {
+        cam.open(argv[1]);
+    }
+    if (!cam.isOpened()) {
+        cerr << "could not open " << (argc < 2 ? "camera 0" : argv[1]) << endl;
+        return 1;
+    }
+
+    // tuned live over HTTP, each frame takes a snapshot as it is captured
+    ParamRegistry registry;
+    if (!registry.load(PARAMS_PATH)) {
+        cerr << "could not load " << PARAMS_PATH << ", using defaults" << endl;
+    }
+    ParamServer param_server(registry, PARAM_HTTP_PORT, PARAMS_PATH);
+    Lens lens;
+    if (!lens.load(LENS_CALIBRATION_PATH, RESIZED_SIZE)) {
+        cerr << "could not load " << LENS_CALIBRATION_PATH << ", targets are not undistorted" << endl;
+    }
+    copcomp::Connection rio_sender(RIO_VISION_ADDR, RIO_VISION_PORT, VISION_SYNC_PORT);
+
+    vector<Frame> frames(POOL_SIZE);
+    DropQueue<Frame *> pool(POOL_SIZE);
+    DropQueue<Frame *> to_threshold(QUEUE_DEPTH);
+    DropQueue<Frame *> to_detect(QUEUE_DEPTH);
+    DropQueue<Frame *> to_send(QUEUE_DEPTH);
+    for (Frame &f : frames) {
+        recycle(pool, &f);
+    }
+    atomic<uint64_t> captured(0);
+
+    thread capture_thread([&] {
+        Frame *frame;
+        uint64_t seq = 0;
+        while (running && pool.pop(frame)) {
+            if (!cam.read(frame->raw) || frame->raw.empty()) {
+                cerr << "capture ended" << endl;
+                running = false;
+                recycle(pool, frame);
+                break;
+            }
+            frame->grabbed_micros = copcomp::monotonic_micros();
+            frame->capture_micros = camera ? static_cast<int64_t>(cam.get(CAP_PROP_POS_MSEC) * 1000.0) : 0;
+            if (frame->capture_micros <= 0) {
+                frame->capture_micros = frame->grabbed_micros;
+            }
+            frame->seq = seq++;
+            frame->params = registry.get();
+            captured++;
+            forward(to_threshold, pool, frame);
+        }
+        to_threshold.close();
+    });
+
+    Tracker tracker;
+
+    thread threshold_thread([&] {
+        ThresholdScratch scratch;
+        Frame *frame;
+        while (to_threshold.pop(frame)) {
+            int64_t start = copcomp::monotonic_micros();
+            frame->roi = frame->params.roiTracking ? tracker.predict(frame->capture_micros) : Rect();
+            threshold(*frame, frame->params, scratch);
+            frame->thresholded_micros = copcomp::monotonic_micros();
+            frame->search_micros = frame->thresholded_micros - start;
+            forward(to_detect, pool, frame);
+        }
+        to_detect.close();
+    });
+
+    thread detect_thread([&] {
+        DetectScratch scratch;
+        // for searching the whole frame after the roi missed
+        ThresholdScratch fallback_scratch;
+        Frame *frame;
+        while (to_detect.pop(frame)) {
+            int64_t start = copcomp::monotonic_micros();
+            detect_tracked(*frame, frame->params, lens, scratch, fallback_scratch, tracker);
+            frame->detected_micros = copcomp::monotonic_micros();
+            frame->search_micros += frame->detected_micros - start;
+            forward(to_send, pool, frame);
+        }
+        to_send.close();
+    });
+
+    Latencies latencies;
+    latencies.end_to_end.reserve(chrono::duration_cast<chrono::seconds>(REPORT_PERIOD).count() * 240);
+    auto report_start = chrono::steady_clock::now();
+    uint64_t reported_captured = 0;
+    uint64_t reported_dropped = 0;
+    while (!to_send.closed()) {
+        Frame *frame;
+        if (to_send.pop(frame, SEND_POLL)) {
+            rio_sender.write_items(frame->packets.data(), frame->packets.size());
+            latencies.add(*frame, copcomp::monotonic_micros());
+            recycle(pool, frame);
+        }
+        // the RIO maps packet times onto its clock from these round trips
+        rio_sender.answer_sync_pings();
+
+        auto now = chrono::steady_clock::now();
+        if (now - report_start >= REPORT_PERIOD) {
+            uint64_t dropped = to_threshold.dropped_count() + to_detect.dropped_count() + to_send.dropped_count();
+            latencies.report(chrono::duration<double>(now - report_start).count(), captured - reported_captured,
+                             dropped - reported_dropped);
+            report_start = now;
+            reported_captured = captured;
+            reported_dropped = dropped;
+        }
+    }
+
+    pool.close();
+    capture_thread.join();
+    threshold_thread.join();
+    detect_thread.join();
+    return 0;
+}
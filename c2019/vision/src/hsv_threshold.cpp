@@ -0,0 +1,268 @@
+#include "hsv_threshold.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HSV_THRESHOLD_NEON
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define HSV_THRESHOLD_AVX2
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#define HSV_THRESHOLD_SSE41
+#endif
+
+// Rows are blurred and split into r, g and b planes in small buffers, then
+// converted and thresholded several pixels at a time. The conversion follows
+// OpenCV's 8 bit RGB2HSV exactly:
+//
+//     s = (diff * round(255 * 2^12 / v) + 2^11) >> 12
+//     h = (num * round(180 * 2^12 / (6 * diff)) + 2^11) >> 12, + 180 if < 0
+//
+// except that OpenCV looks the divisions up in tables, which SIMD can't do
+// without gathers, so they are computed with a float divide instead. IEEE
+// division is correctly rounded, and for every v and diff in 1..255 the float
+// quotient rounds to the same integer as the double the tables are built from.
+
+namespace team114
+{
+namespace c2019
+{
+namespace vision
+{
+
+namespace
+{
+
+const int HSV_SHIFT = 12;
+const float SDIV = 255 << HSV_SHIFT;
+const float HDIV = 180 << HSV_SHIFT;
+
+// One pixel at a time, for the ends of rows and as the reference
+struct Scalar1 {
+    static const int LANES = 1;
+    using I = int32_t;
+    static I load(const uint8_t *p) { return *p; }
+    static I set(int32_t v) { return v; }
+    static I add(I a, I b) { return a + b; }
+    static I sub(I a, I b) { return a - b; }
+    static I mul(I a, I b) { return a * b; }
+    static I shift(I a) { return a >> HSV_SHIFT; }
+    static I max(I a, I b) { return a > b ? a : b; }
+    static I min(I a, I b) { return a < b ? a : b; }
+    static I eq(I a, I b) { return a == b ? -1 : 0; }
+    static I gt(I a, I b) { return a > b ? -1 : 0; }
+    static I band(I a, I b) { return a & b; }
+    static I andnot(I a, I b) { return ~a & b; }
+    static I bor(I a, I b) { return a | b; }
+    static I div_round(float num, I den) { return static_cast<I>(std::lrintf(num / static_cast<float>(den))); }
+    static void store(uint8_t *p, I mask) { *p = static_cast<uint8_t>(mask); }
+};
+
+#if defined(HSV_THRESHOLD_NEON)
+struct Simd {
+    static const int LANES = 4;
+    using I = int32x4_t;
+    static I load(const uint8_t *p)
+    {
+        uint32_t bytes;
+        std::memcpy(&bytes, p, sizeof(bytes));
+        uint16x8_t wide = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(bytes)));
+        return vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(wide)));
+    }
+    static I set(int32_t v) { return vdupq_n_s32(v); }
+    static I add(I a, I b) { return vaddq_s32(a, b); }
+    static I sub(I a, I b) { return vsubq_s32(a, b); }
+    static I mul(I a, I b) { return vmulq_s32(a, b); }
+    static I shift(I a) { return vshrq_n_s32(a, HSV_SHIFT); }
+    static I max(I a, I b) { return vmaxq_s32(a, b); }
+    static I min(I a, I b) { return vminq_s32(a, b); }
+    static I eq(I a, I b) { return vreinterpretq_s32_u32(vceqq_s32(a, b)); }
+    static I gt(I a, I b) { return vreinterpretq_s32_u32(vcgtq_s32(a, b)); }
+    static I band(I a, I b) { return vandq_s32(a, b); }
+    static I andnot(I a, I b) { return vbicq_s32(b, a); }
+    static I bor(I a, I b) { return vorrq_s32(a, b); }
+    // to nearest, ties to even, as lrintf
+    static I div_round(float num, I den) { return vcvtnq_s32_f32(vdivq_f32(vdupq_n_f32(num), vcvtq_f32_s32(den))); }
+    static void store(uint8_t *p, I mask)
+    {
+        int16x4_t half = vmovn_s32(mask);
+        int8x8_t bytes = vmovn_s16(vcombine_s16(half, half));
+        uint32_t out = vget_lane_u32(vreinterpret_u32_s8(bytes), 0);
+        std::memcpy(p, &out, sizeof(out));
+    }
+};
+const char *const ISA = "neon";
+#elif defined(HSV_THRESHOLD_AVX2)
+struct Simd {
+    static const int LANES = 8;
+    using I = __m256i;
+    static I load(const uint8_t *p) { return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))); }
+    static I set(int32_t v) { return _mm256_set1_epi32(v); }
+    static I add(I a, I b) { return _mm256_add_epi32(a, b); }
+    static I sub(I a, I b) { return _mm256_sub_epi32(a, b); }
+    static I mul(I a, I b) { return _mm256_mullo_epi32(a, b); }
+    static I shift(I a) { return _mm256_srai_epi32(a, HSV_SHIFT); }
+    static I max(I a, I b) { return _mm256_max_epi32(a, b); }
+    static I min(I a, I b) { return _mm256_min_epi32(a, b); }
+    static I eq(I a, I b) { return _mm256_cmpeq_epi32(a, b); }
+    static I gt(I a, I b) { return _mm256_cmpgt_epi32(a, b); }
+    static I band(I a, I b) { return _mm256_and_si256(a, b); }
+    static I andnot(I a, I b) { return _mm256_andnot_si256(a, b); }
+    static I bor(I a, I b) { return _mm256_or_si256(a, b); }
+    // to nearest, ties to even, under the default MXCSR rounding
+    static I div_round(float num, I den) { return _mm256_cvtps_epi32(_mm256_div_ps(_mm256_set1_ps(num), _mm256_cvtepi32_ps(den))); }
+    static void store(uint8_t *p, I mask)
+    {
+        // packs work within each 128 bit half
+        __m256i words = _mm256_packs_epi32(mask, mask);
+        __m256i bytes = _mm256_packs_epi16(words, words);
+        int lo = _mm_cvtsi128_si32(_mm256_castsi256_si128(bytes));
+        int hi = _mm_cvtsi128_si32(_mm256_extracti128_si256(bytes, 1));
+        std::memcpy(p, &lo, 4);
+        std::memcpy(p + 4, &hi, 4);
+    }
+};
+const char *const ISA = "avx2";
+#elif defined(HSV_THRESHOLD_SSE41)
+struct Simd {
+    static const int LANES = 4;
+    using I = __m128i;
+    static I load(const uint8_t *p)
+    {
+        int bytes;
+        std::memcpy(&bytes, p, sizeof(bytes));
+        return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes));
+    }
+    static I set(int32_t v) { return _mm_set1_epi32(v); }
+    static I add(I a, I b) { return _mm_add_epi32(a, b); }
+    static I sub(I a, I b) { return _mm_sub_epi32(a, b); }
+    static I mul(I a, I b) { return _mm_mullo_epi32(a, b); }
+    static I shift(I a) { return _mm_srai_epi32(a, HSV_SHIFT); }
+    static I max(I a, I b) { return _mm_max_epi32(a, b); }
+    static I min(I a, I b) { return _mm_min_epi32(a, b); }
+    static I eq(I a, I b) { return _mm_cmpeq_epi32(a, b); }
+    static I gt(I a, I b) { return _mm_cmpgt_epi32(a, b); }
+    static I band(I a, I b) { return _mm_and_si128(a, b); }
+    static I andnot(I a, I b) { return _mm_andnot_si128(a, b); }
+    static I bor(I a, I b) { return _mm_or_si128(a, b); }
+    // to nearest, ties to even, under the default MXCSR rounding
+    static I div_round(float num, I den) { return _mm_cvtps_epi32(_mm_div_ps(_mm_set1_ps(num), _mm_cvtepi32_ps(den))); }
+    static void store(uint8_t *p, I mask)
+    {
+        __m128i words = _mm_packs_epi32(mask, mask);
+        __m128i bytes = _mm_packs_epi16(words, words);
+        int out = _mm_cvtsi128_si32(bytes);
+        std::memcpy(p, &out, sizeof(out));
+    }
+};
+const char *const ISA = "sse4.1";
+#else
+using Simd = Scalar1;
+const char *const ISA = "scalar";
+#endif
+
+// Thresholds pixels [x, n) of the planes in steps of S::LANES, leaving x at
+// the first pixel it did not get to
+template <typename S>
+void hsv_in_range(const uint8_t *rp, const uint8_t *gp, const uint8_t *bp, uint8_t *out, int n, const HsvRange &range, int &x)
+{
+    using I = typename S::I;
+    const I one = S::set(1);
+    const I six = S::set(6);
+    const I zero = S::set(0);
+    const I round = S::set(1 << (HSV_SHIFT - 1));
+    const I hue_range = S::set(180);
+    const I hlow = S::set(range.hlow), hhigh = S::set(range.hhigh);
+    const I slow = S::set(range.slow), shigh = S::set(range.shigh);
+    const I vlow = S::set(range.vlow), vhigh = S::set(range.vhigh);
+    const I all = S::set(-1);
+    for (; x + S::LANES <= n; x += S::LANES) {
+        I r = S::load(rp + x);
+        I g = S::load(gp + x);
+        I b = S::load(bp + x);
+        I v = S::max(S::max(b, g), r);
+        I diff = S::sub(v, S::min(S::min(b, g), r));
+        // ties go to r, then g, as in OpenCV
+        I vr = S::eq(v, r);
+        I vg = S::eq(v, g);
+
+        // a zero v or diff has a zero numerator, so dividing by 1 instead of 0
+        // keeps OpenCV's 0
+        I s = S::shift(S::add(S::mul(diff, S::div_round(SDIV, S::max(v, one))), round));
+        I diff2 = S::add(diff, diff);
+        I h_g = S::add(S::sub(b, r), diff2);
+        I h_b = S::add(S::sub(r, g), S::add(diff2, diff2));
+        I num = S::add(S::band(vr, S::sub(g, b)), S::andnot(vr, S::add(S::band(vg, h_g), S::andnot(vg, h_b))));
+        I h = S::shift(S::add(S::mul(num, S::div_round(HDIV, S::mul(S::max(diff, one), six))), round));
+        h = S::add(h, S::band(S::gt(zero, h), hue_range));
+
+        I outside = S::bor(S::bor(S::gt(hlow, h), S::gt(h, hhigh)), S::bor(S::gt(slow, s), S::gt(s, shigh)));
+        outside = S::bor(outside, S::bor(S::gt(vlow, v), S::gt(v, vhigh)));
+        S::store(out + x, S::andnot(outside, all));
+    }
+}
+
+} // namespace
+
+void hsv_threshold(const uint8_t *src, size_t src_step, int width, int height, uint8_t *mask, size_t mask_step, const HsvRange &range,
+                   bool blur, HsvScratch &scratch)
+{
+    size_t n = static_cast<size_t>(width);
+    scratch.planes.resize(3 * n);
+    // CV_RGB2HSV reads channel 0 as red
+    uint8_t *rp = scratch.planes.data();
+    uint8_t *gp = rp + n;
+    uint8_t *bp = gp + n;
+    if (blur) {
+        CV_Assert(width >= 2 && height >= 2);
+        scratch.vsum.resize(3 * n);
+    }
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *row = src + y * src_step;
+        if (blur) {
+            // [1 2 1] down the columns, then across, with GaussianBlur's
+            // BORDER_REFLECT_101 edges and its fixed point rounding, half up
+            const uint8_t *up = src + (y > 0 ? y - 1 : 1) * src_step;
+            const uint8_t *down = src + (y < height - 1 ? y + 1 : height - 2) * src_step;
+            uint16_t *vs = scratch.vsum.data();
+            for (size_t i = 0; i < 3 * n; ++i) {
+                vs[i] = static_cast<uint16_t>(up[i] + 2 * row[i] + down[i]);
+            }
+            uint8_t *planes[3] = {rp, gp, bp};
+            for (int c = 0; c < 3; ++c) {
+                uint8_t *plane = planes[c];
+                plane[0] = static_cast<uint8_t>((2 * vs[c] + 2 * vs[3 + c] + 8) >> 4);
+                for (size_t x = 1; x + 1 < n; ++x) {
+                    plane[x] = static_cast<uint8_t>((vs[3 * x - 3 + c] + 2 * vs[3 * x + c] + vs[3 * x + 3 + c] + 8) >> 4);
+                }
+                plane[n - 1] = static_cast<uint8_t>((2 * vs[3 * n - 6 + c] + 2 * vs[3 * n - 3 + c] + 8) >> 4);
+            }
+        } else {
+            for (size_t x = 0; x < n; ++x) {
+                rp[x] = row[3 * x];
+                gp[x] = row[3 * x + 1];
+                bp[x] = row[3 * x + 2];
+            }
+        }
+        uint8_t *out = mask + y * mask_step;
+        int x = 0;
+        hsv_in_range<Simd>(rp, gp, bp, out, width, range, x);
+        hsv_in_range<Scalar1>(rp, gp, bp, out, width, range, x);
+    }
+}
+
+void hsv_threshold(const cv::Mat &src, cv::Mat &mask, const HsvRange &range, bool blur, HsvScratch &scratch)
+{
+    CV_Assert(src.type() == CV_8UC3);
+    mask.create(src.size(), CV_8UC1);
+    hsv_threshold(src.data, src.step, src.cols, src.rows, mask.data, mask.step, range, blur, scratch);
+}
+
+const char *hsv_threshold_isa() { return ISA; }
+
+} // namespace vision
+} // namespace c2019
+} // namespace team114
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <opencv2/core.hpp>
+#include <vector>
+
+namespace team114
+{
+namespace c2019
+{
+namespace vision
+{
+
+// inclusive bounds, as inRange takes them
+struct HsvRange {
+    int hlow;
+    int hhigh;
+    int slow;
+    int shigh;
+    int vlow;
+    int vhigh;
+};
+
+// Per row buffers, kept between frames so the kernel does not allocate
+struct HsvScratch {
+    std::vector<uint16_t> vsum;
+    std::vector<uint8_t> planes;
+};
+
+// One pass equivalent of
+//
+//     GaussianBlur(src, blurred, Size(3, 3), 0, 0); // if blur
+//     cvtColor(blurred, hsv, CV_RGB2HSV);
+//     inRange(hsv, Scalar(hlow, slow, vlow), Scalar(hhigh, shigh, vhigh), mask);
+//
+// bit for bit, without the two intermediate images. src is 8 bit, 3 channel,
+// read the way CV_RGB2HSV reads it (channel 0 as red), at least 2x2 if
+// blurring. mask is 0 or 255 per pixel.
+void hsv_threshold(const uint8_t *src, size_t src_step, int width, int height, uint8_t *mask, size_t mask_step, const HsvRange &range,
+                   bool blur, HsvScratch &scratch);
+
+// mask is (re)created as CV_8UC1 the size of src
+void hsv_threshold(const cv::Mat &src, cv::Mat &mask, const HsvRange &range, bool blur, HsvScratch &scratch);
+
+// the instruction set the kernel was built for, for the benchmarks
+const char *hsv_threshold_isa();
+
+} // namespace vision
+} // namespace c2019
+} // namespace team114
@@ -0,0 +1,68 @@
+#include "lens.hpp"
+
+#include <opencv2/imgproc.hpp>
+
+using namespace cv;
+
+namespace team114
+{
+namespace c2019
+{
+namespace vision
+{
+
+bool Lens::load(const std::string &path, Size processed)
+{
+    FileStorage fs;
+    try {
+        if (!fs.open(path, FileStorage::READ)) {
+            return false;
+        }
+    } catch (const cv::Exception &) {
+        return false;
+    }
+    Mat camera, dist;
+    std::vector<int> resolution;
+    fs["cameraMatrix"] >> camera;
+    fs["dist_coeffs"] >> dist;
+    fs["cameraResolution"] >> resolution;
+    if (camera.rows != 3 || camera.cols != 3 || dist.empty() || resolution.size() != 2 || resolution[0] <= 0 || resolution[1] <= 0) {
+        return false;
+    }
+
+    // calibrated at the camera's resolution, found at the processed one:
+    // scale the focal lengths and move the center, pixel centers staying put
+    camera.convertTo(camera_, CV_64F);
+    double sx = static_cast<double>(processed.width) / resolution[0];
+    double sy = static_cast<double>(processed.height) / resolution[1];
+    camera_.at<double>(0, 0) *= sx;
+    camera_.at<double>(1, 1) *= sy;
+    camera_.at<double>(0, 2) = (camera_.at<double>(0, 2) + 0.5) * sx - 0.5;
+    camera_.at<double>(1, 2) = (camera_.at<double>(1, 2) + 0.5) * sy - 0.5;
+    dist.convertTo(dist_, CV_64F);
+    initUndistortRectifyMap(camera_, dist_, Mat(), camera_, processed, CV_16SC2, map1_, map2_);
+    return true;
+}
+
+void Lens::undistort(const std::vector<Point2f> &points, std::vector<Point2f> &out) const
+{
+    if (!calibrated() || points.empty()) {
+        out = points;
+        return;
+    }
+    // projected back through the same matrix, so the result stays in pixels
+    undistortPoints(points, out, camera_, dist_, noArray(), camera_);
+}
+
+void Lens::undistort(const Mat &src, Mat &dst) const
+{
+    if (!calibrated()) {
+        src.copyTo(dst);
+        return;
+    }
+    remap(src, dst, map1_, map2_, INTER_LINEAR);
+}
+
+} // namespace vision
+} // namespace c2019
+} // namespace team114
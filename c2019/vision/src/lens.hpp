@@ -0,0 +1,44 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+
+namespace team114
+{
+namespace c2019
+{
+namespace vision
+{
+
+// A camera's calibration from cam-calibration, scaled to the size the
+// pipeline processes at. Targets are found in the distorted image and only
+// the points reported for them are undistorted, a handful per frame instead
+// of remapping every pixel. Until load() succeeds points pass through as is.
+class Lens
+{
+  public:
+    // the cameraMatrix, dist_coeffs and cameraResolution the calibration
+    // tool writes, false and left uncalibrated if missing or malformed
+    bool load(const std::string &path, cv::Size processed);
+
+    bool calibrated() const { return !camera_.empty(); }
+
+    // pixel coordinates in the processed image to where an ideal pinhole
+    // camera with the same matrix would have seen them
+    void undistort(const std::vector<cv::Point2f> &points, std::vector<cv::Point2f> &out) const;
+
+    // the whole image, through the fixed point maps load() builds, for
+    // showing what the lens does rather than for the pipeline
+    void undistort(const cv::Mat &src, cv::Mat &dst) const;
+
+  private:
+    cv::Mat camera_;
+    cv::Mat dist_;
+    cv::Mat map1_; // CV_16SC2 integer coordinates
+    cv::Mat map2_; // CV_16UC1 interpolation table index
+};
+
+} // namespace vision
+} // namespace c2019
+} // namespace team114
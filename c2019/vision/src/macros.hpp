@@ -1,15 +1,6 @@
 // defines DEBUG
 #include "config.hpp"
 
-#ifdef DEBUG
-#define ALGORITHM_PARAM(NAME, DEFAULT, max) \
-    int NAME = DEFAULT;                     \
-    createTrackbar(#NAME ":", "params", &NAME, max);
-#else
-#define ALGORITHM_PARAM(name, default, max) \
-    const int name = default;
-#endif
-
 #ifdef DEBUG
 #define SHOW(name, mat)                 \
     namedWindow(name, WINDOW_NORMAL);   \
@@ -0,0 +1,101 @@
+#include "match.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace team114
+{
+namespace c2019
+{
+namespace vision
+{
+
+namespace
+{
+
+// CV_PI, without OpenCV
+const double PI = 3.1415926535897932384626433832795;
+
+} // namespace
+
+void Strips::clear()
+{
+    x.clear();
+    y.clear();
+    width.clear();
+    angle.clear();
+}
+
+void Strips::push(float x_, float y_, float width_, float angle_)
+{
+    x.push_back(x_);
+    y.push_back(y_);
+    width.push_back(width_);
+    angle.push_back(angle_);
+}
+
+void match_pairs(const Strips &strips, int maxHorizontalDistanceFactor, MatchScratch &scratch, std::vector<Match> &matched)
+{
+    const size_t n = strips.size();
+    const float *x = strips.x.data();
+    const float *y = strips.y.data();
+    const float *width = strips.width.data();
+
+    scratch.dx.resize(n);
+    scratch.dy.resize(n);
+    scratch.order.resize(n);
+    float *dx = scratch.dx.data();
+    float *dy = scratch.dy.data();
+    float max_width = 0;
+    for (size_t i = 0; i < n; ++i) {
+        dx[i] = static_cast<float>(std::cos(strips.angle[i] * PI / 180.0));
+        dy[i] = static_cast<float>(std::sin(strips.angle[i] * PI / 180.0));
+        max_width = std::max(max_width, width[i]);
+        scratch.order[i] = static_cast<uint32_t>(i);
+    }
+    std::sort(scratch.order.begin(), scratch.order.end(), [x](uint32_t a, uint32_t b) { return x[a] < x[b] || (x[a] == x[b] && a < b); });
+
+    // the arithmetic is the all pairs loop's, in the same types, so the same
+    // pairs match
+    const double factor = static_cast<float>(maxHorizontalDistanceFactor) / 100.0;
+    matched.clear();
+    for (size_t si = 0; si < n; ++si) {
+        uint32_t i = scratch.order[si];
+        // no strip further right than this can be close enough to i
+        double reach = (width[i] + max_width) / 2.0 * factor;
+        for (size_t sj = si + 1; sj < n; ++sj) {
+            uint32_t j = scratch.order[sj];
+            if (x[j] - x[i] > reach) {
+                break;
+            }
+            uint32_t a = std::min(i, j);
+            uint32_t b = std::max(i, j);
+            float avgwidth = (width[b] + width[a]) / 2.0;
+            if (std::abs(x[a] - x[b]) > avgwidth * factor) {
+                continue;
+            }
+            // solve the system of two vertical-ish lines through the strip centers
+            // A + a*t = B + b*s
+            float t = -(x[a] * dy[b] - y[a] * dx[b] - x[b] * dy[b] + y[b] * dx[b]) / (dx[a] * dy[b] - dy[a] * dx[b]);
+            float center_x = x[a] + dx[a] * t;
+            // if the solution lies between the two centers, they form a match
+            float max_x = std::max(x[a], x[b]);
+            float min_x = std::min(x[a], x[b]);
+            if (min_x < center_x && center_x < max_x) {
+                if (x[a] < center_x) {
+                    matched.push_back(Match{a, b, center_x});
+                } else {
+                    matched.push_back(Match{b, a, center_x});
+                }
+            }
+        }
+    }
+    std::sort(matched.begin(), matched.end(), [](const Match &p, const Match &q) {
+        uint32_t plo = std::min(p.left, p.right), qlo = std::min(q.left, q.right);
+        return plo < qlo || (plo == qlo && std::max(p.left, p.right) < std::max(q.left, q.right));
+    });
+}
+
+} // namespace vision
+} // namespace c2019
+} // namespace team114
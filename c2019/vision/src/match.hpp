@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace team114
+{
+namespace c2019
+{
+namespace vision
+{
+
+// The candidate tape strips, one entry per strip in each array, after
+// detect() has turned each so height > width and angle runs along it
+struct Strips {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> width;
+    std::vector<float> angle; // degrees
+
+    size_t size() const { return x.size(); }
+    void clear();
+    void push(float x, float y, float width, float angle);
+};
+
+// two strips whose center lines cross between them, by index into Strips
+struct Match {
+    uint32_t left;
+    uint32_t right;
+    float center_x; // where the lines cross
+};
+
+struct MatchScratch {
+    std::vector<float> dx; // unit direction along each strip
+    std::vector<float> dy;
+    std::vector<uint32_t> order; // strips by x
+};
+
+// Pairs strips closer than maxHorizontalDistanceFactor hundredths of their
+// average width whose center lines cross between them. Strips are sorted by
+// x so each is only tried against the ones within reach, and each strip's
+// direction is computed once. matched comes out as the all pairs loop this
+// replaced found them, by the lower then the higher index.
+void match_pairs(const Strips &strips, int maxHorizontalDistanceFactor, MatchScratch &scratch, std::vector<Match> &matched);
+
+} // namespace vision
+} // namespace c2019
+} // namespace team114
@@ -17,6 +17,8 @@ void create_server(std::string name, int cam_id)
         wpi::outs() << "  " << addr << '\n';
     UsbCamera camera{name, cam_id};
     camera.SetVideoMode(cs::VideoMode::kMJPEG, MJPEG_WIDTH, MJPEG_HEIGHT, MJPEG_FPS);
+    // the MJPEG goes out as the camera sent it, no need to copy it out first
+    camera.GetProperty("zero_copy").Set(1);
     cs::MjpegServer mjpegServer{"httpserver", MJPEG_FORWARD_PORT};
     mjpegServer.SetSource(camera);
     mjpegServer.SetFPS(MJPEG_FPS);
@@ -25,7 +27,7 @@ void create_server(std::string name, int cam_id)
 #ifdef DEBUG
     std::cout << std::fixed << std::showpoint << std::setprecision(4);
     cs::AddListener(
-        [&](const cs::RawEvent &event) {
+        [&](const cs::RawEvent &) {
             std::cout << "FPS=" << camera.GetActualFPS() << " MBPS=" << (camera.GetActualDataRate() / 1000000.0) << std::endl;
         },
         cs::RawEvent::kTelemetryUpdated, false, &status);
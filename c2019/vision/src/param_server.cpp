@@ -0,0 +1,156 @@
+#include "param_server.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <utility>
+
+namespace team114
+{
+namespace c2019
+{
+namespace vision
+{
+
+namespace
+{
+
+// how often the serving thread checks it should stop
+const int POLL_MILLIS = 200;
+// requests are a line and a few headers, a client slower than this is dropped
+const int CLIENT_TIMEOUT_SECONDS = 1;
+const size_t MAX_REQUEST = 4096;
+
+} // namespace
+
+ParamServer::ParamServer(ParamRegistry &registry, int port, std::string save_path) : registry_(registry), save_path_(std::move(save_path))
+{
+    fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        return;
+    }
+    // restarting must not wait out the last run's TIME_WAIT connections
+    int on = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (::bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(fd_, 4) != 0) {
+        std::cerr << "params: could not listen on " << port << ": " << std::strerror(errno) << std::endl;
+        ::close(fd_);
+        fd_ = -1;
+        return;
+    }
+    thread_ = std::thread([this] { serve(); });
+}
+
+ParamServer::~ParamServer()
+{
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+void ParamServer::serve()
+{
+    while (running_) {
+        pollfd pfd{fd_, POLLIN, 0};
+        if (::poll(&pfd, 1, POLL_MILLIS) <= 0) {
+            continue;
+        }
+        int client = ::accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            continue;
+        }
+        timeval timeout{CLIENT_TIMEOUT_SECONDS, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        handle(client);
+        ::close(client);
+    }
+}
+
+void ParamServer::handle(int client)
+{
+    // only the request line matters, read until it is complete
+    std::string request;
+    char buf[512];
+    while (request.find("\r\n") == std::string::npos && request.size() < MAX_REQUEST) {
+        ssize_t n = ::recv(client, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            return;
+        }
+        request.append(buf, static_cast<size_t>(n));
+    }
+    std::string response = respond(request.substr(0, request.find("\r\n")));
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = ::send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+std::string ParamServer::respond(const std::string &request_line)
+{
+    std::istringstream in(request_line);
+    std::string method, target;
+    in >> method >> target;
+    std::string path = target.substr(0, target.find('?'));
+
+    std::string status = "200 OK";
+    std::string body;
+    if (method != "GET" || path != "/params") {
+        status = "404 Not Found";
+        body = "GET /params, optionally ?name=value&...\n";
+    } else {
+        bool changed = false;
+        std::string query = target.size() > path.size() ? target.substr(path.size() + 1) : "";
+        std::istringstream pairs(query);
+        std::string pair;
+        while (std::getline(pairs, pair, '&')) {
+            size_t eq = pair.find('=');
+            std::string name = pair.substr(0, eq);
+            char *end = nullptr;
+            long value = eq == std::string::npos ? 0 : std::strtol(pair.c_str() + eq + 1, &end, 10);
+            // out of range values are clamped by set, keep them within an int
+            value = std::min(std::max(value, -1L), 1L << 20);
+            if (eq == std::string::npos || end == pair.c_str() + eq + 1 || *end != '\0' || !registry_.set(name, static_cast<int>(value))) {
+                status = "400 Bad Request";
+                body = "# could not set " + pair + "\n";
+                break;
+            }
+            changed = true;
+        }
+        if (changed && !registry_.save(save_path_)) {
+            body += "# not saved to " + save_path_ + "\n";
+        }
+        body += registry_.format();
+    }
+
+    std::ostringstream out;
+    out << "HTTP/1.1 " << status << "\r\nContent-Type: text/plain\r\nContent-Length: " << body.size() << "\r\nConnection: close\r\n\r\n"
+        << body;
+    return out.str();
+}
+
+} // namespace vision
+} // namespace c2019
+} // namespace team114
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "params.hpp"
+
+namespace team114
+{
+namespace c2019
+{
+namespace vision
+{
+
+// Tunes a ParamRegistry from a laptop while the pipeline runs:
+//
+//     curl http://tegra-ubuntu:5807/params
+//     curl 'http://tegra-ubuntu:5807/params?hlow=50&vhigh=95'
+//
+// Both answer with the current values, in the params file format. Changes are
+// written to save_path, which the vision programs load at startup.
+class ParamServer
+{
+  public:
+    // serves on its own thread until destroyed, see ok()
+    ParamServer(ParamRegistry &registry, int port, std::string save_path);
+    ~ParamServer();
+
+    ParamServer(const ParamServer &) = delete;
+    ParamServer &operator=(const ParamServer &) = delete;
+
+    // false if the port could not be bound, the pipeline runs on regardless
+    bool ok() const { return fd_ >= 0; }
+
+  private:
+    void serve();
+    void handle(int client);
+    // the status line and body for a request line, "GET /params?a=1 HTTP/1.1"
+    std::string respond(const std::string &request_line);
+
+    ParamRegistry &registry_;
+    std::string save_path_;
+    int fd_ = -1;
+    std::atomic<bool> running_{true};
+    std::thread thread_;
+};
+
+} // namespace vision
+} // namespace c2019
+} // namespace team114
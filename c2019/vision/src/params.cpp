@@ -0,0 +1,138 @@
+#include "params.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace team114
+{
+namespace c2019
+{
+namespace vision
+{
+
+const ParamInfo PARAM_INFO[PARAM_COUNT] = {
+    {"hlow", &Params::hlow, 255},
+    {"hhigh", &Params::hhigh, 255},
+    {"slow", &Params::slow, 255},
+    {"shigh", &Params::shigh, 255},
+    {"vlow", &Params::vlow, 255},
+    {"vhigh", &Params::vhigh, 255},
+    {"minTargetRectArea", &Params::minTargetRectArea, 500},
+    {"minTargetFullness", &Params::minTargetFullness, 1000},
+    {"maxHorizontalDistanceFactor", &Params::maxHorizontalDistanceFactor, 800},
+    {"roiTracking", &Params::roiTracking, 1},
+};
+
+Params ParamRegistry::get() const
+{
+    Params params;
+    uint32_t before, after;
+    do {
+        before = seq_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < PARAM_COUNT; ++i) {
+            params.*PARAM_INFO[i].field = values_[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = seq_.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    return params;
+}
+
+void ParamRegistry::store(const Params &params)
+{
+    // odd while the values change, see get()
+    uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < PARAM_COUNT; ++i) {
+        values_[i].store(params.*PARAM_INFO[i].field, std::memory_order_relaxed);
+    }
+    seq_.store(seq + 2, std::memory_order_release);
+}
+
+bool ParamRegistry::set(const std::string &name, int value)
+{
+    for (const ParamInfo &info : PARAM_INFO) {
+        if (name == info.name) {
+            std::lock_guard<std::mutex> lock(write_mutex_);
+            Params params = get();
+            params.*info.field = std::min(std::max(value, 0), info.max);
+            store(params);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ParamRegistry::set_all(const Params &params)
+{
+    Params clamped = params;
+    for (const ParamInfo &info : PARAM_INFO) {
+        clamped.*info.field = std::min(std::max(clamped.*info.field, 0), info.max);
+    }
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    store(clamped);
+}
+
+std::string ParamRegistry::format() const
+{
+    Params params = get();
+    std::ostringstream out;
+    for (const ParamInfo &info : PARAM_INFO) {
+        out << info.name << ' ' << params.*info.field << '\n';
+    }
+    return out.str();
+}
+
+bool ParamRegistry::parse(const std::string &text, std::string &error)
+{
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        if (!(fields >> name) || name[0] == '#') {
+            continue;
+        }
+        int value;
+        std::string rest;
+        if (!(fields >> value) || (fields >> rest) || !set(name, value)) {
+            error = line;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ParamRegistry::load(const std::string &path)
+{
+    std::ifstream in(path);
+    if (!in) {
+        return errno == ENOENT;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+    std::string error;
+    return parse(text.str(), error);
+}
+
+bool ParamRegistry::save(const std::string &path) const
+{
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp);
+        out << format();
+        if (!out.flush()) {
+            return false;
+        }
+    }
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+} // namespace vision
+} // namespace c2019
+} // namespace team114
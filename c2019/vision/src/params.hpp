@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace team114
+{
+namespace c2019
+{
+namespace vision
+{
+
+// The tunables of the target detection
+struct Params {
+    int hlow = 54;
+    int hhigh = 77;
+    int slow = 137;
+    int shigh = 255;
+    int vlow = 0;
+    int vhigh = 89;
+    int minTargetRectArea = 100;
+    int minTargetFullness = 500;           // thousandths of the bounding rect filled
+    int maxHorizontalDistanceFactor = 550; // hundredths of the average width
+    int roiTracking = 1;                   // search around the last targets first, see track.hpp
+};
+
+// name, where it lives and its largest value, for the trackbars, the HTTP
+// endpoint and the params file
+struct ParamInfo {
+    const char *name;
+    int Params::*field;
+    int max;
+};
+
+constexpr size_t PARAM_COUNT = 10;
+extern const ParamInfo PARAM_INFO[PARAM_COUNT];
+
+// The live Params. The pipeline takes a copy each frame with get(), which
+// never blocks: a seqlock lets it retry in the rare case an update from the
+// tuning endpoint lands mid copy, instead of the camera threads ever waiting
+// on a lock the network thread holds.
+class ParamRegistry
+{
+  public:
+    ParamRegistry() { store(Params{}); }
+
+    Params get() const;
+
+    // clamps to [0, max], false if there is no such parameter
+    bool set(const std::string &name, int value);
+    void set_all(const Params &params);
+
+    // "name value" per line, the params file format
+    std::string format() const;
+    // applies each "name value" line, skipping blank and # lines, false
+    // naming the first line it could not use in error
+    bool parse(const std::string &text, std::string &error);
+
+    // a missing file keeps the current values
+    bool load(const std::string &path);
+    // written beside and renamed over, so a crash never leaves half a file
+    bool save(const std::string &path) const;
+
+  private:
+    void store(const Params &params);
+
+    std::mutex write_mutex_; // writers still take turns
+    std::atomic<uint32_t> seq_{0};
+    std::atomic<int> values_[PARAM_COUNT];
+};
+
+} // namespace vision
+} // namespace c2019
+} // namespace team114
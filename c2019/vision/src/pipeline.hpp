@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace team114
+{
+namespace c2019
+{
+namespace vision
+{
+
+// Bounded queue between two pipeline stages. A push into a full queue
+// displaces the oldest item instead of waiting, so a slow stage always picks
+// up the newest frame and the ones it could not get to are dropped rather than
+// adding latency. The displaced item is handed back to recycle.
+template <typename T> class DropQueue
+{
+  public:
+    explicit DropQueue(size_t capacity) : items_(capacity) {}
+
+    // True if dropped was displaced to make room
+    bool push(T item, T &dropped)
+    {
+        bool displaced = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (size_ == items_.size()) {
+                dropped = items_[head_];
+                head_ = (head_ + 1) % items_.size();
+                size_--;
+                dropped_count_++;
+                displaced = true;
+            }
+            items_[(head_ + size_) % items_.size()] = item;
+            size_++;
+        }
+        cond_.notify_one();
+        return displaced;
+    }
+
+    // Waits up to timeout for an item. False on timeout, or once closed and
+    // empty, see closed().
+    template <typename Rep, typename Period> bool pop(T &out, std::chrono::duration<Rep, Period> timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!cond_.wait_for(lock, timeout, [this] { return size_ > 0 || closed_; }) || size_ == 0) {
+            return false;
+        }
+        out = items_[head_];
+        head_ = (head_ + 1) % items_.size();
+        size_--;
+        return true;
+    }
+
+    bool pop(T &out)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this] { return size_ > 0 || closed_; });
+        if (size_ == 0) {
+            return false;
+        }
+        out = items_[head_];
+        head_ = (head_ + 1) % items_.size();
+        size_--;
+        return true;
+    }
+
+    // wakes and fails pops once the queue is empty
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        cond_.notify_all();
+    }
+
+    bool closed()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_ && size_ == 0;
+    }
+
+    uint64_t dropped_count()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return dropped_count_;
+    }
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<T> items_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+    bool closed_ = false;
+    uint64_t dropped_count_ = 0;
+};
+
+} // namespace vision
+} // namespace c2019
+} // namespace team114
@@ -0,0 +1,264 @@
+// Runs the target detection over a directory of images or a recorded video,
+// with no camera, windows or RIO, to judge an algorithm change for both
+// accuracy and speed. Each target found is written to a CSV or, by the
+// extension, a CBOR sequence of Detections, to diff against a previous run.
+// Then it reports the time spent in each stage and the frame rate.
+//
+//     c2019-vision-replay <image directory | video file> [detections.csv | .cbor] [passes]
+//
+// It runs with the values in PARAMS_PATH and the lens calibration when
+// started where the vision program keeps them, the defaults otherwise. Later passes over the same
+// frames only add to the timing, images are decoded again each pass like a
+// camera frame would be.
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <copcomp/cbor.hpp>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "config.hpp"
+#include "detect.hpp"
+#include "track.hpp"
+
+using namespace cv;
+using namespace std;
+using namespace team114;
+using namespace team114::c2019::vision;
+
+namespace
+{
+
+// one target in one frame, a row of the output
+struct Detection {
+    uint32_t frame;
+    uint32_t target;
+    float x;
+    float y;
+
+    COPCOMP_CBOR_FIELD(Detection, frame);
+    COPCOMP_CBOR_FIELD(Detection, target);
+    COPCOMP_CBOR_FIELD(Detection, x);
+    COPCOMP_CBOR_FIELD(Detection, y);
+    using CborFields = copcomp::cbor::FieldList<CborField_frame, CborField_target, CborField_x, CborField_y>;
+};
+
+class Source
+{
+  public:
+    explicit Source(const string &path)
+    {
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            vector<String> all;
+            glob(path + "/*", all, false);
+            for (const String &f : all) {
+                string lower(f);
+                transform(lower.begin(), lower.end(), lower.begin(),
+                          [](char c) { return static_cast<char>(tolower(static_cast<unsigned char>(c))); });
+                for (const char *ext : {".jpg", ".jpeg", ".png", ".bmp"}) {
+                    if (lower.size() > strlen(ext) && lower.compare(lower.size() - strlen(ext), string::npos, ext) == 0) {
+                        files_.push_back(f);
+                        break;
+                    }
+                }
+            }
+        } else {
+            video_ = path;
+        }
+    }
+
+    bool empty() const { return files_.empty() && video_.empty(); }
+
+    // back to the first frame for another pass
+    bool rewind()
+    {
+        next_ = 0;
+        return video_.empty() || cap_.open(video_);
+    }
+
+    bool read(Mat &out, string &name)
+    {
+        if (video_.empty()) {
+            while (next_ < files_.size()) {
+                name = files_[next_++];
+                out = imread(name);
+                if (!out.empty()) {
+                    return true;
+                }
+                cerr << "could not read " << name << endl;
+            }
+            return false;
+        }
+        name = to_string(next_++);
+        return cap_.read(out) && !out.empty();
+    }
+
+  private:
+    vector<String> files_;
+    string video_;
+    VideoCapture cap_;
+    size_t next_ = 0;
+};
+
+class Output
+{
+  public:
+    explicit Output(const string &path) : cbor_(path.size() > 5 && path.compare(path.size() - 5, 5, ".cbor") == 0)
+    {
+        if (path.empty()) {
+            return;
+        }
+        out_.open(path, cbor_ ? ios::binary : ios::out);
+        if (!cbor_) {
+            out_ << "frame,source,target,x,y\n";
+        }
+    }
+
+    bool ok() const { return !out_.fail(); }
+
+    void write(const Detection &d, const string &source)
+    {
+        if (!out_.is_open()) {
+            return;
+        }
+        if (cbor_) {
+            copcomp::cbor::Buffer<Detection> buf;
+            size_t len = copcomp::cbor::encode(d, buf);
+            out_.write(reinterpret_cast<const char *>(buf.data()), len);
+        } else {
+            out_ << d.frame << ',' << source << ',' << d.target << ',' << d.x << ',' << d.y << '\n';
+        }
+    }
+
+  private:
+    bool cbor_;
+    ofstream out_;
+};
+
+struct Stage {
+    const char *name;
+    vector<int64_t> micros;
+
+    void report(double frames) const
+    {
+        vector<int64_t> sorted(micros);
+        sort(sorted.begin(), sorted.end());
+        int64_t sum = 0;
+        for (int64_t m : sorted) {
+            sum += m;
+        }
+        cout << fixed << setprecision(2) << "  " << setw(9) << left << name << right << " mean " << setw(7) << sum / frames / 1000
+             << " p50 " << setw(7) << sorted[sorted.size() / 2] / 1000.0 << " p99 " << setw(7) << sorted[sorted.size() * 99 / 100] / 1000.0
+             << " max " << setw(7) << sorted.back() / 1000.0 << " ms" << endl;
+    }
+};
+
+int64_t micros_since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        cerr << "usage: " << argv[0] << " <image directory | video file> [detections.csv | .cbor] [passes]" << endl;
+        return 2;
+    }
+    Source source(argv[1]);
+    Output output(argc > 2 ? argv[2] : "");
+    int passes = argc > 3 ? max(1, stoi(argv[3])) : 1;
+    if (source.empty() || !source.rewind()) {
+        cerr << "no images in " << argv[1] << endl;
+        return 1;
+    }
+    if (!output.ok()) {
+        cerr << "could not write " << argv[2] << endl;
+        return 1;
+    }
+
+    // the tuned values if run where the vision program keeps them
+    ParamRegistry registry;
+    if (!registry.load(PARAMS_PATH)) {
+        cerr << "could not load " << PARAMS_PATH << endl;
+        return 1;
+    }
+    Params params = registry.get();
+    Lens lens;
+    if (!lens.load(LENS_CALIBRATION_PATH, RESIZED_SIZE)) {
+        cerr << "could not load " << LENS_CALIBRATION_PATH << ", targets are not undistorted" << endl;
+    }
+    Frame frame;
+    ThresholdScratch threshold_scratch;
+    DetectScratch detect_scratch;
+    Tracker tracker;
+    TrackStats tracking;
+    Stage read{"read", {}}, thresh{"threshold", {}}, detection{"detect", {}}, total{"total", {}};
+    uint64_t targets = 0;
+    string name;
+
+    for (int pass = 0; pass < passes; ++pass) {
+        if (pass > 0 && !source.rewind()) {
+            break;
+        }
+        for (uint32_t seq = 0;; ++seq) {
+            auto start = chrono::steady_clock::now();
+            if (!source.read(frame.raw, name)) {
+                break;
+            }
+            int64_t read_done = micros_since(start);
+            // frames are numbered in the output so runs diff, the tracker
+            // sees them 30 a second
+            frame.seq = seq;
+            frame.capture_micros = static_cast<int64_t>(seq) * 1000000 / 30;
+            frame.roi = params.roiTracking ? tracker.predict(frame.capture_micros) : Rect();
+            threshold(frame, params, threshold_scratch);
+            int64_t threshold_done = micros_since(start);
+            detect_tracked(frame, params, lens, detect_scratch, threshold_scratch, tracker);
+            int64_t detect_done = micros_since(start);
+
+            read.micros.push_back(read_done);
+            thresh.micros.push_back(threshold_done - read_done);
+            detection.micros.push_back(detect_done - threshold_done);
+            total.micros.push_back(detect_done);
+            tracking.add(frame, detect_done - read_done);
+            if (pass == 0) {
+                for (uint32_t i = 0; i < frame.packets.size(); ++i) {
+                    output.write(Detection{seq, i, frame.packets[i].x, frame.packets[i].y}, name);
+                }
+                targets += frame.packets.size();
+            }
+        }
+    }
+
+    if (total.micros.empty()) {
+        cerr << "no frames read from " << argv[1] << endl;
+        return 1;
+    }
+    double frames = static_cast<double>(total.micros.size());
+    int64_t sum = 0;
+    for (int64_t m : total.micros) {
+        sum += m;
+    }
+    cout << fixed << total.micros.size() << " frames in " << passes << " passes, " << targets << " targets per pass, "
+         << setprecision(1) << frames * 1e6 / sum << " fps" << endl;
+    for (const Stage *stage : {&read, &thresh, &detection, &total}) {
+        stage->report(frames);
+    }
+    if (params.roiTracking) {
+        cout << "  ";
+        tracking.report(cout);
+        cout << endl;
+    }
+    return 0;
+}
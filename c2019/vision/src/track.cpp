@@ -0,0 +1,135 @@
+#include "track.hpp"
+
+#include <cmath>
+#include <iomanip>
+
+using namespace cv;
+
+namespace team114
+{
+namespace c2019
+{
+namespace vision
+{
+
+namespace
+{
+
+// older sightings say little about where the targets are now
+const int64_t MAX_AGE_MICROS = 100000;
+// room around the predicted box on each side, as a fraction of its size
+// and a minimum in pixels
+const float MARGIN = 0.5f;
+const float MIN_PAD = 12.0f;
+// a region this much of the frame saves too little to risk a miss
+const double MAX_ROI_FRACTION = 0.5;
+
+Point2f center(const Rect &r) { return Point2f(r.x + r.width / 2.0f, r.y + r.height / 2.0f); }
+
+// roi less the pixel along each side that is not also the frame's edge, a
+// target reaching past it may have been cut off
+Rect interior(const Rect &roi)
+{
+    int left = roi.x > 0 ? 1 : 0;
+    int top = roi.y > 0 ? 1 : 0;
+    int right = roi.x + roi.width < RESIZED_SIZE.width ? 1 : 0;
+    int bottom = roi.y + roi.height < RESIZED_SIZE.height ? 1 : 0;
+    return Rect(roi.x + left, roi.y + top, roi.width - left - right, roi.height - top - bottom);
+}
+
+} // namespace
+
+Rect Tracker::predict(int64_t capture_micros)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t ahead = capture_micros - last_.micros;
+    if (last_.box.area() == 0 || ahead < 0 || ahead > MAX_AGE_MICROS) {
+        return Rect();
+    }
+
+    Point2f c = center(last_.box);
+    int64_t between = last_.micros - previous_.micros;
+    if (previous_.box.area() > 0 && between > 0 && between <= MAX_AGE_MICROS) {
+        Point2f velocity = (c - center(previous_.box)) * (1.0f / between);
+        c += velocity * static_cast<float>(ahead);
+    }
+
+    float pad_x = MARGIN * last_.box.width + MIN_PAD;
+    float pad_y = MARGIN * last_.box.height + MIN_PAD;
+    Rect roi(Point(cvFloor(c.x - last_.box.width / 2.0f - pad_x), cvFloor(c.y - last_.box.height / 2.0f - pad_y)),
+             Point(cvCeil(c.x + last_.box.width / 2.0f + pad_x), cvCeil(c.y + last_.box.height / 2.0f + pad_y)));
+    roi &= Rect(Point(), RESIZED_SIZE);
+    // extrapolated off the frame leaves a sliver along its edge, too thin to
+    // blur and threshold, and with no room for the targets anyway
+    if (roi.width < 2 * MIN_PAD || roi.height < 2 * MIN_PAD) {
+        return Rect();
+    }
+    if (roi.area() > MAX_ROI_FRACTION * RESIZED_SIZE.area()) {
+        return Rect();
+    }
+    return roi;
+}
+
+void Tracker::update(int64_t capture_micros, const Rect &found)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (found.area() == 0) {
+        // searched in full and gone, start over
+        last_ = previous_ = Sighting{0, Rect()};
+        return;
+    }
+    previous_ = last_;
+    last_ = Sighting{capture_micros, found};
+}
+
+void detect_tracked(Frame &frame, const Params &params, const Lens &lens, DetectScratch &scratch, ThresholdScratch &threshold_scratch,
+                    Tracker &tracker)
+{
+    detect(frame, params, lens, scratch);
+    frame.fell_back = false;
+    if (frame.roi.area() > 0) {
+        bool inside = frame.found.area() > 0 && (frame.found & interior(frame.roi)) == frame.found;
+        if (!inside) {
+            frame.roi = Rect();
+            frame.fell_back = true;
+            threshold(frame, params, threshold_scratch);
+            detect(frame, params, lens, scratch);
+        }
+    }
+    tracker.update(frame.capture_micros, frame.found);
+}
+
+void TrackStats::add(const Frame &frame, int64_t search_micros)
+{
+    if (frame.fell_back) {
+        fallbacks++;
+        fallback_micros += search_micros;
+    } else if (frame.roi.area() > 0) {
+        roi_frames++;
+        roi_micros += search_micros;
+    } else {
+        full_frames++;
+        full_micros += search_micros;
+    }
+}
+
+void TrackStats::report(std::ostream &out) const
+{
+    uint64_t frames = roi_frames + full_frames + fallbacks;
+    if (frames == 0) {
+        return;
+    }
+    auto mean_ms = [](int64_t micros, uint64_t n) { return n == 0 ? 0.0 : micros / 1000.0 / n; };
+    out << std::fixed << std::setprecision(1) << "roi " << 100.0 * roi_frames / frames << "% of frames, " << fallbacks
+        << " fell back, search ms roi " << std::setprecision(2) << mean_ms(roi_micros, roi_frames) << " full "
+        << mean_ms(full_micros, full_frames) << " fallback " << mean_ms(fallback_micros, fallbacks);
+    if (full_frames > 0) {
+        // what searching everything would have cost, less what was spent
+        double saved = frames * mean_ms(full_micros, full_frames) - (roi_micros + full_micros + fallback_micros) / 1000.0;
+        out << ", saved " << std::setprecision(1) << saved << " ms";
+    }
+}
+
+} // namespace vision
+} // namespace c2019
+} // namespace team114
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <opencv2/core.hpp>
+#include <ostream>
+
+#include "detect.hpp"
+
+namespace team114
+{
+namespace c2019
+{
+namespace vision
+{
+
+// Once the targets are found, the next frame only needs searching around
+// where they will be. The Tracker predicts that region from the last two
+// detections, moving at their pixel velocity, which also covers the robot
+// turning. A miss, or targets running into the region's edge, searches the
+// whole frame again at once, see detect_tracked.
+//
+// The threshold stage predicts and the detect stage updates, on different
+// threads in the headless pipeline, so the Tracker locks for both.
+class Tracker
+{
+  public:
+    // the region of RESIZED_SIZE to search in the frame captured at
+    // capture_micros, empty to search all of it
+    cv::Rect predict(int64_t capture_micros);
+
+    // the targets found in a frame, found empty on a miss
+    void update(int64_t capture_micros, const cv::Rect &found);
+
+  private:
+    struct Sighting {
+        int64_t micros;
+        cv::Rect box;
+    };
+
+    std::mutex mutex_;
+    Sighting last_{0, cv::Rect()};
+    Sighting previous_{0, cv::Rect()};
+};
+
+// detect() over frame.roi, thresholded by threshold(). If that found nothing
+// or the targets reach the roi's edge, frame.roi is cleared and the whole
+// frame thresholded and searched, with fell_back set. Updates the tracker
+// with the outcome either way.
+void detect_tracked(Frame &frame, const Params &params, const Lens &lens, DetectScratch &scratch, ThresholdScratch &threshold_scratch,
+                    Tracker &tracker);
+
+// How many frames were served from a roi alone, and the search time
+// (threshold and detect) that saved against searching every frame in full
+struct TrackStats {
+    uint64_t roi_frames = 0;
+    int64_t roi_micros = 0;
+    uint64_t full_frames = 0; // searched in full from the start
+    int64_t full_micros = 0;
+    uint64_t fallbacks = 0; // roi missed then searched in full
+    int64_t fallback_micros = 0;
+
+    void add(const Frame &frame, int64_t search_micros);
+    // one line, for the pipeline reports
+    void report(std::ostream &out) const;
+};
+
+} // namespace vision
+} // namespace c2019
+} // namespace team114
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+// the vision tests' assertion, exits so a failure fails the run
+
+inline void check(bool ok, const char *what)
+{
+    if (!ok) {
+        std::cerr << "failed: " << what << std::endl;
+        std::exit(1);
+    }
+}
@@ -0,0 +1,110 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+
+#include "check.hpp"
+#include "hsv_threshold.hpp"
+
+using namespace cv;
+using namespace std;
+using namespace team114::c2019::vision;
+
+// checks the fused kernel gives exactly the mask of GaussianBlur, cvtColor and
+// inRange, then times both at the pipeline's size and the camera's
+
+static const HsvRange RANGES[] = {
+    {54, 77, 137, 255, 0, 89}, // the tape defaults
+    {0, 180, 0, 255, 0, 255},  // everything
+    {0, 0, 0, 0, 0, 0},        // black and pure red
+    {170, 179, 0, 255, 100, 255},
+    {10, 20, 30, 40, 50, 60},
+    {90, 30, 0, 255, 0, 255}, // empty
+};
+
+static void opencv_threshold(const Mat &src, Mat &mask, const HsvRange &range, bool blur, Mat &blurred, Mat &hsv)
+{
+    if (blur) {
+        GaussianBlur(src, blurred, Size(3, 3), 0, 0);
+    } else {
+        blurred = src;
+    }
+    cvtColor(blurred, hsv, CV_RGB2HSV);
+    inRange(hsv, Scalar(range.hlow, range.slow, range.vlow), Scalar(range.hhigh, range.shigh, range.vhigh), mask);
+}
+
+static bool same(const Mat &a, const Mat &b) { return a.size() == b.size() && a.type() == b.type() && countNonZero(a != b) == 0; }
+
+static void exactness()
+{
+    HsvScratch scratch;
+    Mat blurred, hsv, expected, mask;
+
+    // every 24 bit color once, unblurred so each pixel is converted as is
+    Mat all(4096, 4096, CV_8UC3);
+    for (int i = 0; i < all.rows * all.cols; ++i) {
+        all.at<Vec3b>(i / all.cols, i % all.cols) = Vec3b(i & 0xff, (i >> 8) & 0xff, i >> 16);
+    }
+    for (const HsvRange &range : RANGES) {
+        opencv_threshold(all, expected, range, false, blurred, hsv);
+        hsv_threshold(all, mask, range, false, scratch);
+        check(same(expected, mask), "every color matches cvtColor and inRange");
+    }
+
+    // odd sizes for the vector tails and blur edges, and a view into a wider
+    // image so rows are not contiguous. OpenCV's blur would read past the
+    // edges of a view, so it gets a copy.
+    RNG rng(114);
+    for (int i = 0; i < 50; ++i) {
+        Mat img(2 + rng.uniform(0, 100), 2 + rng.uniform(0, 100), CV_8UC3);
+        rng.fill(img, RNG::UNIFORM, 0, 256);
+        Mat view = i % 2 ? img(Rect(0, 0, max(2, img.cols - 1), img.rows)) : img;
+        Mat copy = view.clone();
+        for (const HsvRange &range : RANGES) {
+            for (bool blur : {false, true}) {
+                opencv_threshold(copy, expected, range, blur, blurred, hsv);
+                hsv_threshold(view, mask, range, blur, scratch);
+                check(same(expected, mask), blur ? "random image matches with blur" : "random image matches");
+            }
+        }
+    }
+    cout << "fused mask matches OpenCV bit for bit" << endl;
+}
+
+template <typename F> static double millis_per_frame(F f)
+{
+    const int FRAMES = 500;
+    f();
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < FRAMES; ++i) {
+        f();
+    }
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / FRAMES;
+}
+
+static void bench(Size size)
+{
+    // a smooth image like a camera's, not noise
+    Mat img(size, CV_8UC3);
+    RNG rng(254);
+    rng.fill(img, RNG::UNIFORM, 0, 256);
+    GaussianBlur(img, img, Size(9, 9), 0, 0);
+
+    HsvScratch scratch;
+    Mat blurred, hsv, mask;
+    const HsvRange &range = RANGES[0];
+    double opencv = millis_per_frame([&] { opencv_threshold(img, mask, range, true, blurred, hsv); });
+    double fused = millis_per_frame([&] { hsv_threshold(img, mask, range, true, scratch); });
+    cout << fixed << setprecision(3) << size.width << "x" << size.height << ": opencv " << opencv << " ms, fused " << fused << " ms, "
+         << setprecision(1) << opencv / fused << "x" << endl;
+}
+
+int main()
+{
+    cout << "kernel: " << hsv_threshold_isa() << endl;
+    exactness();
+    bench(Size(320, 240));
+    bench(Size(640, 480));
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "check.hpp"
+#include "lens.hpp"
+
+using namespace cv;
+using namespace std;
+using namespace team114::c2019::vision;
+
+// checks Lens against the repository's calibration: points the lens distorts
+// come back where they started, at the processed size
+//
+//     c2019-vision-lens-test [calibration.xml]
+
+// as detect.hpp's RESIZED_SIZE, without pulling in the pipeline
+static const Size RESIZED_SIZE(320, 240);
+
+int main(int argc, char **argv)
+{
+    string path = argc > 1 ? argv[1] : "cam-calibration/2018042100000030_1.xml";
+    Lens lens;
+    check(!lens.load("/nonexistent.xml", RESIZED_SIZE) && !lens.calibrated(), "missing file");
+    vector<Point2f> points{Point2f(10, 20)}, out;
+    lens.undistort(points, out);
+    check(out == points, "uncalibrated passes points through");
+    check(lens.load(path, RESIZED_SIZE) && lens.calibrated(), "loads the calibration");
+
+    // the matrix as load() scales it, to distort with
+    FileStorage fs(path, FileStorage::READ);
+    Mat camera, dist;
+    fs["cameraMatrix"] >> camera;
+    fs["dist_coeffs"] >> dist;
+    double s = RESIZED_SIZE.width / 640.0;
+    camera.at<double>(0, 0) *= s;
+    camera.at<double>(1, 1) *= s;
+    camera.at<double>(0, 2) = (camera.at<double>(0, 2) + 0.5) * s - 0.5;
+    camera.at<double>(1, 2) = (camera.at<double>(1, 2) + 0.5) * s - 0.5;
+
+    // ideal pixels over the middle of the frame, where this lens's
+    // distortion is still invertible
+    vector<Point2f> ideal;
+    vector<Point3f> rays;
+    for (float y = 40; y <= 200; y += 20) {
+        for (float x = 60; x <= 260; x += 20) {
+            ideal.push_back(Point2f(x, y));
+            rays.push_back(Point3f((x - camera.at<double>(0, 2)) / camera.at<double>(0, 0),
+                                   (y - camera.at<double>(1, 2)) / camera.at<double>(1, 1), 1));
+        }
+    }
+    vector<Point2f> distorted;
+    projectPoints(rays, Vec3d(0, 0, 0), Vec3d(0, 0, 0), camera, dist, distorted);
+    lens.undistort(distorted, out);
+    double worst = 0;
+    for (size_t i = 0; i < ideal.size(); ++i) {
+        worst = max(worst, norm(out[i] - ideal[i]));
+    }
+    cout << "worst round trip error " << worst << " px over " << ideal.size() << " points" << endl;
+    check(worst < 0.1, "undistort inverts the lens");
+
+    Mat img(RESIZED_SIZE, CV_8UC3, Scalar(0, 0, 0)), undistorted;
+    lens.undistort(img, undistorted);
+    check(undistorted.size() == RESIZED_SIZE, "image undistorts at the processed size");
+    return 0;
+}
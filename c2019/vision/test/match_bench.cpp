@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "match.hpp"
+
+using namespace std;
+using namespace team114::c2019::vision;
+
+// checks match_pairs pairs up exactly the strips the all pairs loop it
+// replaced did, then times both on scenes with dozens of strips
+
+// the loop from detect(), over rects as it had them
+struct Rect {
+    float x, y, width, angle;
+};
+
+static void all_pairs(const vector<Rect> &targets, int maxHorizontalDistanceFactor, vector<Match> &matched)
+{
+    const double PI = 3.1415926535897932384626433832795;
+    matched.clear();
+    for (uint32_t ia = 0; ia < targets.size(); ++ia) {
+        const Rect *a = &targets[ia];
+        for (uint32_t ib = ia + 1; ib < targets.size(); ++ib) {
+            const Rect *b = &targets[ib];
+            float avgwidth = (b->width + a->width) / 2.0;
+            if (abs(a->x - b->x) > avgwidth * (static_cast<float>(maxHorizontalDistanceFactor) / 100.0)) {
+                continue;
+            }
+            float ax = cos(a->angle * PI / 180.0);
+            float ay = sin(a->angle * PI / 180.0);
+            float bx = cos(b->angle * PI / 180.0);
+            float by = sin(b->angle * PI / 180.0);
+            float t = -(a->x * by - a->y * bx - b->x * by + b->y * bx) / (ax * by - ay * bx);
+            float centerX = a->x + ax * t;
+            float maxX = max(a->x, b->x);
+            float minX = min(a->x, b->x);
+            if (minX < centerX && centerX < maxX) {
+                if (a->x < centerX) {
+                    matched.push_back(Match{ia, ib, centerX});
+                } else {
+                    matched.push_back(Match{ib, ia, centerX});
+                }
+            }
+        }
+    }
+}
+
+// pairs leaning together as the tape does, after detect() turned them so
+// angle runs along the strip, and loose strips at any angle
+static vector<Rect> scene(mt19937 &rng, size_t strips)
+{
+    uniform_real_distribution<float> x(0, 320), y(20, 220), width(3, 12), lean(8, 20), any(-180, 0);
+    vector<Rect> rects;
+    while (rects.size() + 1 < strips) {
+        float cx = x(rng), cy = y(rng), w = width(rng), l = lean(rng);
+        rects.push_back(Rect{cx - 2 * w, cy, w, -90 + l});
+        rects.push_back(Rect{cx + 2 * w, cy, w, -90 - l});
+        if (rects.size() < strips) {
+            rects.push_back(Rect{x(rng), y(rng), width(rng), any(rng)});
+        }
+    }
+    shuffle(rects.begin(), rects.end(), rng);
+    return rects;
+}
+
+template <typename F> static double micros_per_call(F f)
+{
+    const int CALLS = 2000;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < CALLS; ++i) {
+        f();
+    }
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / CALLS;
+}
+
+int main()
+{
+    mt19937 rng(114);
+    Strips strips;
+    MatchScratch scratch;
+    vector<Match> expected, matched;
+
+    for (int round = 0; round < 2000; ++round) {
+        vector<Rect> rects = scene(rng, 1 + rng() % 64);
+        strips.clear();
+        for (const Rect &r : rects) {
+            strips.push(r.x, r.y, r.width, r.angle);
+        }
+        for (int factor : {0, 100, 550, 800}) {
+            all_pairs(rects, factor, expected);
+            match_pairs(strips, factor, scratch, matched);
+            check(expected.size() == matched.size(), "same number of pairs");
+            for (size_t i = 0; i < expected.size(); ++i) {
+                check(expected[i].left == matched[i].left && expected[i].right == matched[i].right, "same pairs in the same order");
+                check(expected[i].center_x == matched[i].center_x, "same crossing");
+            }
+        }
+    }
+    cout << "match_pairs agrees with the all pairs loop" << endl;
+
+    for (size_t n : {8, 24, 48, 96}) {
+        vector<Rect> rects = scene(rng, n);
+        strips.clear();
+        for (const Rect &r : rects) {
+            strips.push(r.x, r.y, r.width, r.angle);
+        }
+        double before = micros_per_call([&] { all_pairs(rects, 550, expected); });
+        double after = micros_per_call([&] { match_pairs(strips, 550, scratch, matched); });
+        cout << fixed << setprecision(2) << setw(3) << n << " strips, " << setw(3) << matched.size() << " pairs: all pairs " << setw(7)
+             << before << " us, sorted " << setw(6) << after << " us, " << setprecision(1) << before / after << "x" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include "check.hpp"
+#include "param_server.hpp"
+#include "params.hpp"
+
+using namespace std;
+using namespace team114::c2019::vision;
+
+// checks the registry's text formats and clamping, that readers never see a
+// half applied update, and the HTTP endpoint over loopback
+
+static void registry()
+{
+    ParamRegistry reg;
+    check(reg.get().hlow == Params{}.hlow, "starts at the defaults");
+    check(reg.set("hlow", 40) && reg.get().hlow == 40, "set");
+    check(reg.set("vhigh", 999) && reg.get().vhigh == 255, "clamped to max");
+    check(reg.set("slow", -5) && reg.get().slow == 0, "clamped to 0");
+    check(!reg.set("nope", 1), "unknown name");
+
+    string error;
+    check(reg.parse("# comment\n\nminTargetFullness 700\nhhigh 80\n", error), "parse");
+    check(reg.get().minTargetFullness == 700 && reg.get().hhigh == 80, "parsed values");
+    check(!reg.parse("hhigh eighty\n", error) && error == "hhigh eighty", "bad value names the line");
+    check(!reg.parse("hhigh 1 2\n", error), "trailing field");
+
+    ParamRegistry copy;
+    check(copy.parse(reg.format(), error), "format parses back");
+    check(copy.format() == reg.format(), "round trip");
+
+    char path[] = "/tmp/params_testXXXXXX";
+    int fd = mkstemp(path);
+    check(fd >= 0, "temp file");
+    close(fd);
+    check(reg.save(path), "save");
+    ParamRegistry loaded;
+    check(loaded.load(path) && loaded.format() == reg.format(), "load what was saved");
+    remove(path);
+    check(loaded.load(path), "a missing file is not an error");
+}
+
+static void no_torn_reads()
+{
+    // every field of each written Params is the same, a reader must never see
+    // a mix of two
+    auto uniform = [](int k) {
+        Params p;
+        for (const ParamInfo &info : PARAM_INFO) {
+            p.*info.field = k % 2; // every field takes 0 and 1
+        }
+        return p;
+    };
+    ParamRegistry reg;
+    reg.set_all(uniform(0));
+    atomic<bool> done(false);
+    thread writer([&] {
+        for (int k = 0; k < 200000; ++k) {
+            reg.set_all(uniform(k));
+        }
+        done = true;
+    });
+    uint64_t reads = 0;
+    while (!done || reads == 0) {
+        Params p = reg.get();
+        for (const ParamInfo &info : PARAM_INFO) {
+            check(p.*info.field == p.hlow, "consistent snapshot");
+        }
+        reads++;
+    }
+    writer.join();
+    cout << reads << " consistent snapshots during 200000 updates" << endl;
+}
+
+static string http_get(int port, const string &target)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    check(connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0, "connect");
+    string request = "GET " + target + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    check(send(fd, request.data(), request.size(), 0) == static_cast<ssize_t>(request.size()), "send request");
+    string response;
+    char buf[1024];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        response.append(buf, static_cast<size_t>(n));
+    }
+    close(fd);
+    return response;
+}
+
+static void server()
+{
+    const int port = 15807;
+    string path = "/tmp/params_test_server.txt";
+    remove(path.c_str());
+    ParamRegistry reg;
+    ParamServer server(reg, port, path);
+    check(server.ok(), "listening");
+
+    string r = http_get(port, "/params");
+    check(r.compare(0, 15, "HTTP/1.1 200 OK") == 0, "get ok");
+    check(r.find("hlow 54\n") != string::npos, "lists values");
+
+    r = http_get(port, "/params?hlow=50&vhigh=95");
+    check(r.find("hlow 50\n") != string::npos && r.find("vhigh 95\n") != string::npos, "set answers new values");
+    check(reg.get().hlow == 50 && reg.get().vhigh == 95, "set reaches the registry");
+    ParamRegistry saved;
+    check(saved.load(path) && saved.get().hlow == 50, "set is saved");
+
+    check(http_get(port, "/params?bogus=1").compare(0, 12, "HTTP/1.1 400") == 0, "unknown name");
+    check(http_get(port, "/params?hlow=x").compare(0, 12, "HTTP/1.1 400") == 0, "bad value");
+    check(http_get(port, "/other").compare(0, 12, "HTTP/1.1 404") == 0, "other paths");
+    check(reg.get().hlow == 50, "failed sets change nothing");
+    remove(path.c_str());
+}
+
+int main()
+{
+    registry();
+    no_torn_reads();
+    server();
+    cout << "params ok" << endl;
+    return 0;
+}
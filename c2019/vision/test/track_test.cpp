@@ -0,0 +1,92 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+
+#include "check.hpp"
+#include "detect.hpp"
+#include "track.hpp"
+
+using namespace cv;
+using namespace std;
+using namespace team114::c2019::vision;
+
+// runs a pair of tape strips across the frame, vanishing for a few frames,
+// and checks tracking finds what a full search of every frame finds
+
+// dark green under the default thresholds, channel 0 read as red
+static const Scalar TAPE(10, 80, 40);
+
+static void draw_strip(Mat &img, Point2f center, float angle)
+{
+    Point2f corners[4];
+    RotatedRect(center, Size2f(8, 30), angle).points(corners);
+    Point points[4];
+    for (int i = 0; i < 4; ++i) {
+        points[i] = corners[i];
+    }
+    fillConvexPoly(img, points, 4, TAPE);
+}
+
+int main()
+{
+    const int FRAMES = 90;
+    Params params;
+    Lens lens; // uncalibrated, points as found
+    Tracker tracker;
+    TrackStats stats;
+    Frame full, tracked;
+    ThresholdScratch full_threshold, tracked_threshold;
+    DetectScratch full_detect, tracked_detect;
+
+    for (int i = 0; i < FRAMES; ++i) {
+        Mat img(RESIZED_SIZE, CV_8UC3, Scalar(0, 0, 0));
+        bool visible = i < 40 || i >= 45;
+        Point2f center(60 + 2.5f * i, 120 + 20 * sin(i / 10.0f));
+        if (visible) {
+            draw_strip(img, center - Point2f(16, 0), 15);
+            draw_strip(img, center + Point2f(16, 0), -15);
+        }
+        int64_t micros = i * 33333;
+
+        img.copyTo(full.raw);
+        full.capture_micros = micros;
+        full.roi = Rect();
+        threshold(full, params, full_threshold);
+        detect(full, params, lens, full_detect);
+        check(full.packets.size() == (visible ? 1u : 0u), "the full search finds the pair when it is there");
+
+        img.copyTo(tracked.raw);
+        tracked.capture_micros = micros;
+        tracked.roi = tracker.predict(micros);
+        int64_t start = static_cast<int64_t>(getTickCount() * 1e6 / getTickFrequency());
+        threshold(tracked, params, tracked_threshold);
+        detect_tracked(tracked, params, lens, tracked_detect, tracked_threshold, tracker);
+        stats.add(tracked, static_cast<int64_t>(getTickCount() * 1e6 / getTickFrequency()) - start);
+
+        check(tracked.packets.size() == full.packets.size(), "tracking finds what the full search does");
+        for (size_t p = 0; p < full.packets.size(); ++p) {
+            check(abs(tracked.packets[p].x - full.packets[p].x) <= 1 && abs(tracked.packets[p].y - full.packets[p].y) <= 1,
+                  "at the same place");
+        }
+        if (i == 0 || i == 45) {
+            check(tracked.roi.area() == 0 && !tracked.fell_back, "nothing to track from, full search");
+        }
+        if (i == 40) {
+            check(tracked.fell_back, "a miss searches the whole frame");
+        }
+    }
+
+    stats.report(cout);
+    cout << endl;
+    check(stats.roi_frames >= FRAMES - 10, "most frames served from the roi");
+    check(stats.fallbacks <= 2, "falls back only when the target vanishes");
+
+    // running off the right edge at 20 px a frame, two frames on the box's
+    // center is predicted 31 px past the edge, leaving a 1 px sliver in frame
+    Tracker leaving;
+    leaving.update(0, Rect(RESIZED_SIZE.width - 40, 100, 20, 30));
+    leaving.update(33333, Rect(RESIZED_SIZE.width - 20, 100, 20, 30));
+    check(leaving.predict(33333 + 68333).area() == 0, "extrapolated off the frame, full search");
+    return 0;
+}
@@ -50,6 +50,8 @@ sudo apt install build-essential cmake g++
 # cd $VISION_DIR
 # cp bin/del-mar-cams /home/nvidia/
 cp dmargstream /home/nvidia/
+# the lens calibration the vision programs load, see src/config.hpp
+cp cam-calibration/2018042100000030_1.xml /home/nvidia/
 # set +e
 # sudo systemctl start del-mar-cams
 # set -e
@@ -38,6 +38,11 @@ const RobotConfig MakeDefaultRobotConfig() {
     c.drive.orient_kd = 0.0;
     c.drive.orient_vel = 0.0;
     c.drive.orient_acc = 0.0;
+    // rio-benches measured ~13us thread to thread latency at this priority,
+    // pinned, the RIO has two cores
+    c.drive.control_thread = false;
+    c.drive.control_thread_priority = 50;
+    c.drive.control_thread_cpu = 1;
 
     c.ctrl_panel.talon_id = 31;
     c.ctrl_panel.current_limit = 22;
@@ -24,6 +24,9 @@ struct DriveConfig {
     double orient_kd;
     double orient_vel;
     double orient_acc;
+    bool control_thread; /**< run Drive on its own real time thread instead of the Scheduler **/
+    int control_thread_priority; /**< SCHED_FIFO priority of that thread, 1-99 **/
+    int control_thread_cpu; /**< core to pin that thread to, -1 to not pin **/
 };
 
 struct ControlPanelConfig {
@@ -1,8 +1,13 @@
 #include "robot.h"
 
+#include <frc/Threads.h>
+#include <frc2/Timer.h>
 #include <units/units.h>
 
+#include <chrono>
 #include <iostream>
+#include <mutex>
+#include <string>
 
 namespace team114 {
 namespace c2020 {
@@ -11,7 +16,7 @@ namespace c2020 {
  * Instentiates structs for future use.
 **/
 Robot::Robot()
-    : frc::TimedRobot{Robot::kPeriod},
+    : frc::TimedRobot{},
       controls_{},
       drive_{Drive::GetInstance()},
       climber_{Climber::GetInstance()},
@@ -21,18 +26,77 @@ Robot::Robot()
       control_panel_{ControlPanel::GetInstance()},
       limelight_{Limelight::GetInstance()},
       robot_state_{RobotState::GetInstance()},
+      // vision and odometry first, then BallPath ahead of the Hood and
+      // Intake it commands
+      subsystems_{&limelight_, &drive_,   &ball_path_,    &hood_,
+                  &intake_,    &climber_, &control_panel_},
+      scheduler_{Robot::kSchedulerPeriod},
       ljoy_{0},
       rjoy_{1},
       ojoy_{2},
       auto_selector_{auton::AutoModeSelector::GetInstance()},
       auto_executor_{std::make_unique<auton::EmptyAction>()},
-      cfg{conf::GetConfig()} {}
+      cfg{conf::GetConfig()} {
+    for (size_t i = 0; i < subsystems_.size(); i++) {
+        alloc_keys_[i] = std::string{"Allocs/"} + subsystems_[i]->Name();
+        alloc_bytes_keys_[i] =
+            std::string{"AllocBytes/"} + subsystems_[i]->Name();
+    }
+    for (Subsystem* subsystem : subsystems_) {
+        if (subsystem == &drive_ && cfg.drive.control_thread) {
+            // runs itself, started in RobotInit
+            continue;
+        }
+        scheduler_.Register(*subsystem);
+    }
+}
+
+Robot::~Robot() {
+    scheduler_run_ = false;
+    if (scheduler_thread_.joinable()) {
+        scheduler_thread_.join();
+    }
+}
 
 /**
- * Nothing.
+ * Sets up the auto shot map, and starts the scheduler thread and the drive's control thread if configured.
 **/
 void Robot::RobotInit() {
     auto_shoot_init(); //set up the data in a map
+    if (cfg.drive.control_thread) {
+        drive_.StartControlThread();
+    }
+    scheduler_run_ = true;
+    scheduler_thread_ = std::thread{&Robot::SchedulerThreadMain, this};
+}
+
+/**
+ * Body of the scheduler thread. Makes itself SCHED_FIFO, then ticks the Scheduler every kSchedulerPeriod on a fixed grid of
+ * absolute deadlines, so the fast subsystems aren't held to the 20 ms of the mode callbacks. A tick that overruns skips the
+ * deadlines it missed.
+**/
+void Robot::SchedulerThreadMain() {
+    if (!frc::SetCurrentThreadPriority(true, kSchedulerThreadPriority)) {
+        std::cout << "Robot: could not make scheduler thread real time"
+                  << std::endl;
+    }
+    using Clock = std::chrono::steady_clock;
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>{kSchedulerPeriod.to<double>()});
+    auto deadline = Clock::now();
+    while (scheduler_run_.load(std::memory_order_relaxed)) {
+        {
+            std::lock_guard<wpi::mutex> lock{subsystems_mutex_};
+            AllocScope allocs;
+            scheduler_.Tick(frc2::Timer::GetFPGATimestamp(), CurrentRunMode());
+            loop_allocs_.Add(allocs.Get());
+        }
+        auto now = Clock::now();
+        do {
+            deadline += period;
+        } while (deadline <= now);
+        std::this_thread::sleep_until(deadline);
+    }
 }
 
 
@@ -40,6 +104,7 @@ void Robot::RobotInit() {
  * Calls period function of select classes. Possibly unfinished?
 **/
 void Robot::RobotPeriodic() {
+    AllocScope allocs;
 
     // c.shooter.slave_id = 26;
   /*  READING_SDB_NUMERIC(double, slave_shooter) slave_shooter;
@@ -93,12 +158,13 @@ void Robot::RobotPeriodic() {
     READING_SDB_NUMERIC(double, kicker)  kicker;
     can::TalonSRX* kt = new TalonSRX(51); 
     kt->Set(ControlMode::PercentOutput, kicker);
-*/
+
     // c.ball_channel.serializer_id = 43;
+    // (owned by BallPath, don't make a new talon every loop)
     READING_SDB_NUMERIC(double, serializer)  serializer;
     can::TalonSRX* st = new TalonSRX(43); 
     st->Set(ControlMode::PercentOutput, serializer);
-/*
+
     //c.ball_channel.channel_id = 44;
     READING_SDB_NUMERIC(double, channel)  channel;
     can::TalonSRX* ct = new TalonSRX(44); 
@@ -120,13 +186,10 @@ void Robot::RobotPeriodic() {
     */
 
 
-    drive_.Periodic();
-    ball_path_.Periodic();
-    climber_.Periodic();
-    control_panel_.Periodic();
-    limelight_.Periodic();
-
-    limelight_.SetLedMode(Limelight::LedMode::ON);
+    {
+        std::lock_guard<wpi::mutex> lock{subsystems_mutex_};
+        limelight_.SetLedMode(Limelight::LedMode::ON);
+    }
     // auto dist = robot_state_.GetLatestDistanceToOuterPort();
     // auto ang = robot_state_.GetLatestAngleToOuterPort();
 
@@ -136,14 +199,62 @@ void Robot::RobotPeriodic() {
     // } else {
     //     std::cout << "no target" << std::endl;
     // }
+
+    // RobotPeriodic runs after the mode's periodic, so this closes the loop
+    loop_allocs_.Add(allocs.Get());
+    OutputAllocTelemetry();
+    // after closing the loop so publishing isn't counted against it, and
+    // without the lock, OutputTelemetry() only publishes what the phases
+    // handed over
+    for (Subsystem* subsystem : subsystems_) {
+        subsystem->RunOutputTelemetry();
+    }
 }
 
 /**
- * Zeroing sensors, selecting auto mode.
+ * The mode bit subsystems are scheduled against
+**/
+RunModes Robot::CurrentRunMode() {
+    if (IsDisabled()) {
+        return kRunDisabled;
+    }
+    if (IsAutonomous()) {
+        return kRunAutonomous;
+    }
+    if (IsTest()) {
+        return kRunTest;
+    }
+    return kRunTeleop;
+}
+
+/**
+ * Publishes the loop's allocation counts, overall and per subsystem, then
+ * resets them. Does nothing unless built with C2020_COUNT_ALLOCS.
+**/
+void Robot::OutputAllocTelemetry() {
+    if constexpr (!kAllocCountingEnabled) {
+        return;
+    }
+    AllocCount loop = loop_allocs_.Take();
+    frc::SmartDashboard::PutNumber("Allocs/Loop", loop.allocs);
+    frc::SmartDashboard::PutNumber("AllocBytes/Loop", loop.bytes);
+    if (loop.allocs > 0) {
+        loops_with_allocs_++;
+    }
+    for (size_t i = 0; i < subsystems_.size(); i++) {
+        AllocCount count = subsystems_[i]->TakePeriodicAllocs();
+        frc::SmartDashboard::PutNumber(alloc_keys_[i], count.allocs);
+        frc::SmartDashboard::PutNumber(alloc_bytes_keys_[i], count.bytes);
+    }
+}
+
+/**
+ * Zeroing sensors, selecting auto mode. The drive waits out the navx calibration without the lock.
 **/
 void Robot::AutonomousInit() {
     drive_.ZeroSensors();
     auto mode = auto_selector_.GetSelectedAction();  // heh
+    std::lock_guard<wpi::mutex> lock{subsystems_mutex_};
     auto_executor_ = auton::AutoExecutor{std::move(mode)};
     hood_.SetWantPosition(40);
 }
@@ -152,41 +263,44 @@ void Robot::AutonomousInit() {
  * Calls periodic function of select structs.
 **/
 void Robot::AutonomousPeriodic() {
+    AllocScope allocs;
    // auto_executor_.Periodic(); //i don't know what this is... it looks like Josh wrote a whole method of making auto actions, but this is quick for now
-    hood_.Periodic();
-    intake_.Periodic();
- 
-    ball_path_.Periodic();
-
     drive_.BackUp(9); //9 inches    
-    ball_path_.ShortShot();
-    ball_path_.SetWantState(BallPath::State::Shoot);
+    {
+        std::lock_guard<wpi::mutex> lock{subsystems_mutex_};
+        ball_path_.ShortShot();
+        ball_path_.SetWantState(BallPath::State::Shoot);
+    }
+    loop_allocs_.Add(allocs.Get());
 }
 
 /**
  * Finishes initialition (stows hood?).
 **/
-void Robot::TeleopInit() { hood_.SetWantStow(); }
+void Robot::TeleopInit() {
+    std::lock_guard<wpi::mutex> lock{subsystems_mutex_};
+    hood_.SetWantStow();
+}
                                     
 /**
  * Calls remaining periodic funtions. Checks if robot is shooting, climbing or doing the control panel and calls functions accordingly.
+ * Everything but the setters runs without the lock: the drive takes its wants over a mailbox, and the dashboard and network
+ * table reads are done up front.
 **/
 void Robot::TeleopPeriodic() {
-    hood_.Periodic();
-    intake_.Periodic();
+    AllocScope allocs;
 
-    if (!controls_.Shoot()) {
+    const bool shoot = controls_.Shoot();
+    if (!shoot) {
         drive_.SetWantCheesyDrive(controls_.Throttle(), controls_.Wheel(),
                                   controls_.QuickTurn());
     }
 
     bool climb_up = controls_.ClimbUp();
     bool climb_down = controls_.ClimbDown();
-    if (climb_up == climb_down) {
-        climber_.SetWantDirection(Climber::Direction::Neutral);
-    } else {
-        climber_.SetWantDirection(climb_up ? Climber::Direction::Up
-                                           : Climber::Direction::Down);
+    Climber::Direction climb = Climber::Direction::Neutral;
+    if (climb_up != climb_down) {
+        climb = climb_up ? Climber::Direction::Up : Climber::Direction::Down;
     }
 
     // since these are manually edge-detected we need to invoke them
@@ -208,45 +322,55 @@ void Robot::TeleopPeriodic() {
 
     controls_.OPrints();
 
-    if (controls_.Shoot()) { 
+    std::optional<BallPath::Shot> shot;
+    BallPath::State ball_path_state = BallPath::State::Idle;
+    if (shoot) { 
         drive_.SetWantOrientForShot(limelight_, Kp, Ki, Kd);
-        ball_path_.SetShot();
-        ball_path_.SetWantState(BallPath::State::Shoot);
+        shot = ball_path_.ShotFromVision();
+        ball_path_state = BallPath::State::Shoot;
     } else if (controls_.ShortShot()) {
         ///drive_.SetWantOrientForShot(limelight_, Kp, Ki, Kd);
         drive_.BackUp(9); //9 inches    
-        ball_path_.ShortShot();
-        ball_path_.SetWantState(BallPath::State::Shoot);
+        shot = BallPath::kShortShot;
+        ball_path_state = BallPath::State::Shoot;
     } else if (controls_.LongShot()) {
         drive_.SetWantOrientForShot(limelight_, Kp, Ki, Kd);
-        ball_path_.LongShot();
-        ball_path_.SetWantState(BallPath::State::Shoot);
+        shot = BallPath::kLongShot;
+        ball_path_state = BallPath::State::Shoot;
     } else if (controls_.Unjam()) { 
-        ball_path_.SetWantState(BallPath::State::Unjm);
+        ball_path_state = BallPath::State::Unjm;
     } else if (controls_.Intake()) {
-        ball_path_.SetWantState(BallPath::State::Intk);
-    } else {
-        ball_path_.SetWantState(BallPath::State::Idle);
+        ball_path_state = BallPath::State::Intk;
     }
 
-    control_panel_.SetDeployed(controls_.PanelDeploy());
-    if (controls_.PosControlRedPressed()) {
-        control_panel_.DoPositionControl(ControlPanel::ObservedColor::Red);
-    } else if (controls_.PosControlBluePressed()) {
-        control_panel_.DoPositionControl(ControlPanel::ObservedColor::Blue);
-    } else if (controls_.PosControlGreenPressed()) {
-        control_panel_.DoPositionControl(ControlPanel::ObservedColor::Green);
-    } else if (controls_.PosControlYellowPressed()) {
-        control_panel_.DoPositionControl(ControlPanel::ObservedColor::Yellow);
-    } else if (controls_.RotControlPressed()) {
-        control_panel_.DoRotationControl();
-    } else if (controls_.ScootRightPressed()) {
-        control_panel_.Scoot(ControlPanel::ScootDir::Forward);
-    } else if (controls_.ScootLeftPressed()) {
-        control_panel_.Scoot(ControlPanel::ScootDir::Reverse);
-    } else if (controls_.ScootReleased()) {
-        control_panel_.Scoot(ControlPanel::ScootDir::Neutral);
+    {
+        std::lock_guard<wpi::mutex> lock{subsystems_mutex_};
+        climber_.SetWantDirection(climb);
+        if (shot.has_value()) {
+            ball_path_.SetWantShot(*shot);
+        }
+        ball_path_.SetWantState(ball_path_state);
+
+        control_panel_.SetDeployed(controls_.PanelDeploy());
+        if (controls_.PosControlRedPressed()) {
+            control_panel_.DoPositionControl(ControlPanel::ObservedColor::Red);
+        } else if (controls_.PosControlBluePressed()) {
+            control_panel_.DoPositionControl(ControlPanel::ObservedColor::Blue);
+        } else if (controls_.PosControlGreenPressed()) {
+            control_panel_.DoPositionControl(ControlPanel::ObservedColor::Green);
+        } else if (controls_.PosControlYellowPressed()) {
+            control_panel_.DoPositionControl(ControlPanel::ObservedColor::Yellow);
+        } else if (controls_.RotControlPressed()) {
+            control_panel_.DoRotationControl();
+        } else if (controls_.ScootRightPressed()) {
+            control_panel_.Scoot(ControlPanel::ScootDir::Forward);
+        } else if (controls_.ScootLeftPressed()) {
+            control_panel_.Scoot(ControlPanel::ScootDir::Reverse);
+        } else if (controls_.ScootReleased()) {
+            control_panel_.Scoot(ControlPanel::ScootDir::Neutral);
+        }
     }
+    loop_allocs_.Add(allocs.Get());
 }
 
 /**
@@ -258,29 +382,38 @@ void Robot::TestInit() {}
  * Simulates the climbing portion of periodic action. 
 **/
 void Robot::TestPeriodic() {
+    AllocScope allocs;
     bool climb_up = controls_.ClimbUp();
     bool climb_down = controls_.ClimbDown();
-    if (climb_up == climb_down) {
-        climber_.SetZeroingWind(Climber::Direction::Neutral);
-    } else {
-        climber_.SetZeroingWind(climb_up ? Climber::Direction::Up
-                                         : Climber::Direction::Down);
+    Climber::Direction wind = Climber::Direction::Neutral;
+    if (climb_up != climb_down) {
+        wind = climb_up ? Climber::Direction::Up : Climber::Direction::Down;
+    }
+    {
+        std::lock_guard<wpi::mutex> lock{subsystems_mutex_};
+        climber_.SetZeroingWind(wind);
     }
+    loop_allocs_.Add(allocs.Get());
 }
 
 /**
  * Resets a couple things (most zeroing happens in AutonomousInit()). 
 **/
 void Robot::DisabledInit() {
-    auto_executor_.Stop();
     drive_.SetWantRawOpenLoop({0.0_mps, 0.0_mps});
+    std::lock_guard<wpi::mutex> lock{subsystems_mutex_};
+    auto_executor_.Stop();
     climber_.SetWantDirection(Climber::Direction::Neutral);
 }
 
 /**
  * Updates auto selector.
 **/
-void Robot::DisabledPeriodic() { auto_selector_.UpdateSelection(); }
+void Robot::DisabledPeriodic() {
+    AllocScope allocs;
+    auto_selector_.UpdateSelection();
+    loop_allocs_.Add(allocs.Get());
+}
 
 }  // namespace c2020
 }  // namespace team114
@@ -3,13 +3,19 @@
 #include <frc/Joystick.h>
 #include <frc/TimedRobot.h>
 #include <units/units.h>
+#include <wpi/mutex.h>
 
+#include <array>
+#include <atomic>
 #include <optional>
+#include <string>
+#include <thread>
 
 #include "auto/executor.h"
 #include "auto/selector.h"
 #include "controls.h"
 #include "robot_state.h"
+#include "scheduler.h"
 #include "subsystems/ball_path.h"
 #include "subsystems/climber.h"
 #include "subsystems/control_panel.h"
@@ -17,7 +23,9 @@
 #include "subsystems/hood.h"
 #include "subsystems/intake.h"
 #include "subsystems/limelight.h"
+#include "util/alloc_counter.h"
 #include "util/constructor_macros.h"
+#include "util/sdb_types.h"
 
 namespace team114 {
 namespace c2020 {
@@ -25,8 +33,15 @@ namespace c2020 {
 class Robot : public frc::TimedRobot {
     DISALLOW_COPY_ASSIGN(Robot)
    public:
-    inline static const auto kPeriod = 10_ms;
+    // base tick of the Scheduler, so the rate of the fastest subsystem. The
+    // Scheduler ticks on a thread of its own, the mode callbacks stay at the
+    // TimedRobot default of 20 ms.
+    inline static const auto kSchedulerPeriod = 5_ms;
+    // SCHED_FIFO priority of the scheduler thread, below the drive's control
+    // thread (conf::DriveConfig) so a Scheduler tick never delays the drive
+    static constexpr int kSchedulerThreadPriority = 40;
     Robot();
+    ~Robot();
     void RobotInit() override;
     void RobotPeriodic() override;
 
@@ -43,6 +58,10 @@ class Robot : public frc::TimedRobot {
     void DisabledPeriodic() override;
 
    private:
+    RunModes CurrentRunMode();
+    void OutputAllocTelemetry();
+    void SchedulerThreadMain();
+
     Controls controls_;
     Drive& drive_;
     Climber& climber_;
@@ -52,6 +71,16 @@ class Robot : public frc::TimedRobot {
     ControlPanel& control_panel_;
     Limelight& limelight_;
     RobotState& robot_state_;
+    // in Scheduler run order
+    std::array<Subsystem*, 7> subsystems_;
+    Scheduler scheduler_;
+    // held by the scheduler thread for each tick, and by the main thread only
+    // while it calls the Scheduler's subsystems' setters. Drive takes its wants
+    // over a mailbox and needs no lock. A wpi::mutex for priority inheritance,
+    // so the main thread holding it runs at the scheduler thread's priority.
+    wpi::mutex subsystems_mutex_;
+    std::atomic<bool> scheduler_run_{false};
+    std::thread scheduler_thread_;
     frc::Joystick ljoy_;
     frc::Joystick rjoy_;
     frc::Joystick ojoy_;
@@ -59,6 +88,16 @@ class Robot : public frc::TimedRobot {
     auton::AutoExecutor auto_executor_;
     conf::RobotConfig cfg;
 
+    // added to by both threads
+    AllocAccumulator loop_allocs_{};
+    // per subsystem dashboard keys, by subsystems_ index, built once so
+    // publishing doesn't allocate
+    std::array<std::string, std::tuple_size_v<decltype(subsystems_)>>
+        alloc_keys_;
+    std::array<std::string, std::tuple_size_v<decltype(subsystems_)>>
+        alloc_bytes_keys_;
+    SDB_NUMERIC(unsigned int, LoopsWithAllocs) loops_with_allocs_{0};
+
     // CachingSolenoid brake_{frc::Solenoid{6}};
 };
 
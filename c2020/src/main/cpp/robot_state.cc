@@ -1,5 +1,8 @@
 #include "robot_state.h"
 
+#include <mutex>
+#include <stdexcept>
+
 #include <frc/geometry/Pose2d.h>
 
 namespace team114 {
@@ -25,6 +28,7 @@ RobotState::RobotState(conf::RobotConfig cfg)
  * @returns latest field to robot/position value
  */
 std::pair<units::second_t, frc::Pose2d> RobotState::GetLatestFieldToRobot() {
+    std::lock_guard<wpi::mutex> lock{field_to_robot_mutex_};
     return field_to_robot_.Latest();
 }
 
@@ -33,22 +37,41 @@ std::pair<units::second_t, frc::Pose2d> RobotState::GetLatestFieldToRobot() {
  * @returns field to robot/position and a given timestamp
  */
 frc::Pose2d RobotState::GetFieldToRobot(units::second_t timestamp) {
+    std::lock_guard<wpi::mutex> lock{field_to_robot_mutex_};
     return field_to_robot_.InterpAt(timestamp).second;
 }
 
+/**
+ * gets the field position of the robot at each of a sorted list of timestamps,
+ * walking the pose history once rather than searching it per timestamp
+ */
+void RobotState::GetFieldToRobot(wpi::ArrayRef<units::second_t> timestamps,
+                                 wpi::MutableArrayRef<frc::Pose2d> out) {
+    if (out.size() < timestamps.size()) {
+        throw std::out_of_range{"pose output shorter than timestamps"};
+    }
+    std::lock_guard<wpi::mutex> lock{field_to_robot_mutex_};
+    field_to_robot_.InterpAt(timestamps.begin(), timestamps.end(),
+                             out.begin());
+}
+
 /**
  * Reads the stance/position of the robot at a given time and sets it to an
  * array(timeline like?)
  */
 void RobotState::ObserveFieldToRobot(units::second_t timestamp,
                                      const frc::Pose2d& pose) {
+    std::lock_guard<wpi::mutex> lock{field_to_robot_mutex_};
     field_to_robot_[timestamp] = pose;
 }
 
 /**
  * resets the robot's field positioning
  */
-void RobotState::ResetFieldToRobot() { field_to_robot_.Inner().clear(); }
+void RobotState::ResetFieldToRobot() {
+    std::lock_guard<wpi::mutex> lock{field_to_robot_mutex_};
+    field_to_robot_.Clear();
+}
 
 /**
  * Checks the robot's vision, resets if it can't find the target too many times
@@ -3,6 +3,8 @@
 #include <utility>
 
 #include <frc/geometry/Pose2d.h>
+#include <wpi/ArrayRef.h>
+#include <wpi/mutex.h>
 
 #include "config.h"
 #include "subsystem.h"
@@ -15,6 +17,8 @@ namespace c2020 {
 
 // Saying frame1_to_frame2 represents the transform applied to the frame1 origin
 // that will bring it to the frame2 origin.
+// The field to robot history may be observed and read from different threads
+// (see Drive's control thread), the vision state is main thread only.
 class RobotState {
     DISALLOW_COPY_ASSIGN(RobotState)
     CREATE_SINGLETON(RobotState)
@@ -24,10 +28,14 @@ class RobotState {
 
     std::pair<units::second_t, frc::Pose2d> GetLatestFieldToRobot();
     frc::Pose2d GetFieldToRobot(units::second_t);
+    // timestamps should be sorted, out must be at least as long
+    void GetFieldToRobot(wpi::ArrayRef<units::second_t> timestamps,
+                         wpi::MutableArrayRef<frc::Pose2d> out);
     void ObserveFieldToRobot(units::second_t timestamp,
                              const frc::Pose2d& pose);
     void ResetFieldToRobot();
 
+    // timestamp is the capture time on the FPGA clock, for GetFieldToRobot
     void ObserveVision(units::second_t timestamp,
                        std::optional<Limelight::TargetInfo> target);
     std::optional<std::pair<units::second_t, units::meter_t>>
@@ -36,8 +44,11 @@ class RobotState {
     GetLatestAngleToOuterPort();
 
    private:
+    // lookups move the ring buffer's search hint, so reads lock too
+    wpi::mutex field_to_robot_mutex_;
     InterpolatingMap<units::second_t, frc::Pose2d,
-                     ArithmeticInverseInterp<units::second_t>, Pose2dInterp>
+                     ArithmeticInverseInterp<units::second_t>, Pose2dInterp,
+                     RingBufferStorage<units::second_t, frc::Pose2d>>
         field_to_robot_;
 
     const conf::LimelightConfig ll_cfg_;
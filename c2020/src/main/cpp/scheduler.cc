@@ -0,0 +1,72 @@
+#include "scheduler.h"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace team114 {
+namespace c2020 {
+
+Scheduler::Scheduler(units::second_t base_period)
+    : base_period_{base_period}, entries_{}, due_{}, epoch_{} {}
+
+/**
+ * Registers a subsystem at the rate and modes from its SUBSYSTEM_PRELUDE
+ */
+void Scheduler::Register(Subsystem& subsystem) {
+    Register(subsystem, subsystem.Schedule());
+}
+
+/**
+ * Registers a subsystem to be run every base_rate / rate ticks. Slower
+ * subsystems are staggered by registration index so they don't all land on
+ * the same tick.
+ */
+void Scheduler::Register(Subsystem& subsystem,
+                         const SubsystemSchedule& schedule) {
+    double ratio = (1.0 / (base_period_ * schedule.rate)).to<double>();
+    double divisor = std::round(ratio);
+    if (schedule.rate <= units::hertz_t{0.0} || divisor < 1.0 ||
+        std::abs(ratio - divisor) > 1e-6) {
+        throw std::invalid_argument{
+            "subsystem rate must evenly divide the scheduler base rate"};
+    }
+    auto div = static_cast<uint64_t>(divisor);
+    uint64_t offset = entries_.size() % div;
+    entries_.push_back({&subsystem, div, offset, schedule.modes, offset});
+    due_.reserve(entries_.size());
+}
+
+/**
+ * Runs the read, compute and write phases of every subsystem due this tick
+ */
+void Scheduler::Tick(units::second_t now, RunModes mode) {
+    if (!epoch_.has_value()) {
+        epoch_ = now;
+    }
+    // nearest tick, the notifier wakes us a little after each boundary
+    auto tick = static_cast<uint64_t>(
+        std::llround(((now - *epoch_) / base_period_).to<double>()));
+    due_.clear();
+    for (Entry& entry : entries_) {
+        if (tick < entry.next_tick) {
+            continue;
+        }
+        // the next tick on this entry's stagger strictly after this one,
+        // skipping any missed by an overrun
+        entry.next_tick = (tick - entry.offset) / entry.divisor * entry.divisor +
+                          entry.offset + entry.divisor;
+        if (entry.modes & mode) {
+            due_.push_back(entry.subsystem);
+        }
+    }
+    for (Subsystem::Phase phase : {Subsystem::Phase::Read,
+                                   Subsystem::Phase::Compute,
+                                   Subsystem::Phase::Write}) {
+        for (Subsystem* subsystem : due_) {
+            subsystem->RunPhase(phase);
+        }
+    }
+}
+
+}  // namespace c2020
+}  // namespace team114
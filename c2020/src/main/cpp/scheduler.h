@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <units/units.h>
+
+#include "subsystem.h"
+#include "util/constructor_macros.h"
+
+namespace team114 {
+namespace c2020 {
+
+// Runs subsystems at the rates they declare in SUBSYSTEM_PRELUDE, off a fixed
+// base tick. Each tick runs three phases, read, compute then write, and each
+// phase visits the subsystems due that tick in registration order. So all
+// sensor/CAN reads happen together before any compute, and outputs go out
+// together at the end. Due ticks are computed from the timestamp passed to
+// Tick() (the FPGA clock on the robot), so an overrun delays the next run of
+// a subsystem rather than queueing up extra runs.
+class Scheduler {
+    DISALLOW_COPY_ASSIGN(Scheduler)
+   public:
+    Scheduler(units::second_t base_period);
+
+    // Registration order is run order. Rates must evenly divide the base
+    // rate. Allocates, so register everything before the first Tick().
+    void Register(Subsystem& subsystem);
+    void Register(Subsystem& subsystem, const SubsystemSchedule& schedule);
+
+    // Call once per base period, mode is a single RunModes bit
+    void Tick(units::second_t now, RunModes mode);
+
+   private:
+    struct Entry {
+        Subsystem* subsystem;
+        uint64_t divisor;
+        uint64_t offset;
+        uint8_t modes;
+        uint64_t next_tick;
+    };
+
+    const units::second_t base_period_;
+    std::vector<Entry> entries_;
+    // subsystems due this tick, capacity reserved at registration
+    std::vector<Subsystem*> due_;
+    std::optional<units::second_t> epoch_;
+};
+
+}  // namespace c2020
+}  // namespace team114
@@ -1,10 +1,37 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+
+#include <units/units.h>
+
+#include "util/alloc_counter.h"
 #include "util/constructor_macros.h"
+#include "util/loop_profiler.h"
 
 namespace team114 {
 namespace c2020 {
 
+/**
+* Robot modes a subsystem is run in, as bits.
+**/
+enum RunModes : uint8_t {
+    kRunDisabled = 1 << 0,
+    kRunAutonomous = 1 << 1,
+    kRunTeleop = 1 << 2,
+    kRunTest = 1 << 3,
+    kRunEnabled = kRunAutonomous | kRunTeleop | kRunTest,
+    kRunAlways = kRunDisabled | kRunEnabled,
+};
+
+/**
+* How often, and in which modes, the Scheduler runs a subsystem.
+**/
+struct SubsystemSchedule {
+    units::hertz_t rate;
+    uint8_t modes;
+};
+
 class Subsystem {
    public:
    /**
@@ -13,10 +40,18 @@ class Subsystem {
     virtual ~Subsystem() = default;
 
     /**
-    * Called in Robot::TeleopPeriodic() if it makes sense (hood and intake yes, control panel(unfinished?) and climber no)
+    * Read phase, reads sensors and CAN status frames into member state. Every subsystem due in a tick reads before any computes.
+    **/
+    virtual void ReadPeriodicIn(){};
+    /**
+    * Compute phase, run by the Scheduler at the subsystem's Schedule() rate between the read and write phases
     **/
     virtual void Periodic(){};
     /**
+    * Write phase, sends the outputs computed this tick to motor controllers etc.
+    **/
+    virtual void WritePeriodicOut(){};
+    /**
     * Resets things (like setting motors back to initial position)
     **/
     virtual void Stop(){};
@@ -25,9 +60,94 @@ class Subsystem {
     **/
     virtual void ZeroSensors(){};
     /**
-    * Currently undefined in subclasses, but it could presumably be used to output general positional or sensory data.
+    * Currently undefined in subclasses, but it could presumably be used to output general positional or sensory data. Runs on the
+    * main thread while the phases may be running on another, so publish only what the phases hand over (see Drive's status mailbox).
     **/
     virtual void OutputTelemetry(){};
+    /**
+    * Name for telemetry, SUBSYSTEM_PRELUDE fills this in with the class name.
+    **/
+    virtual const char* Name() const { return "Subsystem"; }
+    /**
+    * Rate and modes to be run in, SUBSYSTEM_PRELUDE fills this in. Defaults to the 100 Hz everything ran at before the Scheduler.
+    **/
+    virtual SubsystemSchedule Schedule() const {
+        return {units::hertz_t{100.0}, kRunAlways};
+    }
+
+    enum class Phase {
+        Read,
+        Compute,
+        Write,
+    };
+    /**
+    * Calls one phase with instrumentation, timing is recorded per tick at the end of the write phase.
+    **/
+    void RunPhase(Phase phase) {
+        AllocScope allocs;
+        ProfilerClock::time_point start{};
+        if constexpr (kLoopProfilerEnabled) {
+            start = ProfilerClock::now();
+        }
+        switch (phase) {
+            case Phase::Read:
+                ReadPeriodicIn();
+                break;
+            case Phase::Compute:
+                Periodic();
+                break;
+            case Phase::Write:
+                WritePeriodicOut();
+                break;
+        }
+        if constexpr (kLoopProfilerEnabled) {
+            tick_elapsed_ += ProfilerClock::now() - start;
+            if (phase == Phase::Write) {
+                periodic_timing_.Record(tick_elapsed_);
+                tick_elapsed_ = {};
+            }
+        }
+        periodic_allocs_.Add(allocs.Get());
+    }
+    /**
+    * Runs all three phases, for use outside the Scheduler.
+    **/
+    void RunPeriodic() {
+        RunPhase(Phase::Read);
+        RunPhase(Phase::Compute);
+        RunPhase(Phase::Write);
+    }
+    /**
+    * Calls OutputTelemetry(), and publishes phase timing every kTimingPublishPeriod, see util/loop_profiler.h
+    **/
+    void RunOutputTelemetry() {
+        OutputTelemetry();
+        if constexpr (kLoopProfilerEnabled) {
+            auto now = ProfilerClock::now();
+            if (now - last_timing_publish_ >= kTimingPublishPeriod) {
+                last_timing_publish_ = now;
+                PublishLoopTiming(Name(), periodic_timing_.Summarize());
+            }
+        }
+    }
+    /**
+    * Rolling per tick timing of all three phases, safe to read from any thread.
+    **/
+    LoopTimingSummary PeriodicTiming() const {
+        return periodic_timing_.Summarize();
+    }
+    /**
+    * Allocations made by the phases since the last call, see util/alloc_counter.h. Safe to call while the phases run on another thread.
+    **/
+    AllocCount TakePeriodicAllocs() { return periodic_allocs_.Take(); }
+
+   private:
+    static constexpr auto kTimingPublishPeriod = std::chrono::milliseconds{500};
+
+    AllocAccumulator periodic_allocs_{};
+    LoopTimingStats periodic_timing_{};
+    ProfilerClock::duration tick_elapsed_{};
+    ProfilerClock::time_point last_timing_publish_{};
 };
 
 // static member is inline so as to be single across translation units
@@ -48,12 +168,18 @@ class Subsystem {
         __singleton_instance_ = nullptr;             \
     }
 
-#define SUBSYSTEM_PRELUDE(Classname)          \
-   private:                                   \
-    Classname();                              \
-    CREATE_SINGLETON(Classname)               \
-   public: /* better diagnostics if public */ \
-    DISALLOW_COPY_ASSIGN(Classname)
+// rate is a units::hertz_t, modes a RunModes mask
+#define SUBSYSTEM_PRELUDE(Classname, rate, modes)                              \
+   private:                                                                    \
+    Classname();                                                               \
+    CREATE_SINGLETON(Classname)                                                \
+   public: /* better diagnostics if public */                                  \
+    DISALLOW_COPY_ASSIGN(Classname)                                            \
+    const char* Name() const override { return #Classname; }                   \
+    static constexpr team114::c2020::SubsystemSchedule kSchedule{rate, modes}; \
+    team114::c2020::SubsystemSchedule Schedule() const override {              \
+        return kSchedule;                                                      \
+    }
 
 }  // namespace c2020
 }  // namespace team114
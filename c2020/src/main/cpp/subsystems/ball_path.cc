@@ -225,38 +225,35 @@ void BallPath::OutputTelemetry() {}
 **/
 void BallPath::SetWantState(BallPath::State s) { state_ = s; }
 /**
-* sets the current shot's flywheel speed and hood angle atributes to the appropriate angles using auto SHOOOOOOT
+* looks up the shot for the limelight's distance to the goal using auto SHOOOOOOT, empty if it doesn't see the goal
 **/
-void BallPath::SetShot() {
+std::optional<BallPath::Shot> BallPath::ShotFromVision() {
     std::tuple<double, double, double> temp = auto_shoot_calc(limelight_.GetNetworkTable()); 
     double dist = distance();
-    if (dist < 20) { //if the limelight actually sees the goal
-        std::cout << "distance in meters: " << dist << std::endl;
-       // std::cout << "" << std::endl;
-        current_shot_.flywheel_sp = std::get<1>(temp);
-        current_shot_.hood_angle = std::get<0>(temp);
-        current_shot_.kicker_cmd = std::get<2>(temp);
-     /*   READING_SDB_NUMERIC(double, FlyWheelSpeed) flywheel_speed;
-        READING_SDB_NUMERIC(double, HoodAngle) hood_angle;
-        READING_SDB_NUMERIC(double, KickerSpeed) kicker_cmd;
-        current_shot_.flywheel_sp = flywheel_speed;
-        current_shot_.hood_angle = hood_angle; 
-        current_shot_.kicker_cmd = kicker_cmd;*/
+    if (dist >= 20) { //if the limelight doesn't actually see the goal
+        return std::nullopt;
     }
-    
+    std::cout << "distance in meters: " << dist << std::endl;
+    Shot shot;
+    shot.flywheel_sp = std::get<1>(temp);
+    shot.hood_angle = std::get<0>(temp);
+    shot.kicker_cmd = std::get<2>(temp);
+ /*   READING_SDB_NUMERIC(double, FlyWheelSpeed) flywheel_speed;
+    READING_SDB_NUMERIC(double, HoodAngle) hood_angle;
+    READING_SDB_NUMERIC(double, KickerSpeed) kicker_cmd;
+    shot.flywheel_sp = flywheel_speed;
+    shot.hood_angle = hood_angle; 
+    shot.kicker_cmd = kicker_cmd;*/
+    return shot;
 }
+/**
+* sets the current shot's flywheel speed, hood angle and kicker command
+**/
+void BallPath::SetWantShot(Shot shot) { current_shot_ = shot; }
 
-void BallPath::ShortShot() {
-    current_shot_.flywheel_sp = 30000;
-    current_shot_.hood_angle = 63;
-    current_shot_.kicker_cmd = 0.7; 
-}
+void BallPath::ShortShot() { SetWantShot(kShortShot); }
 
-void BallPath::LongShot() {
-    current_shot_.flywheel_sp = 40000;
-    current_shot_.hood_angle = 20;
-    current_shot_.kicker_cmd = 0.97; 
-}
+void BallPath::LongShot() { SetWantShot(kLongShot); }
 
 /**
 * does nothing, presumable purpose to use camera info to update shot type
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <optional>
+
 #include <frc/DigitalInput.h>
 #include "shims/minimal_phoenix.h"
 
@@ -15,7 +17,7 @@ namespace team114 {
 namespace c2020 {
 
 class BallPath : public Subsystem {
-    SUBSYSTEM_PRELUDE(BallPath)
+    SUBSYSTEM_PRELUDE(BallPath, 100_Hz, kRunAlways)
    public:
     BallPath(const conf::RobotConfig& cfg);
 
@@ -36,7 +38,18 @@ class BallPath : public Subsystem {
         Med,
         Long,
     };
-    void SetShot();
+    struct Shot {
+        double hood_angle;
+        double flywheel_sp;
+        double kicker_cmd;
+    };
+    static constexpr Shot kShortShot{63, 30000, 0.7};
+    static constexpr Shot kLongShot{20, 40000, 0.97};
+    // Looks the shot up from the limelight's distance to the goal, without
+    // touching the subsystem, so it can be done outside the Robot's lock.
+    // Empty if the limelight doesn't see the goal.
+    std::optional<Shot> ShotFromVision();
+    void SetWantShot(Shot shot);
     void ShortShot();
     void LongShot();
 
@@ -48,12 +61,6 @@ class BallPath : public Subsystem {
     };
     void SetChannelDirection(Direction dir);
     void SetSerializerDirection(Direction dir);
-    struct Shot {
-        double hood_angle;
-        double flywheel_sp;
-        double kicker_cmd;
-    };
-    void SetWantShot(Shot shot);
     void UpdateShotFromVision();
     bool ReadyToShoot();
 
@@ -11,7 +11,7 @@ namespace team114 {
 namespace c2020 {
 
 class Climber : public Subsystem {
-    SUBSYSTEM_PRELUDE(Climber)
+    SUBSYSTEM_PRELUDE(Climber, 100_Hz, kRunAlways)
    public:
     Climber(const conf::ClimberConfig& cfg);
     void Periodic() override;
@@ -11,7 +11,7 @@ namespace team114 {
 namespace c2020 {
 
 class ControlPanel : public Subsystem {
-    SUBSYSTEM_PRELUDE(ControlPanel)
+    SUBSYSTEM_PRELUDE(ControlPanel, 20_Hz, kRunAlways)
    public:
     ControlPanel(const conf::ControlPanelConfig& cfg);
     void Periodic() override;
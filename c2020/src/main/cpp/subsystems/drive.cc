@@ -1,8 +1,17 @@
 #include "drive.h"
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
 #include <thread>
 
 #include <frc/SPI.h>
+#include <frc/Threads.h>
 #include <frc/kinematics/DifferentialDriveWheelSpeeds.h>
 #include <frc2/Timer.h>
 
@@ -60,8 +69,122 @@ Drive::Drive(const conf::DriveConfig& cfg)
     vision_rot_.SetTolerance(0.02_rad, 0.2_rad / 1.0_s);
 }
 
+Drive::~Drive() {
+    control_thread_run_ = false;
+    if (control_thread_.joinable()) {
+        control_thread_.join();
+    }
+}
+
+/**
+ * Starts running ReadPeriodicIn, Periodic and WritePeriodicOut on a thread of their own, so nothing else on the main thread
+ * (joystick processing, dashboard I/O, the other subsystems) can delay the drive loop. Drive must not also be registered with the Scheduler.
+**/
+void Drive::StartControlThread() {
+    if (control_thread_.joinable()) {
+        return;
+    }
+    control_thread_run_ = true;
+    control_thread_ = std::thread{&Drive::ControlThreadMain, this};
+}
+
+/**
+ * Body of the control thread. Makes itself SCHED_FIFO and pins itself to a core as configured, then runs the phases on a fixed
+ * grid of absolute deadlines. A tick that overruns skips the deadlines it missed instead of running back to back to catch up.
+**/
+void Drive::ControlThreadMain() {
+    if (!frc::SetCurrentThreadPriority(true, cfg_.control_thread_priority)) {
+        std::cout << "Drive: could not make control thread real time"
+                  << std::endl;
+    }
+#ifdef __linux__
+    if (cfg_.control_thread_cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cfg_.control_thread_cpu, &cpus);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+            std::cout << "Drive: could not pin control thread to cpu "
+                      << cfg_.control_thread_cpu << std::endl;
+        }
+    }
+#endif
+    using Clock = std::chrono::steady_clock;
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>{1.0 / kSchedule.rate.to<double>()});
+    auto deadline = Clock::now();
+    while (control_thread_run_.load(std::memory_order_relaxed)) {
+        RunPeriodic();
+        auto now = Clock::now();
+        do {
+            deadline += period;
+        } while (deadline <= now);
+        std::this_thread::sleep_until(deadline);
+    }
+}
+
+/**
+ * Main thread side, sends the whole desired state to the control loop. Only the latest command is kept.
+**/
+void Drive::PublishCommand() { commands_.Publish(cmd_); }
+
+/**
+ * Main thread side, sends a new cmd_.state and cmd_.out, for the control loop to adopt in place of its own.
+**/
+void Drive::PublishState() {
+    cmd_.state_seq++;
+    PublishCommand();
+}
+
+/**
+ * Main thread side, frees the trajectories the control loop has moved past or run out, it never frees them itself
+**/
+void Drive::FreeTakenTrajs() {
+    status_.Update();
+    const DriveStatus& status = status_.Get();
+    trajs_.erase(std::remove_if(trajs_.begin(), trajs_.end(),
+                                [&status](const auto& traj) {
+                                    return traj.first < status.taken_traj_seq ||
+                                           traj.first ==
+                                               status.finished_traj_seq;
+                                }),
+                 trajs_.end());
+}
+
+/**
+ * Control loop side, adopts the latest command if there is a new one. A new state and output, zeroing and new trajectories are acted on
+ * once each, by sequence number.
+**/
+void Drive::TakeCommand() {
+    if (!commands_.Update()) {
+        return;
+    }
+    const DriveCommand& cmd = commands_.Get();
+    if (cmd.zero_seq != taken_zero_seq_) {
+        taken_zero_seq_ = cmd.zero_seq;
+        // zero the sensors here rather than on the main thread, so the
+        // odometry is never updated between them and its reset
+        navx_.ZeroYaw();
+        left_master_.SetSelectedSensorPosition(0);
+        right_master_.SetSelectedSensorPosition(0);
+        robot_state_.ResetFieldToRobot();
+        odometry_.ResetPosition({}, GetYaw());
+    }
+    if (cmd.traj_seq != taken_traj_seq_) {
+        taken_traj_seq_ = cmd.traj_seq;
+        loop_status_.taken_traj_seq = taken_traj_seq_;
+        curr_traj_ = cmd.traj;
+        traj_timer.Reset();
+        traj_timer.Start();
+    }
+    if (cmd.state_seq != taken_state_seq_) {
+        taken_state_seq_ = cmd.state_seq;
+        state_ = cmd.state;
+        pout_ = cmd.out;
+    }
+}
+
 /**
- * The first method called in Periodic(), in which the slaves are checked whether a reset has occured
+ * Called in the read phase (and once at construction), in which the slaves are checked whether a reset has occured
  * If a slave was reset, its frame period will once again be set to the correct value like in the constructor
  * A counter will also be ticked to show how many times the falcons have been reset 
  * 
@@ -70,32 +193,47 @@ Drive::Drive(const conf::DriveConfig& cfg)
 void Drive::CheckFalconFramePeriods() {
     if (left_master_.HasResetOccurred()) {
         conf::SetDriveMasterFramePeriods(left_master_);
-        falcon_reset_count_++;
+        loop_status_.falcon_reset_count++;
     }
     if (right_master_.HasResetOccurred()) {
         conf::SetDriveMasterFramePeriods(right_master_);
-        falcon_reset_count_++;
+        loop_status_.falcon_reset_count++;
     }
     if (left_slave_.HasResetOccurred()) {
         conf::SetDriveSlaveFramePeriods(left_slave_);
-        falcon_reset_count_++;
+        loop_status_.falcon_reset_count++;
     }
     if (right_slave_.HasResetOccurred()) {
         conf::SetDriveSlaveFramePeriods(right_slave_);
-        falcon_reset_count_++;
+        loop_status_.falcon_reset_count++;
     }
 }
 
+/**
+ * Read phase, takes the latest command, checks for motor resets and updates the odometry and robot state from the encoders and navx
+**/
+void Drive::ReadPeriodicIn() {
+    TakeCommand();
+    CheckFalconFramePeriods();
+    UpdateRobotState();
+}
+
 /**
  * This method is the most important as it is periodically called, and is what allows the robot to move
- * After checking for motor resets, the current state will be updated
  * Depending on the state, different cotnrollers will be updated such that the robot can perform the movement necessary
  * to follow a path or orient the shooter.
- * Outputs will also be written for analysis 
 **/
 void Drive::Periodic() {
-    CheckFalconFramePeriods();
-    UpdateRobotState();
+    if (curr_traj_ != nullptr && traj_timer.Get() > curr_traj_->TotalTime()) {
+        // report it finished even if another Set* took over partway through,
+        // the main thread frees it
+        curr_traj_ = nullptr;
+        loop_status_.finished_traj_seq = taken_traj_seq_;
+        if (state_ == DriveState::FOLLOW_PATH) {
+            state_ = DriveState::OPEN_LOOP;
+            pout_ = {ControlMode::PercentOutput, 0.0, 0.0};
+        }
+    }
     switch (state_) {
         case DriveState::OPEN_LOOP:
             // TODO(josh)
@@ -109,7 +247,6 @@ void Drive::Periodic() {
             // TODO(josh) log here
             break;
     }
-    WriteOuts();
 }
 
 /**
@@ -118,15 +255,13 @@ void Drive::Periodic() {
 void Drive::Stop() {}
 
 /**
- * Resets the position of sensors on the drive
+ * Resets the position of sensors on the drive. Waits for the navx to calibrate, then asks the control loop to zero the navx and
+ * encoders and reset the odometry and robot state, all together when it next reads.
 **/
 void Drive::ZeroSensors() {
-    robot_state_.ResetFieldToRobot();
     WaitForNavxCalibration(0.5);
-    navx_.ZeroYaw();
-    left_master_.SetSelectedSensorPosition(0);
-    right_master_.SetSelectedSensorPosition(0);
-    odometry_.ResetPosition({}, GetYaw());
+    cmd_.zero_seq++;
+    PublishCommand();
 }
 
 /**
@@ -148,18 +283,31 @@ void Drive::WaitForNavxCalibration(double timeout_sec) {
 }
 
 /**
- * Empty method, presumably to ... output telemetry
+ * Publishes what the control loop last wrote, from the main thread so the loop never waits on the dashboard
 **/
-void Drive::OutputTelemetry() {}
+void Drive::OutputTelemetry() {
+    FreeTakenTrajs();
+    const DriveStatus& status = status_.Get();
+    SDB_NUMERIC(double, LeftDriveTalonDemand){status.left_demand};
+    SDB_NUMERIC(double, RightDriveTalonDemand){status.right_demand};
+    if (falcon_reset_count_ != status.falcon_reset_count) {
+        falcon_reset_count_ = status.falcon_reset_count;
+    }
+}
 
 /**
- * Adds the drive trajectory it wants to move at, and changes the current state to follow that path
+ * Adds the drive trajectory it wants to move at, and changes the current state to follow that path.
+ * The control loop only gets a pointer to the trajectory, this thread keeps it until the loop is done with it, so handing it
+ * over never allocates or frees there.
 **/
 void Drive::SetWantDriveTraj(frc::Trajectory&& traj) {
-    curr_traj_.emplace(std::move(traj));
-    state_ = DriveState::FOLLOW_PATH;
-    traj_timer.Reset();
-    traj_timer.Start();
+    FreeTakenTrajs();
+    cmd_.traj_seq++;
+    trajs_.emplace_back(cmd_.traj_seq, std::make_unique<const frc::Trajectory>(
+                                           std::move(traj)));
+    cmd_.traj = trajs_.back().second.get();
+    cmd_.state = DriveState::FOLLOW_PATH;
+    PublishState();
 }
 
 /**
@@ -176,15 +324,12 @@ void Drive::UpdateRobotState() {
  * Updates the path controller such that it'll correctly follow the trajectory the driver has set for it
 **/
 void Drive::UpdatePathController() {
-    if (!curr_traj_.has_value()) {
+    if (curr_traj_ == nullptr) {
         // LOG
-    }
-    if (FinishedTraj()) {
-        curr_traj_.reset();
-        SetWantRawOpenLoop({0.0_mps, 0.0_mps});
+        return;
     }
     auto time_along = traj_timer.Get();
-    auto desired = curr_traj_.value().Sample(units::second_t{time_along});
+    auto desired = curr_traj_->Sample(units::second_t{time_along});
     auto chassis_v = ramsete_.Calculate(
         robot_state_.GetLatestFieldToRobot().second, desired);
     auto wheel_v = kinematics_.ToWheelSpeeds(chassis_v);
@@ -226,13 +371,11 @@ bool Drive::BackUp(double dist) { //units are meters
     double error = abs(ticks) - abs(ticks_gone);
     double correction = Kp*error + Ki;
 
-    pout_.control_mode = ControlMode::PercentOutput;
-    pout_.left_demand = correction;
-    pout_.right_demand = correction;
-
-    std::cout << "ticks: " << ticks << std::endl;
-    std::cout << "ticks gone: " << ticks_gone << std::endl;
-    std::cout << "correction: " << correction << std::endl;
+    cmd_.state = DriveState::OPEN_LOOP;
+    cmd_.out.control_mode = ControlMode::PercentOutput;
+    cmd_.out.left_demand = correction;
+    cmd_.out.right_demand = correction;
+    PublishState();
 
     return abs(ticks - ticks_gone) < 50;
 
@@ -243,7 +386,7 @@ bool Drive::BackUp(double dist) { //units are meters
  * Changes the current state of the robot to orient its vision sensor for a shot, and sets the angle at which the sensor should be rotated to
 **/
 void Drive::SetWantOrientForShot(Limelight& limelight, double Kp, double Ki, double Kd) {
-    state_ = DriveState::SHOOT_ORIENT;
+    cmd_.state = DriveState::SHOOT_ORIENT;
     vision_rot_.SetGoal(0.0_rad);
 
 	Kp = 0.017; 
@@ -260,9 +403,10 @@ void Drive::SetWantOrientForShot(Limelight& limelight, double Kp, double Ki, dou
     if (steering_adjust > 1) steering_adjust = 1;
   //  std::cout <<"x offset: " << x_off << std::endl; 
     std::cout << "steering adjust: " << steering_adjust << std::endl; 
-    pout_.control_mode = ControlMode::PercentOutput;
-    pout_.left_demand = steering_adjust;
-    pout_.right_demand = -steering_adjust; 
+    cmd_.out.control_mode = ControlMode::PercentOutput;
+    cmd_.out.left_demand = steering_adjust;
+    cmd_.out.right_demand = -steering_adjust; 
+    PublishState();
 }
 
 /**
@@ -303,15 +447,11 @@ void Drive::UpdateOrientController() {
 }
 
 /**
- * Returns true if the current trajectory variable does not have a value, meaning it is not currently moving
+ * Returns true once the control loop has run out the last trajectory set, or if none was ever set
 **/
 bool Drive::FinishedTraj() {
-    if (!curr_traj_.has_value()) {
-        // not running one at the moment
-        return true;
-    }
-    // TODO(josh) find a better way?
-    return traj_timer.Get() > curr_traj_.value().TotalTime();
+    status_.Update();
+    return status_.Get().finished_traj_seq == cmd_.traj_seq;
 }
 
 /**
@@ -319,10 +459,11 @@ bool Drive::FinishedTraj() {
 **/
 void Drive::SetWantRawOpenLoop(
     const frc::DifferentialDriveWheelSpeeds& openloop) {
-    state_ = DriveState::OPEN_LOOP;
-    pout_.control_mode = ControlMode::PercentOutput;
-    pout_.left_demand = openloop.left.to<double>();
-    pout_.right_demand = openloop.right.to<double>();
+    cmd_.state = DriveState::OPEN_LOOP;
+    cmd_.out.control_mode = ControlMode::PercentOutput;
+    cmd_.out.left_demand = openloop.left.to<double>();
+    cmd_.out.right_demand = openloop.right.to<double>();
+    PublishState();
 }
 
 /**
@@ -351,13 +492,14 @@ void Drive::SetWantCheesyDrive(double throttle, double wheel, bool quick_turn) {
 }
 
 /**
- * Writes the relevant outputs  
+ * Write phase, writes the relevant outputs and reports them back to the main thread
 **/
-void Drive::WriteOuts() {
-    SDB_NUMERIC(double, LeftDriveTalonDemand){pout_.left_demand};
-    SDB_NUMERIC(double, RightDriveTalonDemand){pout_.right_demand};
+void Drive::WritePeriodicOut() {
     left_master_.Set(pout_.control_mode, pout_.left_demand);
     right_master_.Set(pout_.control_mode, pout_.right_demand);
+    loop_status_.left_demand = pout_.left_demand;
+    loop_status_.right_demand = pout_.right_demand;
+    status_.Publish(loop_status_);
  //   if (pout_.left_demand == 0 && pout_.right_demand == 0) return;
   //  std::cout << "write out left demand: " << pout_.left_demand << std::endl;
   //  std::cout << "write out right demand: " << pout_.right_demand << std::endl;
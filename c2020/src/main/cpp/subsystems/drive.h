@@ -1,6 +1,11 @@
 #pragma once
 
-#include <optional>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "shims/minimal_phoenix.h"
 
@@ -16,16 +21,20 @@
 #include "robot_state.h"
 #include "shims/navx_ahrs.h"
 #include "subsystem.h"
+#include "util/mailbox.h"
 #include "util/sdb_types.h"
 
 namespace team114 {
 namespace c2020 {
 
 class Drive : public Subsystem {
-    SUBSYSTEM_PRELUDE(Drive)
+    SUBSYSTEM_PRELUDE(Drive, 200_Hz, kRunAlways)
    public:
     Drive(const conf::DriveConfig& cfg);
+    ~Drive();
+    void ReadPeriodicIn() override;
     void Periodic() override;
+    void WritePeriodicOut() override;
     void Stop() override;
     void ZeroSensors() override;
     void OutputTelemetry() override;
@@ -42,6 +51,12 @@ class Drive : public Subsystem {
 
     bool BackUp(double dist);
 
+    // Runs the three phases on a dedicated real time thread at kSchedule's
+    // rate instead of from the Scheduler, see conf::DriveConfig. The Set*
+    // methods then only post a command for that thread to pick up.
+    void StartControlThread();
+    bool ControlThreadRunning() const { return control_thread_.joinable(); }
+
     TalonFX left_master_, right_master_; //this is my code, and I do what I want
 
    private:
@@ -55,6 +70,34 @@ class Drive : public Subsystem {
         double left_demand;
         double right_demand;
     };
+    // Main thread -> control loop. Always the whole desired state, so the
+    // loop only ever needs the latest one. The sequence numbers tell the loop
+    // to act once on a new state and output, trajectory or zeroing, so a
+    // command republished for one of them doesn't undo what the loop has
+    // since done to the others (e.g. stopping after a trajectory). traj is
+    // owned by the main thread, see trajs_.
+    struct DriveCommand {
+        DriveState state;
+        PeriodicOut out;
+        const frc::Trajectory* traj;
+        uint32_t state_seq;
+        uint32_t traj_seq;
+        uint32_t zero_seq;
+    };
+    // Control loop -> main thread
+    struct DriveStatus {
+        uint32_t taken_traj_seq;
+        uint32_t finished_traj_seq;
+        double left_demand;
+        double right_demand;
+        unsigned int falcon_reset_count;
+    };
+    void PublishCommand();
+    void PublishState();
+    void TakeCommand();
+    void FreeTakenTrajs();
+    void ControlThreadMain();
+
     void CheckFalconFramePeriods();
 
     void UpdateRobotState();
@@ -71,8 +114,21 @@ class Drive : public Subsystem {
     TalonFX left_slave_, right_slave_;
     AHRS navx_{frc::SPI::Port::kMXP};
 
+    // main thread side
+    DriveCommand cmd_{};
+    Mailbox<DriveCommand> commands_{};
+    Mailbox<DriveStatus> status_{};
+    // trajectories handed to the control loop by sequence number, kept until
+    // the loop is done with them so they are never freed on its thread
+    std::vector<std::pair<uint32_t, std::unique_ptr<const frc::Trajectory>>>
+        trajs_;
+
+    // control loop side, only touched by the phases
     PeriodicOut pout_{};
-    void WriteOuts();
+    DriveStatus loop_status_{};
+    uint32_t taken_state_seq_{0};
+    uint32_t taken_traj_seq_{0};
+    uint32_t taken_zero_seq_{0};
 
     const conf::DriveConfig cfg_;
     DriveState state_{DriveState::OPEN_LOOP};
@@ -81,9 +137,12 @@ class Drive : public Subsystem {
     frc::DifferentialDriveKinematics kinematics_;
     frc::DifferentialDriveOdometry odometry_;
     frc::RamseteController ramsete_;
-    std::optional<frc::Trajectory> curr_traj_;
+    const frc::Trajectory* curr_traj_{nullptr};
     frc2::Timer traj_timer{};
 
+    std::atomic<bool> control_thread_run_{false};
+    std::thread control_thread_;
+
     frc::ProfiledPIDController<units::radian> vision_rot_;
     bool has_vision_target_;
 };
@@ -10,7 +10,7 @@ namespace team114 {
 namespace c2020 {
 
 class Hood : public Subsystem {
-    SUBSYSTEM_PRELUDE(Hood)
+    SUBSYSTEM_PRELUDE(Hood, 100_Hz, kRunAutonomous | kRunTeleop)
    public:
     Hood(const conf::HoodConfig& cfg);
     void Periodic() override;
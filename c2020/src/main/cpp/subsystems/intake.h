@@ -10,7 +10,7 @@ namespace team114 {
 namespace c2020 {
 
 class Intake : public Subsystem {
-    SUBSYSTEM_PRELUDE(Intake)
+    SUBSYSTEM_PRELUDE(Intake, 100_Hz, kRunAutonomous | kRunTeleop)
    public:
     Intake(const conf::IntakeConfig& cfg);
     void Periodic() override;
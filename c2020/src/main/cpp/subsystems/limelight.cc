@@ -14,10 +14,9 @@ Limelight::Limelight(conf::LimelightConfig& cfg) : cfg_{std::move(cfg)} {
 }
 
 void Limelight::Periodic() {
-    ReadPeriodicIn();
-    WritePeriodicOut();
-    RobotState::GetInstance().ObserveVision(frc2::Timer::GetFPGATimestamp(),
-                                            GetTarget());
+    // stamped at capture, so the pose can be looked up for when it was seen
+    RobotState::GetInstance().ObserveVision(
+        frc2::Timer::GetFPGATimestamp() - per_in_.latency, GetTarget());
 }
 
 void Limelight::ReadPeriodicIn() {
@@ -23,7 +23,7 @@ namespace c2020 {
 
 class Limelight : public Subsystem {
    public:
-    SUBSYSTEM_PRELUDE(Limelight)
+    SUBSYSTEM_PRELUDE(Limelight, 50_Hz, kRunAlways)
     const units::second_t kImageCaptureLatency = 11_ms;
 
     struct RawTargetInfo {
@@ -65,9 +65,9 @@ class Limelight : public Subsystem {
     std::optional<TargetInfo> GetTarget();
 
    private:
-    void ReadPeriodicIn();
+    void ReadPeriodicIn() override;
 
-    void WritePeriodicOut();
+    void WritePeriodicOut() override;
 
     std::shared_ptr<nt::NetworkTable> network_table_;
 
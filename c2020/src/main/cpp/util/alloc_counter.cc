@@ -0,0 +1,78 @@
+#include "util/alloc_counter.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace team114 {
+namespace c2020 {
+
+namespace {
+// constant initialized, so safe to touch from inside operator new
+thread_local AllocCount thread_count_{};
+}  // namespace
+
+AllocCount ThreadAllocCount() { return thread_count_; }
+
+#ifdef C2020_COUNT_ALLOCS
+namespace {
+void* CountedAlloc(std::size_t size, std::size_t align) noexcept {
+    thread_count_.allocs++;
+    thread_count_.bytes += size;
+    if (size == 0) {
+        size = 1;
+    }
+    if (align <= alignof(std::max_align_t)) {
+        return std::malloc(size);
+    }
+    // aligned_alloc wants a multiple of the alignment
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+void CountedFree(void* ptr) noexcept {
+    if (ptr != nullptr) {
+        thread_count_.frees++;
+        std::free(ptr);
+    }
+}
+}  // namespace
+#endif
+
+}  // namespace c2020
+}  // namespace team114
+
+#ifdef C2020_COUNT_ALLOCS
+// The array and nothrow forms not replaced here forward to these by
+// default.
+using team114::c2020::CountedAlloc;
+using team114::c2020::CountedFree;
+
+void* operator new(std::size_t size) {
+    void* ptr = CountedAlloc(size, alignof(std::max_align_t));
+    if (ptr == nullptr) {
+        throw std::bad_alloc{};
+    }
+    return ptr;
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size, alignof(std::max_align_t));
+}
+void* operator new(std::size_t size, std::align_val_t align) {
+    void* ptr = CountedAlloc(size, static_cast<std::size_t>(align));
+    if (ptr == nullptr) {
+        throw std::bad_alloc{};
+    }
+    return ptr;
+}
+void operator delete(void* ptr) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    CountedFree(ptr);
+}
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    CountedFree(ptr);
+}
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    CountedFree(ptr);
+}
+#endif
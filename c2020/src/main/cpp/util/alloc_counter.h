@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace team114 {
+namespace c2020 {
+
+// Heap allocation counting, for keeping allocations out of the control loop.
+// Opt in by building with C2020_COUNT_ALLOCS defined (./gradlew build
+// -PcountAllocs), which replaces the global operator new/delete. Otherwise
+// nothing is replaced and every count reads zero.
+#ifdef C2020_COUNT_ALLOCS
+constexpr bool kAllocCountingEnabled = true;
+#else
+constexpr bool kAllocCountingEnabled = false;
+#endif
+
+struct AllocCount {
+    uint64_t allocs = 0;
+    uint64_t bytes = 0;
+    uint64_t frees = 0;
+
+    AllocCount& operator+=(const AllocCount& other) {
+        allocs += other.allocs;
+        bytes += other.bytes;
+        frees += other.frees;
+        return *this;
+    }
+    AllocCount operator-(const AllocCount& other) const {
+        return {allocs - other.allocs, bytes - other.bytes,
+                frees - other.frees};
+    }
+};
+
+// Running totals for the calling thread
+AllocCount ThreadAllocCount();
+
+// Counts allocations made by the calling thread since construction
+class AllocScope {
+   public:
+    AllocScope() : start_{ThreadAllocCount()} {}
+    AllocCount Get() const { return ThreadAllocCount() - start_; }
+
+   private:
+    AllocCount start_;
+};
+
+// Totals added from one thread and taken from another, for loops that run off
+// the main thread
+class AllocAccumulator {
+   public:
+    void Add(const AllocCount& count) {
+        if (count.allocs == 0 && count.frees == 0) {
+            return;
+        }
+        allocs_.fetch_add(count.allocs, std::memory_order_relaxed);
+        bytes_.fetch_add(count.bytes, std::memory_order_relaxed);
+        frees_.fetch_add(count.frees, std::memory_order_relaxed);
+    }
+    // totals since the last call
+    AllocCount Take() {
+        return {allocs_.exchange(0, std::memory_order_relaxed),
+                bytes_.exchange(0, std::memory_order_relaxed),
+                frees_.exchange(0, std::memory_order_relaxed)};
+    }
+
+   private:
+    std::atomic<uint64_t> allocs_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> frees_{0};
+};
+
+}  // namespace c2020
+}  // namespace team114
@@ -1,73 +1,63 @@
 #pragma once
 
+#include <cstddef>
+#include <functional>
+#include <iterator>
 #include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include <frc/geometry/Pose2d.h>
 
 namespace team114 {
 namespace c2020 {
 
+// Storage policies for InterpolatingMap. Each exposes:
+//   Size(), Clear(), Latest() -> const value_type* (nullptr if empty),
+//   Bracket(key) -> {lower or equal, strictly upper} (nullptr where none),
+//   Insert(key) -> T& (evicting the oldest entry if at capacity).
+
+// Node based storage, tolerates keys arriving in any order
 template <class Key,                              // map::key_type
           class T,                                // map::mapped_type
-          typename KeyInverseInterpolateFunctor,  // (lower_key, upper_key,
-                                                  // interp_key) -> double [0,
-                                                  // 1)
-          typename TInterpolateFunctor,    // (lower_val, upper_val, double [0,
-                                           // 1)) -> T
-          class Compare = std::less<Key>,  // map::key_compare
+          class Compare = std::less<Key>,         // map::key_compare
           class Alloc =
               std::allocator<std::pair<const Key, T> >  // map::allocator_type
           >
-class InterpolatingMap {
+class MapStorage {
    public:
     typedef std::map<Key, T, Compare, Alloc> InnerMap;
-    InterpolatingMap(typename InnerMap::size_type max_size)
-        : inverse_interp_{}, interp_{}, map_{}, max_size_{max_size} {}
+    typedef typename InnerMap::value_type value_type;
+    typedef typename InnerMap::size_type size_type;
+
+    MapStorage(size_type max_size) : map_{}, max_size_{max_size} {}
     InnerMap& Inner() { return map_; }
-    typename InnerMap::value_type InterpAt(Key key) {
-        // gets prev item, if key exists return that item
-        auto below_iter = GetLowerOrEqual(key);
-        // gets next item, if key exists returns next item
-        auto above_iter = map_.upper_bound(key);
-        auto end = map_.end();
-        if (below_iter == end && above_iter == end) {
-            // map is empty, we'd rather not return an past-the-end iter as STL
-            // would, and this is a degenerate case, so throw
-            throw std::out_of_range{"interp_map is empty"};
-        }
-        if (above_iter == end) {
-            // return map end
-            return *below_iter;
-        }
-        if (below_iter == end) {
-            // return map beginning
-            return *above_iter;
-        }
-        // both iterators are valid, interpolate:
-        double interp =
-            inverse_interp_(below_iter->first, above_iter->first, key);
-        const T value = interp_(below_iter->second, above_iter->second, interp);
-        typename InnerMap::value_type ret{key, value};
-        return ret;
-    }
+    size_type Size() const { return map_.size(); }
+    void Clear() { map_.clear(); }
 
-    // naming assumes time-based and that comparator is less
-    typename InnerMap::value_type Latest() {
+    const value_type* Latest() const {
         auto it = map_.rbegin();
         if (it == map_.rend()) {
-            throw std::out_of_range{"interp_map is empty"};
+            return nullptr;
         }
-        return *it;
+        return &*it;
     }
 
-    // DOES NOT INTERPOLATE, for insertion only
-    T& operator[](const Key&& key) {
-        if (map_.size() >= max_size_) {
-            map_.erase(map_.begin());
-        }
-        return map_[key];
+    std::pair<const value_type*, const value_type*> Bracket(
+        const Key& key) const {
+        // gets next item, if key exists returns next item
+        auto above_iter = map_.upper_bound(key);
+        const value_type* above =
+            above_iter == map_.end() ? nullptr : &*above_iter;
+        // if our key is below all other keys (or the map is empty) there is
+        // no lower or equal, otherwise it is the one before upper_bound
+        const value_type* below =
+            above_iter == map_.begin() ? nullptr : &*std::prev(above_iter);
+        return {below, above};
     }
-    T& operator[](const Key& key) {
+
+    T& Insert(const Key& key) {
         if (map_.size() >= max_size_) {
             map_.erase(map_.begin());
         }
@@ -81,29 +71,234 @@ class InterpolatingMap {
     }
 
    private:
-    auto GetLowerOrEqual(Key key) {
-        auto it = map_.upper_bound(key);
-        if (it == map_.begin()) {
-            // if the map is empty, we find nothing and end == begin, in which
-            // case return end, thats covered
-            // if our key is below all other keys, our result will be the first
-            // element, which is begin in that case there is no lower or equal,
-            // so return end
-            return map_.end();
-        }
-        // now we either have:
-        // 1. our key was past all other keys, we got one-past-end, want the
-        // last element
-        // 2. our key was not in the map, we got one-past what we want
-        // 3. our key was in the map, we got one-past what we want
-        --it;
-        return it;
+    InnerMap map_;
+    const size_type max_size_;
+};
+
+// Fixed capacity, contiguous, time ordered storage. All memory is allocated at
+// construction. Appending a key newer than every stored key is O(1), lookups
+// are a search started from the previous lookup. Older keys are still accepted
+// but shift the newer entries, so prefer MapStorage if keys are not mostly
+// monotonic.
+template <class Key, class T, class Compare = std::less<Key> >
+class RingBufferStorage {
+   public:
+    typedef std::pair<Key, T> value_type;
+    typedef std::size_t size_type;
+
+    RingBufferStorage(size_type capacity)
+        : buf_(capacity), cmp_{}, head_{0}, size_{0}, hint_{0} {
+        if (capacity == 0) {
+            throw std::invalid_argument{"ring buffer capacity must be > 0"};
+        }
+    }
+    size_type Size() const { return size_; }
+    size_type Capacity() const { return buf_.size(); }
+    void Clear() {
+        head_ = 0;
+        size_ = 0;
+        hint_ = 0;
+    }
+
+    const value_type* Latest() const {
+        if (size_ == 0) {
+            return nullptr;
+        }
+        return &At(size_ - 1);
+    }
+
+    std::pair<const value_type*, const value_type*> Bracket(
+        const Key& key) const {
+        size_type above = UpperBound(key);
+        return {above == 0 ? nullptr : &At(above - 1),
+                above == size_ ? nullptr : &At(above)};
+    }
+
+    T& Insert(const Key& key) {
+        // same eviction rule as MapStorage, so the two behave identically
+        if (size_ >= buf_.size()) {
+            head_ = Wrap(head_ + 1);
+            --size_;
+            // keep the hint on the same entry
+            if (hint_ > 0) {
+                --hint_;
+            }
+        }
+        // fast path, key is newer than everything stored
+        if (size_ == 0 || cmp_(At(size_ - 1).first, key)) {
+            value_type& slot = At(size_++);
+            slot = value_type{key, T{}};
+            return slot.second;
+        }
+        size_type above = UpperBound(key);
+        if (above > 0 && !cmp_(At(above - 1).first, key)) {
+            // key already exists
+            return At(above - 1).second;
+        }
+        // out of order, shift newer entries up a slot to keep time order
+        for (size_type i = size_; i > above; --i) {
+            At(i) = std::move(At(i - 1));
+        }
+        ++size_;
+        value_type& slot = At(above);
+        slot = value_type{key, T{}};
+        return slot.second;
+    }
+
+    void CheckSize() {}
+
+   private:
+    size_type Wrap(size_type idx) const {
+        return idx >= buf_.size() ? idx - buf_.size() : idx;
+    }
+    // logical index, 0 is the oldest entry
+    value_type& At(size_type idx) { return buf_[Wrap(head_ + idx)]; }
+    const value_type& At(size_type idx) const {
+        return buf_[Wrap(head_ + idx)];
+    }
+    // logical index of the first entry strictly after key, size_ if none.
+    // Gallops outward from the previous result, so a query near the last one
+    // is O(1) and a sorted batch of queries walks the buffer once.
+    size_type UpperBound(const Key& key) const {
+        size_type lo;
+        size_type hi;
+        size_type hint = hint_ > size_ ? size_ : hint_;
+        if (hint == size_ || cmp_(key, At(hint).first)) {
+            if (hint == 0 || !cmp_(key, At(hint - 1).first)) {
+                // same bracket as last time
+                return hint_ = hint;
+            }
+            // answer is at or below hint - 1, gallop down
+            hi = hint - 1;
+            size_type step = 1;
+            while (true) {
+                if (hi < step) {
+                    lo = 0;
+                    break;
+                }
+                size_type probe = hi - step;
+                if (!cmp_(key, At(probe).first)) {
+                    lo = probe + 1;
+                    break;
+                }
+                hi = probe;
+                step *= 2;
+            }
+        } else {
+            // answer is above hint, gallop up
+            lo = hint + 1;
+            size_type step = 1;
+            while (true) {
+                size_type probe = lo + step - 1;
+                if (probe >= size_) {
+                    hi = size_;
+                    break;
+                }
+                if (cmp_(key, At(probe).first)) {
+                    hi = probe;
+                    break;
+                }
+                lo = probe + 1;
+                step *= 2;
+            }
+        }
+        while (lo < hi) {
+            size_type mid = lo + (hi - lo) / 2;
+            if (cmp_(key, At(mid).first)) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        return hint_ = lo;
+    }
+
+    std::vector<value_type> buf_;
+    Compare cmp_;
+    size_type head_;
+    size_type size_;
+    // last query result, only a search starting point so never invalid
+    mutable size_type hint_;
+};
+
+template <class Key,                              // key type
+          class T,                                // mapped type
+          typename KeyInverseInterpolateFunctor,  // (lower_key, upper_key,
+                                                  // interp_key) -> double [0,
+                                                  // 1)
+          typename TInterpolateFunctor,  // (lower_val, upper_val, double [0,
+                                         // 1)) -> T
+          class Storage = MapStorage<Key, T> >  // MapStorage or
+                                                // RingBufferStorage
+class InterpolatingMap {
+   public:
+    typedef std::pair<const Key, T> value_type;
+    typedef typename Storage::size_type size_type;
+    InterpolatingMap(size_type max_size)
+        : inverse_interp_{}, interp_{}, storage_{max_size} {}
+    // only available with MapStorage
+    auto& Inner() { return storage_.Inner(); }
+    size_type Size() const { return storage_.Size(); }
+    void Clear() { storage_.Clear(); }
+
+    value_type InterpAt(Key key) {
+        return value_type{key, InterpValueAt(key)};
+    }
+
+    // Writes the interpolated value at each key in [first, last) to out.
+    // Keys should be sorted ascending, with RingBufferStorage each lookup
+    // then starts from the previous bracket instead of searching again.
+    template <class InputIt, class OutputIt>
+    OutputIt InterpAt(InputIt first, InputIt last, OutputIt out) {
+        for (; first != last; ++first, ++out) {
+            *out = InterpValueAt(*first);
+        }
+        return out;
+    }
+
+    // naming assumes time-based and that comparator is less
+    value_type Latest() {
+        auto latest = storage_.Latest();
+        if (latest == nullptr) {
+            throw std::out_of_range{"interp_map is empty"};
+        }
+        return *latest;
+    }
+
+    // DOES NOT INTERPOLATE, for insertion only
+    T& operator[](const Key&& key) { return storage_.Insert(key); }
+    T& operator[](const Key& key) { return storage_.Insert(key); }
+
+    void CheckSize() { storage_.CheckSize(); }
+
+   private:
+    T InterpValueAt(const Key& key) {
+        // below: prev item, if key exists that item
+        // above: next item, if key exists the next item
+        auto bracket = storage_.Bracket(key);
+        auto below = bracket.first;
+        auto above = bracket.second;
+        if (below == nullptr && above == nullptr) {
+            // map is empty, we'd rather not return an past-the-end iter as STL
+            // would, and this is a degenerate case, so throw
+            throw std::out_of_range{"interp_map is empty"};
+        }
+        if (above == nullptr) {
+            // return map end
+            return below->second;
+        }
+        if (below == nullptr) {
+            // return map beginning
+            return above->second;
+        }
+        // both entries are valid, interpolate:
+        double interp = inverse_interp_(below->first, above->first, key);
+        return interp_(below->second, above->second, interp);
     }
 
     KeyInverseInterpolateFunctor inverse_interp_;
     TInterpolateFunctor interp_;
-    InnerMap map_;
-    const typename InnerMap::size_type max_size_;
+    Storage storage_;
 };
 
 template <typename T>
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <frc/smartdashboard/SmartDashboard.h>
+
+namespace team114 {
+namespace c2020 {
+
+// Timing of periodic functions, for finding what is overrunning the loop.
+// Built in by default, define C2020_NO_LOOP_PROFILER (./gradlew build
+// -PnoLoopProfiler) to compile it out, in which case nothing is timed and
+// every summary reads zero.
+#ifdef C2020_NO_LOOP_PROFILER
+constexpr bool kLoopProfilerEnabled = false;
+#else
+constexpr bool kLoopProfilerEnabled = true;
+#endif
+
+// monotonic, unaffected by the RIO setting its wall clock from the DS
+using ProfilerClock = std::chrono::steady_clock;
+
+struct LoopTimingSummary {
+    uint32_t count = 0;  // total recorded, not just the window
+    double min_us = 0.0;
+    double mean_us = 0.0;
+    double p99_us = 0.0;
+    double max_us = 0.0;
+};
+
+#ifndef C2020_NO_LOOP_PROFILER
+// Rolling statistics over the last kWindow durations. Record() must only be
+// called from one thread, Summarize() may be called from any thread and never
+// blocks the recorder. A summary racing a record may see one newer sample.
+class LoopTimingStats {
+   public:
+    static constexpr std::size_t kWindow = 256;
+
+    void Record(ProfilerClock::duration elapsed) {
+        auto us =
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+                .count();
+        uint32_t count = count_.load(std::memory_order_relaxed);
+        samples_us_[count % kWindow].store(
+            static_cast<uint32_t>(std::max<decltype(us)>(us, 0)),
+            std::memory_order_relaxed);
+        count_.store(count + 1, std::memory_order_release);
+    }
+
+    LoopTimingSummary Summarize() const {
+        LoopTimingSummary ret;
+        ret.count = count_.load(std::memory_order_acquire);
+        std::size_t n = std::min<std::size_t>(ret.count, kWindow);
+        if (n == 0) {
+            return ret;
+        }
+        // window order doesn't matter for any of these
+        std::array<uint32_t, kWindow> samples;
+        uint64_t sum = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            samples[i] = samples_us_[i].load(std::memory_order_relaxed);
+            sum += samples[i];
+        }
+        auto end = samples.begin() + n;
+        auto minmax = std::minmax_element(samples.begin(), end);
+        ret.min_us = *minmax.first;
+        ret.max_us = *minmax.second;
+        ret.mean_us = static_cast<double>(sum) / n;
+        auto p99 = samples.begin() + (n - 1) * 99 / 100;
+        std::nth_element(samples.begin(), p99, end);
+        ret.p99_us = *p99;
+        return ret;
+    }
+
+   private:
+    std::array<std::atomic<uint32_t>, kWindow> samples_us_{};
+    std::atomic<uint32_t> count_{0};
+};
+#else
+class LoopTimingStats {
+   public:
+    void Record(ProfilerClock::duration) {}
+    LoopTimingSummary Summarize() const { return {}; }
+};
+#endif
+
+inline void PublishLoopTiming(const char* name,
+                              const LoopTimingSummary& summary) {
+    if constexpr (!kLoopProfilerEnabled) {
+        return;
+    }
+    std::string prefix = std::string{"Timing/"} + name + "/";
+    frc::SmartDashboard::PutNumber(prefix + "MinUs", summary.min_us);
+    frc::SmartDashboard::PutNumber(prefix + "MeanUs", summary.mean_us);
+    frc::SmartDashboard::PutNumber(prefix + "P99Us", summary.p99_us);
+    frc::SmartDashboard::PutNumber(prefix + "MaxUs", summary.max_us);
+}
+
+}  // namespace c2020
+}  // namespace team114
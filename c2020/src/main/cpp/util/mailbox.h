@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace team114 {
+namespace c2020 {
+
+// Latest value mailbox between exactly one producer thread and one consumer
+// thread. A triple buffer: the producer fills a back slot and swaps it with the
+// middle slot, the consumer swaps the middle slot for its front slot when it
+// wants the newest value. Neither side ever blocks, copying T is the only
+// possible allocation, and values
+// the consumer did not get to in time are overwritten rather than queued, so
+// only use it for state where the newest value supersedes the rest.
+template <typename T>
+class Mailbox {
+   public:
+    Mailbox() = default;
+    explicit Mailbox(const T& initial) { slots_.fill(initial); }
+
+    // producer side
+    void Publish(const T& value) {
+        slots_[back_] = value;
+        back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) &
+                kIndexMask;
+    }
+
+    // consumer side, true if Get() changed
+    bool Update() {
+        if ((middle_.load(std::memory_order_relaxed) & kFresh) == 0) {
+            return false;
+        }
+        front_ =
+            middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+    // consumer side, the value as of the last Update()
+    const T& Get() const { return slots_[front_]; }
+
+   private:
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFresh = 0x4;
+
+    std::array<T, 3> slots_{};
+    // producer's slot
+    uint8_t back_ = 0;
+    // consumer's slot
+    uint8_t front_ = 1;
+    // the slot in between, plus whether the producer has written it since
+    // the consumer last took it
+    std::atomic<uint8_t> middle_{2};
+};
+
+}  // namespace c2020
+}  // namespace team114
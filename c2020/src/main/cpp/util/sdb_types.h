@@ -11,11 +11,12 @@ namespace c2020 {
 // no string literals in templates yet, so have to resort to an ugly macro
 // defining an anonymous type. When/if those come, we can unify all types
 // into one beautiful SFINAE dance, without any macros
+// Names are plain literals so reading/writing doesn't build a std::string
 
-#define SDB_NUMERIC(type, key_ident)                               \
-    struct __SdbKey_##key_ident {                                  \
-        static const std::string GetName() { return #key_ident; }; \
-    };                                                             \
+#define SDB_NUMERIC(type, key_ident)                                  \
+    struct __SdbKey_##key_ident {                                     \
+        static constexpr const char* GetName() { return #key_ident; } \
+    };                                                                \
     team114::c2020::SdbNumeric<type, __SdbKey_##key_ident>
 
 template <typename NumericTy, typename KeyTy>
@@ -39,10 +40,10 @@ struct SdbNumeric {
     void Update() { frc::SmartDashboard::PutNumber(KeyTy::GetName(), value); }
 };
 
-#define SDB_BOOL(key_ident)                                        \
-    struct __SdbKey_##key_ident {                                  \
-        static const std::string GetName() { return #key_ident; }; \
-    };                                                             \
+#define SDB_BOOL(key_ident)                                           \
+    struct __SdbKey_##key_ident {                                     \
+        static constexpr const char* GetName() { return #key_ident; } \
+    };                                                                \
     team114::c2020::SdbBool<__SdbKey_##key_ident>
 
 template <typename KeyTy>
@@ -61,10 +62,10 @@ struct SdbBool {
     void Update() { frc::SmartDashboard::PutBoolean(KeyTy::GetName(), value); }
 };
 
-#define READING_SDB_NUMERIC(type, key_ident)                       \
-    struct __SdbKey_##key_ident {                                  \
-        static const std::string GetName() { return #key_ident; }; \
-    };                                                             \
+#define READING_SDB_NUMERIC(type, key_ident)                          \
+    struct __SdbKey_##key_ident {                                     \
+        static constexpr const char* GetName() { return #key_ident; } \
+    };                                                                \
     team114::c2020::ReadingSdbNumeric<type, __SdbKey_##key_ident>
 
 template <typename NumericTy, typename KeyTy>
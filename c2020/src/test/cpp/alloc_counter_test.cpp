@@ -0,0 +1,73 @@
+#include "util/alloc_counter.h"
+
+#include <memory>
+
+#include <frc/geometry/Pose2d.h>
+#include <units/units.h>
+
+#include "gtest/gtest.h"
+#include "subsystems/drive.h"
+#include "util/interp_map.h"
+
+using namespace team114::c2020;
+
+TEST(AllocCounter, CountsAllocations) {
+    ASSERT_TRUE(kAllocCountingEnabled);
+    AllocScope allocs;
+    auto one = std::make_unique<int>(1);
+    auto many = std::make_unique<double[]>(16);
+    one.reset();
+    AllocCount count = allocs.Get();
+    EXPECT_EQ(count.allocs, 2u);
+    EXPECT_GE(count.bytes, sizeof(int) + 16 * sizeof(double));
+    EXPECT_EQ(count.frees, 1u);
+}
+
+TEST(AllocCounter, PoseHistorySteadyState) {
+    // mirrors RobotState's pose history at the 10 ms loop rate
+    InterpolatingMap<units::second_t, frc::Pose2d,
+                     ArithmeticInverseInterp<units::second_t>, Pose2dInterp,
+                     RingBufferStorage<units::second_t, frc::Pose2d>>
+        history{800};
+    units::second_t now = 0_s;
+    auto tick = [&]() {
+        history[now] = frc::Pose2d{units::meter_t{now.to<double>()}, 0_m,
+                                   frc::Rotation2d{}};
+        history.InterpAt(now - 55_ms);
+        history.Latest();
+        now += 10_ms;
+    };
+    // fill and wrap the history once
+    for (int i = 0; i < 1000; i++) {
+        tick();
+    }
+    AllocScope allocs;
+    for (int i = 0; i < 1000; i++) {
+        tick();
+    }
+    EXPECT_EQ(allocs.Get().allocs, 0u);
+}
+
+TEST(AllocCounter, DrivePeriodicSteadyState) {
+    // the whole read, compute, write tick the drive runs on its real time
+    // thread, taking a new command every tick as it does while driving
+    Drive& drive = Drive::GetInstance();
+    double demand = 0.0;
+    auto tick = [&]() {
+        demand = demand > 0.5 ? 0.0 : demand + 0.01;
+        drive.SetWantRawOpenLoop(
+            {units::meters_per_second_t{demand}, 0.0_mps});
+        drive.RunPeriodic();
+    };
+    // warm up, anything set up lazily on the first ticks is fine
+    for (int i = 0; i < 1000; i++) {
+        tick();
+    }
+    drive.TakePeriodicAllocs();
+    AllocScope allocs;
+    for (int i = 0; i < 1000; i++) {
+        tick();
+    }
+    EXPECT_EQ(allocs.Get().allocs, 0u);
+    EXPECT_EQ(drive.TakePeriodicAllocs().allocs, 0u);
+}
@@ -1,5 +1,7 @@
 #include "util/interp_map.h"
 
+#include <array>
+
 #include "gtest/gtest.h"
 
 #include <units/units.h>
@@ -86,3 +88,83 @@ TEST(InterpMap, DoublePose2d) {
     EXPECT_TRUE(
         cmp(map.InterpAt(460.0).second, {{0.5_m, 0.866_m}, 2.6180_rad}));
 }
+
+TEST(InterpMap, RingBufferDoubleDouble) {
+    InterpolatingMap<double, double, ArithmeticInverseInterp<double>,
+                     ArithmeticInterp<double>,
+                     RingBufferStorage<double, double>>
+        map{2};
+
+    map[0.0] = 10.0;
+    map[5.0] = 20.0;
+
+    EXPECT_NEAR(map.InterpAt(2.5).second, 15.0, 0.001);
+    EXPECT_NEAR(map.InterpAt(-0.1).second, 10.0, 0.001);
+    EXPECT_NEAR(map.InterpAt(5.1).second, 20.0, 0.001);
+
+    // insert one more, should remove the lowest elem
+    map[10.0] = -10.0;
+    EXPECT_NEAR(map.InterpAt(4.9).second, 20.0, 0.001);
+    EXPECT_NEAR(map.InterpAt(8.33333).second, 0.0, 0.001);
+    EXPECT_EQ(map.Size(), 2u);
+
+    map.Clear();
+    EXPECT_EQ(map.Size(), 0u);
+    EXPECT_THROW(map.InterpAt(1.0), std::out_of_range);
+    EXPECT_THROW(map.Latest(), std::out_of_range);
+}
+
+TEST(InterpMap, RingBufferMatchesMap) {
+    typedef InterpolatingMap<double, double, ArithmeticInverseInterp<double>,
+                             ArithmeticInterp<double>>
+        Map;
+    typedef InterpolatingMap<double, double, ArithmeticInverseInterp<double>,
+                             ArithmeticInterp<double>,
+                             RingBufferStorage<double, double>>
+        Ring;
+    Map map{16};
+    Ring ring{16};
+    // mostly monotonic with some out of order and repeated keys, enough to
+    // wrap the ring several times
+    for (int i = 0; i < 100; i++) {
+        double key = i * 2.0;
+        if (i % 7 == 3) {
+            key -= 5.0;
+        }
+        if (i % 11 == 5) {
+            key = (i - 1) * 2.0;
+        }
+        map[key] = i * 3.0 - key;
+        ring[key] = i * 3.0 - key;
+        ASSERT_EQ(map.Size(), ring.Size());
+        ASSERT_EQ(map.Latest().first, ring.Latest().first);
+        for (double q = key - 40.0; q < key + 5.0; q += 0.75) {
+            auto m = map.InterpAt(q);
+            auto r = ring.InterpAt(q);
+            ASSERT_EQ(m.first, r.first);
+            ASSERT_NEAR(m.second, r.second, 1e-9);
+        }
+    }
+}
+
+TEST(InterpMap, RingBufferBatch) {
+    InterpolatingMap<double, double, ArithmeticInverseInterp<double>,
+                     ArithmeticInterp<double>,
+                     RingBufferStorage<double, double>>
+        map{8};
+    for (int i = 0; i < 20; i++) {
+        map[i * 10.0] = i * 100.0;
+    }
+    // history is now [120, 190]
+    std::array<double, 6> keys{100.0, 125.0, 125.0, 150.0, 187.5, 300.0};
+    std::array<double, 6> vals{};
+    map.InterpAt(keys.begin(), keys.end(), vals.begin());
+    std::array<double, 6> expected{1200.0, 1250.0, 1250.0,
+                                   1500.0, 1875.0, 1900.0};
+    for (size_t i = 0; i < keys.size(); i++) {
+        EXPECT_NEAR(vals[i], expected[i], 0.001);
+        // single lookups agree, going backwards moves the cached cursor down
+        EXPECT_NEAR(map.InterpAt(keys[keys.size() - 1 - i]).second,
+                    expected[keys.size() - 1 - i], 0.001);
+    }
+}
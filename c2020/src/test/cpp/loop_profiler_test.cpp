@@ -0,0 +1,41 @@
+#include "util/loop_profiler.h"
+
+#include <chrono>
+
+#include "gtest/gtest.h"
+
+using namespace team114::c2020;
+using std::chrono::microseconds;
+
+#ifndef C2020_NO_LOOP_PROFILER
+
+TEST(LoopProfiler, Summary) {
+    LoopTimingStats stats;
+    EXPECT_EQ(stats.Summarize().count, 0u);
+    for (int i = 1; i <= 100; i++) {
+        stats.Record(microseconds{i});
+    }
+    auto summary = stats.Summarize();
+    EXPECT_EQ(summary.count, 100u);
+    EXPECT_DOUBLE_EQ(summary.min_us, 1.0);
+    EXPECT_DOUBLE_EQ(summary.max_us, 100.0);
+    EXPECT_DOUBLE_EQ(summary.mean_us, 50.5);
+    EXPECT_DOUBLE_EQ(summary.p99_us, 99.0);
+}
+
+TEST(LoopProfiler, RollingWindow) {
+    LoopTimingStats stats;
+    // one slow loop, then enough fast ones to push it out of the window
+    stats.Record(microseconds{5000});
+    for (size_t i = 0; i < LoopTimingStats::kWindow - 1; i++) {
+        stats.Record(microseconds{10});
+    }
+    EXPECT_DOUBLE_EQ(stats.Summarize().max_us, 5000.0);
+    stats.Record(microseconds{20});
+    auto summary = stats.Summarize();
+    EXPECT_EQ(summary.count, LoopTimingStats::kWindow + 1);
+    EXPECT_DOUBLE_EQ(summary.min_us, 10.0);
+    EXPECT_DOUBLE_EQ(summary.max_us, 20.0);
+}
+
+#endif
@@ -0,0 +1,56 @@
+#include "util/mailbox.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+using namespace team114::c2020;
+
+TEST(Mailbox, LatestWins) {
+    Mailbox<int> box{-1};
+    EXPECT_FALSE(box.Update());
+    EXPECT_EQ(box.Get(), -1);
+    box.Publish(1);
+    box.Publish(2);
+    box.Publish(3);
+    EXPECT_TRUE(box.Update());
+    EXPECT_EQ(box.Get(), 3);
+    // nothing new, keeps the last value
+    EXPECT_FALSE(box.Update());
+    EXPECT_EQ(box.Get(), 3);
+    box.Publish(4);
+    EXPECT_TRUE(box.Update());
+    EXPECT_EQ(box.Get(), 4);
+}
+
+TEST(Mailbox, Threaded) {
+    // each value is self consistent and values only move forward
+    struct Sample {
+        uint64_t seq;
+        uint64_t check;
+    };
+    constexpr uint64_t kCount = 200000;
+    Mailbox<Sample> box{};
+    std::atomic<bool> done{false};
+    std::thread producer{[&] {
+        for (uint64_t i = 1; i <= kCount; i++) {
+            box.Publish({i, ~i});
+        }
+        done = true;
+    }};
+    uint64_t last = 0;
+    bool finished = false;
+    while (!finished) {
+        finished = done;
+        if (box.Update()) {
+            const Sample& s = box.Get();
+            EXPECT_EQ(s.check, ~s.seq);
+            EXPECT_GT(s.seq, last);
+            last = s.seq;
+        }
+    }
+    producer.join();
+    EXPECT_EQ(last, kCount);
+}
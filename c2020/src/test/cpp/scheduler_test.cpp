@@ -0,0 +1,102 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <units/units.h>
+
+#include "gtest/gtest.h"
+
+using namespace team114::c2020;
+
+namespace {
+class LoggingSubsystem : public Subsystem {
+   public:
+    LoggingSubsystem(std::string name, std::vector<std::string>& log)
+        : name_{name}, log_{log} {}
+    void ReadPeriodicIn() override { log_.push_back(name_ + ":r"); }
+    void Periodic() override { log_.push_back(name_ + ":c"); }
+    void WritePeriodicOut() override { log_.push_back(name_ + ":w"); }
+
+   private:
+    std::string name_;
+    std::vector<std::string>& log_;
+};
+}  // namespace
+
+TEST(Scheduler, PhaseOrder) {
+    std::vector<std::string> log;
+    LoggingSubsystem a{"a", log};
+    LoggingSubsystem b{"b", log};
+    Scheduler sched{5_ms};
+    sched.Register(a, {200_Hz, kRunAlways});
+    sched.Register(b, {200_Hz, kRunAlways});
+    sched.Tick(1_s, kRunTeleop);
+    std::vector<std::string> expected{"a:r", "b:r", "a:c", "b:c", "a:w", "b:w"};
+    EXPECT_EQ(log, expected);
+}
+
+TEST(Scheduler, Rates) {
+    std::vector<std::string> log;
+    LoggingSubsystem fast{"fast", log};
+    LoggingSubsystem mid{"mid", log};
+    LoggingSubsystem slow{"slow", log};
+    Scheduler sched{5_ms};
+    sched.Register(fast, {200_Hz, kRunAlways});
+    sched.Register(mid, {100_Hz, kRunAlways});
+    sched.Register(slow, {20_Hz, kRunAlways});
+    auto count = [&](const std::string& entry) {
+        return std::count(log.begin(), log.end(), entry);
+    };
+    for (int i = 0; i < 200; i++) {
+        // a little late every tick, like the notifier
+        sched.Tick(10_s + i * 5_ms + 0.3_ms, kRunTeleop);
+    }
+    EXPECT_EQ(count("fast:c"), 200);
+    EXPECT_EQ(count("mid:c"), 100);
+    EXPECT_EQ(count("slow:c"), 20);
+}
+
+TEST(Scheduler, OverrunDoesNotBurst) {
+    std::vector<std::string> log;
+    LoggingSubsystem slow{"slow", log};
+    Scheduler sched{5_ms};
+    sched.Register(slow, {50_Hz, kRunAlways});
+    sched.Tick(0_s, kRunTeleop);
+    EXPECT_EQ(log.size(), 3u);
+    // stall for several of its periods, it should run once then resume its
+    // normal rate
+    sched.Tick(100_ms, kRunTeleop);
+    EXPECT_EQ(log.size(), 6u);
+    sched.Tick(105_ms, kRunTeleop);
+    sched.Tick(110_ms, kRunTeleop);
+    sched.Tick(115_ms, kRunTeleop);
+    EXPECT_EQ(log.size(), 6u);
+    sched.Tick(120_ms, kRunTeleop);
+    EXPECT_EQ(log.size(), 9u);
+}
+
+TEST(Scheduler, Modes) {
+    std::vector<std::string> log;
+    LoggingSubsystem enabled{"enabled", log};
+    Scheduler sched{5_ms};
+    sched.Register(enabled, {200_Hz, kRunAutonomous | kRunTeleop});
+    sched.Tick(0_s, kRunDisabled);
+    sched.Tick(5_ms, kRunTest);
+    EXPECT_TRUE(log.empty());
+    sched.Tick(10_ms, kRunAutonomous);
+    EXPECT_EQ(log.size(), 3u);
+}
+
+TEST(Scheduler, InvalidRate) {
+    std::vector<std::string> log;
+    LoggingSubsystem s{"s", log};
+    Scheduler sched{5_ms};
+    EXPECT_THROW(sched.Register(s, {300_Hz, kRunAlways}),
+                 std::invalid_argument);
+    EXPECT_THROW(sched.Register(s, {30_Hz, kRunAlways}),
+                 std::invalid_argument);
+    EXPECT_THROW(sched.Register(s, {0_Hz, kRunAlways}), std::invalid_argument);
+}
@@ -1,7 +1,10 @@
+#pragma once
+
 #include <cstddef>
 #include <cstdint>
 
 #include <cbor.h>
+#include <copcomp/cbor.hpp>
 
 namespace team114
 {
@@ -24,10 +27,18 @@ namespace vision
     }
 
 struct Packet {
+    // capture time on the coprocessor's monotonic clock, see ClockSync for
+    // the RIO's
     int64_t micros;
     float x;
     float y;
 
+    // for copcomp::cbor, which Connection uses in place of the methods below
+    COPCOMP_CBOR_FIELD(Packet, micros);
+    COPCOMP_CBOR_FIELD(Packet, x);
+    COPCOMP_CBOR_FIELD(Packet, y);
+    using CborFields = copcomp::cbor::FieldList<CborField_micros, CborField_x, CborField_y>;
+
     size_t cbor_serialize(uint8_t *buffer, size_t maxlen) const
     {
         CborEncoder encoder, arrayEncoder;
@@ -62,6 +73,7 @@ struct Packet {
         CBOR_CHCK(cbor_value_advance(&inArray));
         CBOR_VAL(cbor_value_is_float(&inArray));
         CBOR_CHCK(cbor_value_get_float(&inArray, &(result.y)));
+        CBOR_CHCK(cbor_value_advance(&inArray));
 
         CBOR_CHCK(cbor_value_leave_container(&value, &inArray));
         return result;
@@ -0,0 +1,425 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <type_traits>
+
+// Compile time CBOR codec for fixed layout items, the hot path alternative to
+// the tinycbor cbor_serialize/cbor_deserialize methods. A struct opts in by
+// listing its fields:
+//
+//     struct Packet {
+//         int64_t micros;
+//         float x;
+//         COPCOMP_CBOR_FIELD(Packet, micros);
+//         COPCOMP_CBOR_FIELD(Packet, x);
+//         using CborFields = copcomp::cbor::FieldList<CborField_micros, CborField_x>;
+//     };
+//
+// Items are written as a definite length array of the fields in order, the
+// same bytes tinycbor produces and what serde_cbor reads into a struct. Both
+// that and the map of field names serde_cbor writes by default are accepted
+// when decoding, with integers of any width and half/single/double floats.
+// Nothing here allocates or throws.
+
+namespace team114
+{
+namespace copcomp
+{
+namespace cbor
+{
+
+enum class Error : uint8_t {
+    None = 0,
+    BufferTooSmall, // encode buffer under max_encoded_size, or an oversized datagram
+    UnexpectedEnd,
+    TypeMismatch,
+    WrongLength, // wrong field count, or bytes left after the item
+    UnknownField,
+    MissingField,
+    OutOfRange,
+    NoData, // nothing was received, see errno
+};
+
+template <typename... Fields> struct FieldList {
+};
+
+// Declares CborField_<member>, a descriptor of one field of Struct
+#define COPCOMP_CBOR_FIELD(Struct, member)                                                                                                 \
+    struct CborField_##member {                                                                                                            \
+        using type = decltype(Struct::member);                                                                                             \
+        static constexpr const char *name() { return #member; }                                                                            \
+        static constexpr size_t name_len() { return sizeof(#member) - 1; }                                                                 \
+        static type &get(Struct &s) { return s.member; }                                                                                   \
+        static const type &get(const Struct &s) { return s.member; }                                                                       \
+    }
+
+namespace detail
+{
+
+constexpr uint8_t kMajorUnsigned = 0;
+constexpr uint8_t kMajorNegative = 1;
+constexpr uint8_t kMajorText = 3;
+constexpr uint8_t kMajorArray = 4;
+constexpr uint8_t kMajorMap = 5;
+constexpr uint8_t kMajorSimple = 7;
+
+constexpr uint8_t kFalse = 0xf4;
+constexpr uint8_t kTrue = 0xf5;
+constexpr uint8_t kHalf = 0xf9;
+constexpr uint8_t kSingle = 0xfa;
+constexpr uint8_t kDouble = 0xfb;
+
+constexpr size_t head_size(uint64_t arg)
+{
+    return arg < 24 ? 1 : arg <= 0xff ? 2 : arg <= 0xffff ? 3 : arg <= 0xffffffff ? 5 : 9;
+}
+
+constexpr size_t sum(std::initializer_list<size_t> sizes)
+{
+    size_t total = 0;
+    for (size_t s : sizes) {
+        total += s;
+    }
+    return total;
+}
+
+inline uint8_t *put_be(uint8_t *p, uint64_t v, size_t bytes)
+{
+    for (size_t i = bytes; i > 0; --i) {
+        *p++ = static_cast<uint8_t>(v >> (8 * (i - 1)));
+    }
+    return p;
+}
+
+// shortest form, as tinycbor and serde_cbor both write
+inline uint8_t *put_head(uint8_t *p, uint8_t major, uint64_t arg)
+{
+    uint8_t ib = static_cast<uint8_t>(major << 5);
+    if (arg < 24) {
+        *p++ = ib | static_cast<uint8_t>(arg);
+    } else if (arg <= 0xff) {
+        *p++ = ib | 24;
+        p = put_be(p, arg, 1);
+    } else if (arg <= 0xffff) {
+        *p++ = ib | 25;
+        p = put_be(p, arg, 2);
+    } else if (arg <= 0xffffffff) {
+        *p++ = ib | 26;
+        p = put_be(p, arg, 4);
+    } else {
+        *p++ = ib | 27;
+        p = put_be(p, arg, 8);
+    }
+    return p;
+}
+
+struct Reader {
+    const uint8_t *p;
+    const uint8_t *end;
+
+    // initial byte and argument, for simple values the argument is the raw bits
+    Error head(uint8_t &major, uint8_t &info, uint64_t &arg)
+    {
+        if (p == end) {
+            return Error::UnexpectedEnd;
+        }
+        major = *p >> 5;
+        info = *p & 0x1f;
+        ++p;
+        size_t bytes;
+        if (info < 24) {
+            arg = info;
+            return Error::None;
+        } else if (info <= 27) {
+            bytes = size_t{1} << (info - 24);
+        } else {
+            // reserved, or indefinite length which serde_cbor never writes for structs
+            return Error::TypeMismatch;
+        }
+        if (static_cast<size_t>(end - p) < bytes) {
+            return Error::UnexpectedEnd;
+        }
+        arg = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            arg = (arg << 8) | *p++;
+        }
+        return Error::None;
+    }
+};
+
+inline float half_to_float(uint16_t h)
+{
+    uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1f;
+    uint32_t mant = h & 0x3ff;
+    uint32_t bits;
+    if (exp == 0x1f) {
+        bits = sign | 0x7f800000 | (mant << 13);
+    } else if (exp != 0) {
+        bits = sign | ((exp + 112) << 23) | (mant << 13);
+    } else if (mant == 0) {
+        bits = sign;
+    } else {
+        // subnormal half is a normal float
+        exp = 113;
+        while ((mant & 0x400) == 0) {
+            mant <<= 1;
+            --exp;
+        }
+        bits = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+    }
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+template <typename T, typename Enable = void> struct Value;
+
+template <typename T> struct Value<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+    static constexpr size_t max_size = 1 + (sizeof(T) == 1 ? 1 : sizeof(T));
+
+    static uint8_t *encode(uint8_t *p, T v) { return encode(p, v, std::is_signed<T>{}); }
+    static uint8_t *encode(uint8_t *p, T v, std::true_type)
+    {
+        if (v < 0) {
+            // -1 - v without overflowing at the minimum
+            return put_head(p, kMajorNegative, static_cast<uint64_t>(-(v + 1)));
+        }
+        return put_head(p, kMajorUnsigned, static_cast<uint64_t>(v));
+    }
+    static uint8_t *encode(uint8_t *p, T v, std::false_type) { return put_head(p, kMajorUnsigned, v); }
+
+    static Error decode(Reader &r, T &out)
+    {
+        uint8_t major, info;
+        uint64_t arg;
+        Error err = r.head(major, info, arg);
+        if (err != Error::None) {
+            return err;
+        }
+        constexpr uint64_t max = static_cast<uint64_t>(std::numeric_limits<T>::max());
+        if (major == kMajorUnsigned) {
+            if (arg > max) {
+                return Error::OutOfRange;
+            }
+            out = static_cast<T>(arg);
+            return Error::None;
+        }
+        if (major == kMajorNegative) {
+            // the most negative value is -1 - max for two's complement T, never for unsigned T
+            if (!std::is_signed<T>::value || arg > max) {
+                return Error::OutOfRange;
+            }
+            out = static_cast<T>(-static_cast<T>(arg) - 1);
+            return Error::None;
+        }
+        return Error::TypeMismatch;
+    }
+};
+
+template <typename T> struct Value<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    using Bits = typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type;
+    static_assert(sizeof(T) == sizeof(Bits), "float and double only");
+    static constexpr size_t max_size = 1 + sizeof(T);
+
+    // always full width, as tinycbor does
+    static uint8_t *encode(uint8_t *p, T v)
+    {
+        Bits bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        *p++ = sizeof(T) == 4 ? kSingle : kDouble;
+        return put_be(p, bits, sizeof(bits));
+    }
+
+    static Error decode(Reader &r, T &out)
+    {
+        uint8_t major, info;
+        uint64_t arg;
+        Error err = r.head(major, info, arg);
+        if (err != Error::None) {
+            return err;
+        }
+        if (major != kMajorSimple) {
+            return Error::TypeMismatch;
+        }
+        switch (info) {
+        case kHalf & 0x1f:
+            out = static_cast<T>(half_to_float(static_cast<uint16_t>(arg)));
+            return Error::None;
+        case kSingle & 0x1f: {
+            uint32_t bits = static_cast<uint32_t>(arg);
+            float f;
+            std::memcpy(&f, &bits, sizeof(f));
+            out = static_cast<T>(f);
+            return Error::None;
+        }
+        case kDouble & 0x1f: {
+            double d;
+            std::memcpy(&d, &arg, sizeof(d));
+            out = static_cast<T>(d);
+            return Error::None;
+        }
+        default:
+            return Error::TypeMismatch;
+        }
+    }
+};
+
+template <> struct Value<bool> {
+    static constexpr size_t max_size = 1;
+
+    static uint8_t *encode(uint8_t *p, bool v)
+    {
+        *p++ = v ? kTrue : kFalse;
+        return p;
+    }
+
+    static Error decode(Reader &r, bool &out)
+    {
+        if (r.p == r.end) {
+            return Error::UnexpectedEnd;
+        }
+        if (*r.p != kTrue && *r.p != kFalse) {
+            return Error::TypeMismatch;
+        }
+        out = *r.p++ == kTrue;
+        return Error::None;
+    }
+};
+
+template <typename... F> constexpr size_t max_array_size(FieldList<F...>)
+{
+    return head_size(sizeof...(F)) + sum({Value<typename F::type>::max_size...});
+}
+
+template <typename... F> constexpr size_t max_map_size(FieldList<F...>)
+{
+    return head_size(sizeof...(F)) + sum({(head_size(F::name_len()) + F::name_len() + Value<typename F::type>::max_size)...});
+}
+
+template <typename S> uint8_t *encode_fields(uint8_t *p, const S &, FieldList<>) { return p; }
+template <typename S, typename F, typename... Rest> uint8_t *encode_fields(uint8_t *p, const S &s, FieldList<F, Rest...>)
+{
+    p = Value<typename F::type>::encode(p, F::get(s));
+    return encode_fields(p, s, FieldList<Rest...>{});
+}
+
+template <typename S> Error decode_fields(Reader &, S &, FieldList<>) { return Error::None; }
+template <typename S, typename F, typename... Rest> Error decode_fields(Reader &r, S &s, FieldList<F, Rest...>)
+{
+    Error err = Value<typename F::type>::decode(r, F::get(s));
+    if (err != Error::None) {
+        return err;
+    }
+    return decode_fields(r, s, FieldList<Rest...>{});
+}
+
+template <typename S> Error decode_named(Reader &, S &, const uint8_t *, size_t, uint32_t &, size_t, FieldList<>)
+{
+    return Error::UnknownField;
+}
+template <typename S, typename F, typename... Rest>
+Error decode_named(Reader &r, S &s, const uint8_t *key, size_t key_len, uint32_t &found, size_t idx, FieldList<F, Rest...>)
+{
+    if (key_len != F::name_len() || std::memcmp(key, F::name(), key_len) != 0) {
+        return decode_named(r, s, key, key_len, found, idx + 1, FieldList<Rest...>{});
+    }
+    found |= uint32_t{1} << idx;
+    return Value<typename F::type>::decode(r, F::get(s));
+}
+
+template <typename... F> constexpr size_t field_count(FieldList<F...>) { return sizeof...(F); }
+
+} // namespace detail
+
+template <typename T, typename Enable = void> struct HasFields : std::false_type {
+};
+template <typename T> struct HasFields<T, typename std::conditional<false, typename T::CborFields, void>::type> : std::true_type {
+};
+
+// Largest encoding encode() writes
+template <typename S> constexpr size_t max_encoded_size() { return detail::max_array_size(typename S::CborFields{}); }
+
+// Largest valid encoding decode() accepts, serde_cbor's field name map
+template <typename S> constexpr size_t max_wire_size()
+{
+    return max_encoded_size<S>() > detail::max_map_size(typename S::CborFields{}) ? max_encoded_size<S>()
+                                                                                    : detail::max_map_size(typename S::CborFields{});
+}
+
+// Stack buffer that always fits an encoded S
+template <typename S> using Buffer = std::array<uint8_t, max_encoded_size<S>()>;
+
+// Returns bytes written, 0 if len is under max_encoded_size<S>()
+template <typename S> size_t encode(const S &s, uint8_t *buf, size_t len)
+{
+    using Fields = typename S::CborFields;
+    if (len < max_encoded_size<S>()) {
+        return 0;
+    }
+    uint8_t *p = detail::put_head(buf, detail::kMajorArray, detail::field_count(Fields{}));
+    p = detail::encode_fields(p, s, Fields{});
+    return static_cast<size_t>(p - buf);
+}
+
+template <typename S> size_t encode(const S &s, Buffer<S> &buf) { return encode(s, buf.data(), buf.size()); }
+
+// Decodes in place, out is partially written if this fails
+template <typename S> Error decode(const uint8_t *buf, size_t len, S &out)
+{
+    using Fields = typename S::CborFields;
+    constexpr size_t kFields = detail::field_count(Fields{});
+    static_assert(kFields <= 32, "found fields are tracked in a uint32_t");
+    detail::Reader r{buf, buf + len};
+    uint8_t major, info;
+    uint64_t arg;
+    Error err = r.head(major, info, arg);
+    if (err != Error::None) {
+        return err;
+    }
+    if (major != detail::kMajorArray && major != detail::kMajorMap) {
+        return Error::TypeMismatch;
+    }
+    if (arg != kFields) {
+        return Error::WrongLength;
+    }
+    if (major == detail::kMajorArray) {
+        err = detail::decode_fields(r, out, Fields{});
+    } else {
+        uint32_t found = 0;
+        for (size_t i = 0; i < kFields && err == Error::None; ++i) {
+            err = r.head(major, info, arg);
+            if (err != Error::None) {
+                break;
+            }
+            if (major != detail::kMajorText) {
+                err = Error::TypeMismatch;
+                break;
+            }
+            if (static_cast<uint64_t>(r.end - r.p) < arg) {
+                err = Error::UnexpectedEnd;
+                break;
+            }
+            const uint8_t *key = r.p;
+            r.p += arg;
+            err = detail::decode_named(r, out, key, static_cast<size_t>(arg), found, 0, Fields{});
+        }
+        if (err == Error::None && found != (kFields == 32 ? ~uint32_t{0} : (uint32_t{1} << kFields) - 1)) {
+            // a repeated key in place of one of ours
+            err = Error::MissingField;
+        }
+    }
+    if (err == Error::None && r.p != r.end) {
+        err = Error::WrongLength;
+    }
+    return err;
+}
+
+} // namespace cbor
+} // namespace copcomp
+} // namespace team114
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <copcomp/cbor.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+// NTP style clock synchronization between the two ends of a Connection. The
+// side that wants remote timestamps in its own clock (the RIO) sends SyncPings,
+// the other (the coprocessor) answers with SyncPongs stamped on its clock, and
+// ClockSync turns the round trips into an offset and drift estimate:
+//
+//     client  t0 ---ping---> t1  server
+//             t3 <---pong--- t2
+//
+//     offset = ((t1 - t0) + (t2 - t3)) / 2    (remote minus local)
+//     delay  = (t3 - t0) - (t2 - t1)
+//
+// The offset is only off by the asymmetry of the two legs, at most half the
+// delay, so the estimate follows the lowest delay samples. A server that takes
+// t1 when it gets around to reading the ping, not when it arrived, adds its
+// wait to one leg; Connection::answer_sync_pings uses the kernel's receive
+// stamp for that reason. Everything is in microseconds; the clocks
+// themselves are up to the caller (monotonic_micros below on the coprocessor,
+// the FPGA clock on the RIO).
+//
+// The messages have 2 and 4 fields, so they can share a socket with items of
+// other shapes (a c2019 Packet has 3) and be told apart by decoding.
+
+namespace team114
+{
+namespace copcomp
+{
+
+struct SyncPing {
+    int64_t seq;
+    int64_t t0; // client send time
+
+    COPCOMP_CBOR_FIELD(SyncPing, seq);
+    COPCOMP_CBOR_FIELD(SyncPing, t0);
+    using CborFields = cbor::FieldList<CborField_seq, CborField_t0>;
+};
+
+struct SyncPong {
+    int64_t seq;
+    int64_t t0; // echoed from the ping
+    int64_t t1; // server receive time
+    int64_t t2; // server send time
+
+    COPCOMP_CBOR_FIELD(SyncPong, seq);
+    COPCOMP_CBOR_FIELD(SyncPong, t0);
+    COPCOMP_CBOR_FIELD(SyncPong, t1);
+    COPCOMP_CBOR_FIELD(SyncPong, t2);
+    using CborFields = cbor::FieldList<CborField_seq, CborField_t0, CborField_t1, CborField_t2>;
+};
+
+// CLOCK_MONOTONIC, the clock V4L2 stamps buffers with
+inline int64_t monotonic_micros()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Client side estimate of remote = local + offset(local), with the offset
+// linear in local time to follow drift. Header only and socket free, so the
+// RIO code can use it without the rest of copcomp.
+class ClockSync
+{
+  public:
+    static constexpr size_t WINDOW = 32;
+    static constexpr size_t MIN_SAMPLES = 4;
+    // drift is only estimated once the anchor is this old
+    static constexpr int64_t MIN_DRIFT_SPAN = 10000000;
+    // anything past this is a bad sample, not a bad crystal
+    static constexpr double MAX_DRIFT = 500e-6;
+
+    // Feeds one round trip, t3 being the local time the pong arrived. False
+    // and ignored if the timestamps are inconsistent.
+    bool add_sample(int64_t t0, int64_t t1, int64_t t2, int64_t t3)
+    {
+        int64_t delay = (t3 - t0) - (t2 - t1);
+        if (t3 < t0 || t2 < t1 || delay < 0) {
+            return false;
+        }
+        Sample &s = samples_[next_ % WINDOW];
+        s.local = t0 + (t3 - t0) / 2;
+        s.offset = ((t1 - t0) + (t2 - t3)) / 2;
+        s.delay = delay;
+        next_++;
+        fit();
+        return true;
+    }
+
+    // Decodes a SyncPong and feeds it, for sockets carrying other items too.
+    // False if buf is not a pong.
+    bool handle(const uint8_t *buf, size_t len, int64_t now)
+    {
+        SyncPong pong;
+        if (cbor::decode(buf, len, pong) != cbor::Error::None) {
+            return false;
+        }
+        add_sample(pong.t0, pong.t1, pong.t2, now);
+        return true;
+    }
+
+    bool synced() const { return next_ >= MIN_SAMPLES; }
+
+    int64_t to_remote(int64_t local) const
+    {
+        double dx = static_cast<double>(local - ref_local_);
+        return local + ref_offset_ + std::llround(drift_ * dx);
+    }
+
+    int64_t to_local(int64_t remote) const
+    {
+        // remote = ref_local + ref_offset + (local - ref_local) * (1 + drift)
+        double dr = static_cast<double>(remote - ref_local_ - ref_offset_);
+        return ref_local_ + std::llround(dr / (1.0 + drift_));
+    }
+
+    int64_t offset() const { return ref_offset_; }
+    double drift() const { return drift_; }
+    // of the best sample in the window, the bound on the offset error is half
+    int64_t min_delay() const { return min_delay_; }
+
+  private:
+    struct Sample {
+        int64_t local;
+        int64_t offset;
+        int64_t delay;
+    };
+
+    // The offset comes from the lowest delay sample in the window, the drift
+    // from how that moved since an anchor sample taken once the window first
+    // filled. Asymmetry errors are about a millisecond per sample either way,
+    // so drift only becomes accurate over tens of seconds, and the anchor is
+    // kept for good unless the remote clock jumps (a restart).
+    void fit()
+    {
+        size_t count = next_ < WINDOW ? next_ : WINDOW;
+        const Sample *best = std::min_element(samples_.begin(), samples_.begin() + count,
+                                              [](const Sample &a, const Sample &b) { return a.delay < b.delay; });
+        min_delay_ = best->delay;
+        ref_local_ = best->local;
+        ref_offset_ = best->offset;
+        if (count < WINDOW) {
+            return;
+        }
+        if (!anchored_) {
+            anchor_ = *best;
+            anchored_ = true;
+            return;
+        }
+        int64_t span = best->local - anchor_.local;
+        if (span < MIN_DRIFT_SPAN) {
+            return;
+        }
+        double slope = static_cast<double>(best->offset - anchor_.offset) / static_cast<double>(span);
+        if (slope > MAX_DRIFT || slope < -MAX_DRIFT) {
+            anchor_ = *best;
+            drift_ = 0;
+            return;
+        }
+        drift_ = slope;
+    }
+
+    std::array<Sample, WINDOW> samples_{};
+    size_t next_ = 0;
+    int64_t ref_local_ = 0;
+    int64_t ref_offset_ = 0;
+    double drift_ = 0;
+    int64_t min_delay_ = 0;
+    Sample anchor_{};
+    bool anchored_ = false;
+};
+
+} // namespace copcomp
+} // namespace team114
@@ -1,22 +1,43 @@
+#include <algorithm>
 #include <array>
+#include <cerrno>
+#include <copcomp/cbor.hpp>
+#include <copcomp/clock_sync.hpp>
 #include <cstdint>
 #include <inetclientdgram.hpp>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <type_traits>
 
 namespace team114
 {
 namespace copcomp
 {
 
+// Syscall and datagram counts since the Connection was made, for the benches
+struct IoStats {
+    uint64_t syscalls = 0;
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    uint64_t dropped = 0; // received but undecodable, or stale in recv_latest
+};
+
 class Connection
 {
   public:
     Connection(const std::string &dsthost, const std::string &dstport);
+    // Also binds the local port, so the peer can send to us at a known address
+    Connection(const std::string &dsthost, const std::string &dstport, const std::string &bindport);
     virtual ~Connection();
-    template <typename T> void write_item(const T &item)
-    {
-        size_t bytes = item.cbor_serialize(data, BUFFER_LEN);
-        udp.snd(data, bytes);
-    }
+
+    // most datagrams moved by one sendmmsg/recvmmsg
+    static constexpr size_t MAX_BATCH = 32;
+    // largest datagram recv_each takes
+    static constexpr size_t MAX_SMALL_DATAGRAM = 256;
+
+    // Items with CborFields (see cbor.hpp) are encoded on the stack, anything
+    // else through its cbor_serialize into the shared buffer
+    template <typename T> void write_item(const T &item) { write_item(item, cbor::HasFields<T>{}); }
 
     // template <typename T> void write_item_to(const T &item, std::string &dsthost, std::string &dstport)
     // {
@@ -31,6 +52,127 @@ class Connection
         return t;
     }
 
+    // Receives one item with CborFields into out, on the stack and without
+    // throwing. NoData if nothing was waiting (the socket is nonblocking) or
+    // recv() failed, see errno.
+    template <typename T> cbor::Error recv_fixed(T &out)
+    {
+        // one spare byte to tell an oversized datagram from one that fits
+        std::array<uint8_t, cbor::max_wire_size<T>() + 1> buf;
+        ssize_t bytes = ::recv(udp.getfd(), buf.data(), buf.size(), MSG_TRUNC);
+        stats_.syscalls++;
+        if (bytes < 0) {
+            return cbor::Error::NoData;
+        }
+        stats_.received++;
+        cbor::Error err = static_cast<size_t>(bytes) >= buf.size() ? cbor::Error::BufferTooSmall
+                                                                     : cbor::decode(buf.data(), static_cast<size_t>(bytes), out);
+        if (err != cbor::Error::None) {
+            stats_.dropped++;
+        }
+        return err;
+    }
+
+    // Sends count items with CborFields, MAX_BATCH datagrams per sendmmsg, so
+    // all the targets of a frame leave in one syscall. Returns how many were
+    // sent, less than count if the socket buffer filled up or sendmmsg failed.
+    template <typename T> size_t write_items(const T *items, size_t count)
+    {
+        std::array<cbor::Buffer<T>, MAX_BATCH> bufs;
+        std::array<iovec, MAX_BATCH> iovs;
+        std::array<mmsghdr, MAX_BATCH> msgs;
+        size_t sent = 0;
+        while (sent < count) {
+            size_t n = std::min(count - sent, MAX_BATCH);
+            for (size_t i = 0; i < n; ++i) {
+                iovs[i].iov_base = bufs[i].data();
+                iovs[i].iov_len = cbor::encode(items[sent + i], bufs[i]);
+            }
+            size_t done = send_batch(msgs.data(), iovs.data(), n);
+            sent += done;
+            if (done < n) {
+                break;
+            }
+        }
+        return sent;
+    }
+
+    // Receives up to max items with CborFields into out with one recvmmsg,
+    // without blocking. Undecodable datagrams are dropped. Returns how many
+    // were decoded; call again until it returns 0 to drain the socket.
+    template <typename T> size_t recv_items(T *out, size_t max)
+    {
+        RecvBatch<cbor::max_wire_size<T>() + 1> batch;
+        size_t got = recv_batch(batch, std::min(max, MAX_BATCH));
+        size_t decoded = 0;
+        for (size_t i = 0; i < got; ++i) {
+            if (decode_received(batch, i, out[decoded])) {
+                decoded++;
+            }
+        }
+        return decoded;
+    }
+
+    // Receives up to MAX_BATCH datagrams of at most MAX_SMALL_DATAGRAM bytes
+    // with one recvmmsg, without blocking, and calls f(buf, len, age) on each,
+    // for sockets that carry more than one kind of item. age is how many
+    // microseconds ago the kernel received it, to stamp arrival on the
+    // caller's clock. f returns whether it used the datagram; the rest count
+    // as dropped. Returns how many arrived.
+    template <typename F> size_t recv_each(F f)
+    {
+        enable_receive_stamps();
+        RecvBatch<MAX_SMALL_DATAGRAM + 1, true> batch;
+        size_t got = recv_batch(batch, MAX_BATCH);
+        int64_t now = realtime_micros();
+        for (size_t i = 0; i < got; ++i) {
+            const mmsghdr &msg = batch.msgs[i];
+            bool fits = !(msg.msg_hdr.msg_flags & MSG_TRUNC) && msg.msg_len < batch.bufs[i].size();
+            if (!fits || !f(static_cast<const uint8_t *>(batch.bufs[i].data()), static_cast<size_t>(msg.msg_len), receive_age(msg, now))) {
+                stats_.dropped++;
+            }
+        }
+        return got;
+    }
+
+    // Client side of ClockSync, stamped with the caller's clock. Feed the
+    // pongs that come back to ClockSync::handle with now - age, see
+    // recv_each.
+    void send_sync_ping(int64_t now);
+    // Server side, answers every SyncPing waiting on the socket, stamped on
+    // the monotonic clock with the kernel's receive time, so it need not be
+    // called the moment a ping arrives. Anything else waiting is dropped.
+    // Returns how many were answered.
+    size_t answer_sync_pings();
+
+    // Drains everything queued on the socket and keeps only the newest item
+    // that decodes, for consumers that only care about the latest state. The
+    // rest are dropped as stale. False if nothing usable was waiting.
+    template <typename T> bool recv_latest(T &out)
+    {
+        RecvBatch<cbor::max_wire_size<T>() + 1> batch;
+        T item;
+        bool found = false;
+        size_t got;
+        do {
+            got = recv_batch(batch, MAX_BATCH);
+            // newest first, so at most one datagram per batch is decoded
+            size_t i = got;
+            while (i > 0) {
+                if (decode_received(batch, --i, item)) {
+                    stats_.dropped += found ? 1 : 0; // the one from an earlier batch
+                    found = true;
+                    out = item;
+                    break;
+                }
+            }
+            stats_.dropped += i;
+        } while (got == MAX_BATCH);
+        return found;
+    }
+
+    const IoStats &stats() const { return stats_; }
+
     // template <typename T> T recv_item_from(std::string &srchost, std::string &srcport)
     // {
     //     size_t bytes = udp.rcvfrom(data, BUFFER_LEN, srchost, srcport);
@@ -39,9 +181,70 @@ class Connection
     // }
 
   private:
+    template <typename T> void write_item(const T &item, std::true_type)
+    {
+        cbor::Buffer<T> buf;
+        size_t bytes = cbor::encode(item, buf);
+        udp.snd(buf.data(), bytes);
+        stats_.syscalls++;
+        stats_.sent++;
+    }
+    template <typename T> void write_item(const T &item, std::false_type)
+    {
+        size_t bytes = item.cbor_serialize(data, BUFFER_LEN);
+        udp.snd(data, bytes);
+        stats_.syscalls++;
+        stats_.sent++;
+    }
+
+    // LEN has one spare byte per datagram, as in recv_fixed. STAMPED batches
+    // have room for the kernel's receive timestamps.
+    static constexpr size_t STAMP_SPACE = CMSG_SPACE(sizeof(timespec));
+    template <size_t LEN, bool STAMPED = false> struct RecvBatch {
+        std::array<std::array<uint8_t, LEN>, MAX_BATCH> bufs;
+        std::array<iovec, MAX_BATCH> iovs;
+        std::array<mmsghdr, MAX_BATCH> msgs;
+        std::array<std::array<char, STAMPED ? STAMP_SPACE : 1>, MAX_BATCH> controls;
+    };
+
+    template <size_t LEN, bool STAMPED> size_t recv_batch(RecvBatch<LEN, STAMPED> &batch, size_t count)
+    {
+        return recv_batch(batch.msgs.data(), batch.iovs.data(), batch.bufs.data(), LEN, STAMPED ? batch.controls.data() : nullptr,
+                          batch.controls[0].size(), count);
+    }
+
+    template <size_t LEN, bool STAMPED, typename T> bool decode_received(const RecvBatch<LEN, STAMPED> &batch, size_t i, T &out)
+    {
+        const mmsghdr &msg = batch.msgs[i];
+        bool ok = !(msg.msg_hdr.msg_flags & MSG_TRUNC) && msg.msg_len < batch.bufs[i].size() &&
+                  cbor::decode(batch.bufs[i].data(), msg.msg_len, out) == cbor::Error::None;
+        if (!ok) {
+            stats_.dropped++;
+        }
+        return ok;
+    }
+
+    // sendmmsg of iovs[0, count), retrying after partial sends. Returns how
+    // many were sent.
+    size_t send_batch(mmsghdr *msgs, iovec *iovs, size_t count);
+    // One nonblocking recvmmsg of up to count datagrams into bufs, each
+    // buf_len bytes apart, and their timestamps into controls if not null.
+    // Returns how many arrived, 0 on EAGAIN or error.
+    size_t recv_batch(mmsghdr *msgs, iovec *iovs, void *bufs, size_t buf_len, void *controls, size_t control_len, size_t count);
+
+    // SO_TIMESTAMPNS, once
+    void enable_receive_stamps();
+    // the clock of the kernel's receive stamps
+    static int64_t realtime_micros();
+    // now - the receive stamp of msg, 0 if it has none
+    static int64_t receive_age(const mmsghdr &msg, int64_t now);
+
     static constexpr size_t BUFFER_LEN = 65 * 1024; // enough to store the max UDP packet size
     libsocket::inet_dgram_client udp;
     uint8_t *data;
+    IoStats stats_;
+    int64_t sync_seq_ = 0;
+    bool receive_stamps_ = false;
 };
 
 } // namespace copcomp
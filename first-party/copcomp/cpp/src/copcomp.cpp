@@ -1,6 +1,9 @@
 #include <assert.h>
+#include <cstring>
 #include <copcomp/copcomp.hpp>
+#include <exception.hpp>
 #include <netdb.h>
+#include <netinet/in.h>
 #include <netinet/tcp.h>
 
 // TODO research quickack to reduce latency:
@@ -15,6 +18,10 @@ namespace copcomp
 
 using namespace std;
 
+constexpr size_t Connection::MAX_BATCH;
+constexpr size_t Connection::MAX_SMALL_DATAGRAM;
+constexpr size_t Connection::STAMP_SPACE;
+
 Connection::Connection(const string &dsthost, const string &dstport) : udp(dsthost, dstport, LIBSOCKET_IPv4, SOCK_NONBLOCK), data()
 {
     data = new uint8_t[BUFFER_LEN]();
@@ -23,7 +30,132 @@ Connection::Connection(const string &dsthost, const string &dstport) : udp(dstho
     // udp.set_sock_opt(SOL_SOCKET, SO_RCVTIMEO, (char *)(&t), sizeof(t));
 }
 
+Connection::Connection(const string &dsthost, const string &dstport, const string &bindport)
+    : udp(LIBSOCKET_IPv4, SOCK_NONBLOCK), data()
+{
+    int one = 1;
+    udp.set_sock_opt(SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&one), sizeof(one));
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(static_cast<uint16_t>(stoi(bindport)));
+    if (::bind(udp.getfd(), reinterpret_cast<sockaddr *>(&local), sizeof(local)) < 0) {
+        throw libsocket::socket_exception(__FILE__, __LINE__, "Connection: could not bind port " + bindport);
+    }
+    udp.connect(dsthost, dstport);
+    data = new uint8_t[BUFFER_LEN]();
+}
+
 Connection::~Connection() { delete[] data; }
 
+void Connection::send_sync_ping(int64_t now)
+{
+    SyncPing ping{sync_seq_++, now};
+    write_items(&ping, 1);
+}
+
+size_t Connection::answer_sync_pings()
+{
+    enable_receive_stamps();
+    RecvBatch<cbor::max_wire_size<SyncPing>() + 1, true> batch;
+    std::array<SyncPong, MAX_BATCH> pongs;
+    size_t answered = 0;
+    size_t got;
+    do {
+        got = recv_batch(batch, MAX_BATCH);
+        // arrival on the monotonic clock, so pings that waited for the frame
+        // loop still get their real t1
+        int64_t real = realtime_micros();
+        int64_t mono = monotonic_micros();
+        size_t n = 0;
+        for (size_t i = 0; i < got; ++i) {
+            SyncPing ping;
+            if (decode_received(batch, i, ping)) {
+                pongs[n++] = SyncPong{ping.seq, ping.t0, mono - receive_age(batch.msgs[i], real), 0};
+            }
+        }
+        int64_t t2 = monotonic_micros();
+        for (size_t i = 0; i < n; ++i) {
+            pongs[i].t2 = t2;
+        }
+        answered += write_items(pongs.data(), n);
+    } while (got == MAX_BATCH);
+    return answered;
+}
+
+size_t Connection::send_batch(mmsghdr *msgs, iovec *iovs, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        msgs[i] = mmsghdr{};
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    size_t sent = 0;
+    while (sent < count) {
+        int n = ::sendmmsg(udp.getfd(), msgs + sent, static_cast<unsigned>(count - sent), 0);
+        stats_.syscalls++;
+        if (n <= 0) {
+            break;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    stats_.sent += sent;
+    return sent;
+}
+
+size_t Connection::recv_batch(mmsghdr *msgs, iovec *iovs, void *bufs, size_t buf_len, void *controls, size_t control_len, size_t count)
+{
+    uint8_t *buf = static_cast<uint8_t *>(bufs);
+    char *control = static_cast<char *>(controls);
+    for (size_t i = 0; i < count; ++i) {
+        iovs[i].iov_base = buf + i * buf_len;
+        iovs[i].iov_len = buf_len;
+        msgs[i] = mmsghdr{};
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        if (control) {
+            msgs[i].msg_hdr.msg_control = control + i * control_len;
+            msgs[i].msg_hdr.msg_controllen = control_len;
+        }
+    }
+    int n = ::recvmmsg(udp.getfd(), msgs, static_cast<unsigned>(count), MSG_DONTWAIT, nullptr);
+    stats_.syscalls++;
+    if (n <= 0) {
+        return 0;
+    }
+    stats_.received += static_cast<size_t>(n);
+    return static_cast<size_t>(n);
+}
+
+void Connection::enable_receive_stamps()
+{
+    if (!receive_stamps_) {
+        int one = 1;
+        udp.set_sock_opt(SOL_SOCKET, SO_TIMESTAMPNS, reinterpret_cast<const char *>(&one), sizeof(one));
+        receive_stamps_ = true;
+    }
+}
+
+int64_t Connection::realtime_micros()
+{
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+int64_t Connection::receive_age(const mmsghdr &msg, int64_t now)
+{
+    // CMSG_NXTHDR takes a non-const msghdr
+    msghdr &hdr = const_cast<msghdr &>(msg.msg_hdr);
+    for (cmsghdr *c = CMSG_FIRSTHDR(&hdr); c; c = CMSG_NXTHDR(&hdr, c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+            timespec ts;
+            memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+            return now - (static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000);
+        }
+    }
+    return 0;
+}
+
 } // namespace copcomp
 } // namespace team114
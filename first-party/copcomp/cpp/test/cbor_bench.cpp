@@ -0,0 +1,95 @@
+#include <chrono>
+#include <copcomp/2019packet.hpp>
+#include <copcomp/cbor.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace team114::copcomp;
+using namespace team114::c2019::vision;
+using namespace std;
+
+// checks the codec against tinycbor and serde_cbor's encodings, then times
+// both paths
+
+static const int ITERS = 1000000;
+
+template <typename F> static double ns_per_iter(F f)
+{
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < ITERS; ++i) {
+        f(i);
+    }
+    auto stop = chrono::steady_clock::now();
+    return chrono::duration<double, nano>(stop - start).count() / ITERS;
+}
+
+// checks in release builds too
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        cerr << "failed: " << what << endl;
+        exit(1);
+    }
+}
+
+static bool same(const Packet &a, const Packet &b) { return a.micros == b.micros && a.x == b.x && a.y == b.y; }
+
+int main()
+{
+    vector<uint8_t> heap(65 * 1024);
+    cbor::Buffer<Packet> stack;
+    static_assert(cbor::max_encoded_size<Packet>() == 1 + 9 + 5 + 5, "array of int64, float, float");
+
+    // same bytes as tinycbor, for small, large and negative values
+    for (int64_t micros : {int64_t{0}, int64_t{23}, int64_t{1000}, int64_t{1} << 40, int64_t{-5}}) {
+        Packet p{micros, 1.5f, -2.25f};
+        size_t tiny = p.cbor_serialize(heap.data(), heap.size());
+        size_t ours = cbor::encode(p, stack);
+        check(tiny == ours, "same length as tinycbor");
+        check(memcmp(heap.data(), stack.data(), ours) == 0, "same bytes as tinycbor");
+        Packet back{};
+        check(cbor::decode(stack.data(), ours, back) == cbor::Error::None, "decode array");
+        check(same(p, back), "array round trip");
+    }
+
+    // serde_cbor's default struct encoding, a map keyed by field name, with
+    // fields reordered and y as a half float
+    const uint8_t serde[] = {0xa3, 0x61, 'x',  0xfa, 0x3f, 0xc0, 0x00, 0x00, 0x66, 'm',  'i',  'c',  'r',
+                             'o',  's',  0x1a, 0x00, 0x0f, 0x42, 0x40, 0x61, 'y',  0xf9, 0xc0, 0x80};
+    static_assert(sizeof(serde) <= cbor::max_wire_size<Packet>(), "map encoding fits");
+    Packet from_map{};
+    check(cbor::decode(serde, sizeof(serde), from_map) == cbor::Error::None, "decode map");
+    check(same(from_map, Packet{1000000, 1.5f, -2.25f}), "map values");
+
+    // malformed input is reported, not thrown
+    Packet scratch{};
+    check(cbor::decode(serde, sizeof(serde) - 1, scratch) == cbor::Error::UnexpectedEnd, "truncated");
+    const uint8_t two_fields[] = {0x82, 0x00, 0xf9, 0x00, 0x00};
+    check(cbor::decode(two_fields, sizeof(two_fields), scratch) == cbor::Error::WrongLength, "field count");
+    const uint8_t unknown[] = {0xa3, 0x61, 'z', 0x00, 0x61, 'x', 0x00, 0x61, 'y', 0x00};
+    check(cbor::decode(unknown, sizeof(unknown), scratch) == cbor::Error::UnknownField, "unknown field");
+
+    volatile int64_t sink = 0;
+    Packet p{123456789, 1.5f, -2.25f};
+    double tiny_enc = ns_per_iter([&](int i) {
+        p.micros = i;
+        sink = sink + p.cbor_serialize(heap.data(), heap.size());
+    });
+    double ours_enc = ns_per_iter([&](int i) {
+        p.micros = i;
+        sink = sink + cbor::encode(p, stack);
+    });
+    size_t len = cbor::encode(p, stack);
+    memcpy(heap.data(), stack.data(), len);
+    double tiny_dec = ns_per_iter([&](int) { sink = sink + Packet::cbor_deserialize(heap.data(), len).micros; });
+    double ours_dec = ns_per_iter([&](int) {
+        Packet out;
+        cbor::decode(stack.data(), len, out);
+        sink = sink + out.micros;
+    });
+
+    cout << "encode tinycbor: " << tiny_enc << " ns copcomp::cbor: " << ours_enc << " ns" << endl;
+    cout << "decode tinycbor: " << tiny_dec << " ns copcomp::cbor: " << ours_dec << " ns" << endl;
+}
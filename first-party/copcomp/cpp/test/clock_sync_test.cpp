@@ -0,0 +1,102 @@
+#include <cmath>
+#include <copcomp/2019packet.hpp>
+#include <copcomp/clock_sync.hpp>
+#include <copcomp/copcomp.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+
+using namespace team114::copcomp;
+using namespace team114::c2019::vision;
+using namespace std;
+
+// checks ClockSync against a simulated remote clock, then runs the exchange
+// between two Connections over loopback
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        cerr << "failed: " << what << endl;
+        exit(1);
+    }
+}
+
+// a coprocessor clock 50ppm fast and 12s ahead of the RIO's
+static int64_t remote_clock(int64_t local) { return local + 12000000 + static_cast<int64_t>(local * 50e-6); }
+
+static void simulated()
+{
+    mt19937 rng(114);
+    uniform_int_distribution<int64_t> leg(200, 2000);
+    // pings wait in the socket for up to a frame before they are answered,
+    // t1 is the kernel's arrival stamp
+    uniform_int_distribution<int64_t> frame_wait(0, 33000);
+    ClockSync sync;
+    check(!sync.synced(), "not synced before any samples");
+
+    int64_t worst = 0;
+    for (int64_t t0 = 1000000; t0 < 151000000; t0 += 100000) {
+        int64_t arrive = t0 + leg(rng);
+        int64_t answer = arrive + frame_wait(rng);
+        int64_t t1 = remote_clock(arrive);
+        int64_t t2 = remote_clock(answer + 20);
+        int64_t t3 = answer + 20 + leg(rng);
+        check(sync.add_sample(t0, t1, t2, t3), "consistent sample");
+        if (sync.synced() && t0 > 5000000) {
+            worst = max(worst, abs(sync.to_remote(t3) - remote_clock(t3)));
+        }
+    }
+    check(!sync.add_sample(100, 200, 150, 300), "reply sent before it was received");
+
+    cout << "simulated: offset " << sync.offset() << " us, drift " << sync.drift() * 1e6 << " ppm, min delay " << sync.min_delay()
+         << " us, worst error " << worst << " us" << endl;
+    // the legs differ by at most 1.8ms, so half that bounds the error
+    check(worst <= 900, "offset within half the leg asymmetry");
+    check(abs(sync.drift() - 50e-6) < 20e-6, "drift estimate");
+    for (int64_t local : {int64_t{0}, int64_t{20000000}, int64_t{3600000000}}) {
+        check(abs(sync.to_local(sync.to_remote(local)) - local) <= 1, "to_local inverts to_remote");
+    }
+}
+
+static void loopback()
+{
+    Connection rio("127.0.0.1", "5813", "5812");
+    Connection coprocessor("127.0.0.1", "5812", "5813");
+    ClockSync sync;
+    int pongs = 0;
+    int packets = 0;
+    for (int i = 0; i < 20; ++i) {
+        rio.send_sync_ping(monotonic_micros());
+        this_thread::sleep_for(chrono::milliseconds(1));
+        check(coprocessor.answer_sync_pings() == 1, "ping answered");
+        Packet p{monotonic_micros(), 1.f, 2.f};
+        coprocessor.write_item(p);
+        this_thread::sleep_for(chrono::milliseconds(1));
+        rio.recv_each([&](const uint8_t *buf, size_t len, int64_t age) {
+            if (sync.handle(buf, len, monotonic_micros() - age)) {
+                pongs++;
+                return true;
+            }
+            Packet got;
+            if (cbor::decode(buf, len, got) != cbor::Error::None) {
+                return false;
+            }
+            packets++;
+            // both ends share a clock here, so the packet maps to about when
+            // it was made
+            check(abs(sync.to_local(got.micros) - p.micros) < 1000, "packet time on the local clock");
+            return true;
+        });
+    }
+    check(pongs == 20 && packets == 20, "pongs and packets told apart");
+    check(rio.stats().dropped == 0, "nothing dropped");
+    cout << "loopback: offset " << sync.offset() << " us, min delay " << sync.min_delay() << " us" << endl;
+    check(abs(sync.offset()) < 1000, "same clock on both ends");
+}
+
+int main()
+{
+    simulated();
+    loopback();
+}
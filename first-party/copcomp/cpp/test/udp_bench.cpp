@@ -0,0 +1,81 @@
+#include <chrono>
+#include <copcomp/2019packet.hpp>
+#include <copcomp/copcomp.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace team114::copcomp;
+using namespace team114::c2019::vision;
+using namespace std;
+
+// sends frames of targets between two Connections over loopback, one datagram
+// per syscall vs sendmmsg/recvmmsg batches, and reports throughput and
+// syscalls per packet
+
+static const int FRAMES = 20000;
+static const size_t TARGETS = 8;
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        cerr << "failed: " << what << endl;
+        exit(1);
+    }
+}
+
+template <typename F> static void run(const char *name, Connection &tx, Connection &rx, F frame)
+{
+    IoStats tx_start = tx.stats();
+    IoStats rx_start = rx.stats();
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < FRAMES; ++i) {
+        frame(i);
+    }
+    auto stop = chrono::steady_clock::now();
+    const IoStats &t = tx.stats();
+    const IoStats &r = rx.stats();
+    double packets = FRAMES * TARGETS;
+    check(t.sent - tx_start.sent == packets, "every packet sent");
+    check(r.received - rx_start.received == packets, "every packet received");
+    double secs = chrono::duration<double>(stop - start).count();
+    double syscalls = (t.syscalls - tx_start.syscalls) + (r.syscalls - rx_start.syscalls);
+    cout << name << ": " << packets / secs << " packets/s, " << syscalls / packets << " syscalls/packet, "
+         << r.dropped - rx_start.dropped << " dropped" << endl;
+}
+
+int main()
+{
+    Connection tx("127.0.0.1", "5810", "5811");
+    Connection rx("127.0.0.1", "5811", "5810");
+    vector<Packet> frame(TARGETS);
+    vector<Packet> got(Connection::MAX_BATCH);
+
+    run("write_item/recv_fixed", tx, rx, [&](int i) {
+        for (size_t t = 0; t < TARGETS; ++t) {
+            tx.write_item(Packet{i, float(t), 0.f});
+        }
+        for (size_t t = 0; t < TARGETS; ++t) {
+            check(rx.recv_fixed(got[t]) == cbor::Error::None, "recv_fixed");
+        }
+    });
+
+    run("write_items/recv_items", tx, rx, [&](int i) {
+        for (size_t t = 0; t < TARGETS; ++t) {
+            frame[t] = Packet{i, float(t), 0.f};
+        }
+        check(tx.write_items(frame.data(), frame.size()) == TARGETS, "write_items");
+        check(rx.recv_items(got.data(), got.size()) == TARGETS, "recv_items");
+        check(got[TARGETS - 1].micros == i, "in order");
+    });
+
+    run("write_items/recv_latest", tx, rx, [&](int i) {
+        for (size_t t = 0; t < TARGETS; ++t) {
+            frame[t] = Packet{i, float(t), 0.f};
+        }
+        check(tx.write_items(frame.data(), frame.size()) == TARGETS, "write_items");
+        Packet latest;
+        check(rx.recv_latest(latest), "recv_latest");
+        check(latest.micros == i && latest.x == float(TARGETS - 1), "newest kept");
+    });
+}
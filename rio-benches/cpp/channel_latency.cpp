@@ -0,0 +1,287 @@
+// C++ port of ../src/channel_latency.rs. A sender thread timestamps a message
+// every 10us and the receiver records how long each took to arrive, once per
+// candidate handoff primitive for our control threads. Run as root on the RIO,
+// setting SCHED_FIFO fails otherwise. Pass --no-prio to skip priority and
+// pinning.
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <wpi/ConcurrentQueue.h>
+#include <wpi/RingQueue.h>
+#include <wpi/condition_variable.h>
+#include <wpi/mutex.h>
+#include <wpi/priority_mutex.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kIters = 100;
+constexpr int kMessages = 1000;
+constexpr auto kSendInterval = std::chrono::microseconds{10};
+
+// as in the rust bench, the receiver runs above the sender, each on its own
+// core
+constexpr int kReceiverPriority = 50;
+constexpr int kReceiverCpu = 0;
+constexpr int kSenderPriority = 40;
+constexpr int kSenderCpu = 1;
+
+bool SetRealTime(int priority) {
+    sched_param param{};
+    param.sched_priority = priority;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+
+bool PinToCpu(int cpu) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+}
+
+struct ContextSwitches {
+    long voluntary = 0;
+    long involuntary = 0;
+};
+
+ContextSwitches ThreadContextSwitches() {
+    rusage usage;
+    std::memset(&usage, 0, sizeof(usage));
+    getrusage(RUSAGE_THREAD, &usage);
+    return {usage.ru_nvcsw, usage.ru_nivcsw};
+}
+
+// Each channel carries timestamps from exactly one sender to one receiver.
+// Storage is allocated up front so only the handoff itself is measured.
+
+class ConcurrentQueueChannel {
+   public:
+    static constexpr const char* kName = "wpi::ConcurrentQueue";
+    void Send(Clock::time_point t) { queue_.push(t); }
+    Clock::time_point Recv() { return queue_.pop(); }
+
+   private:
+    wpi::ConcurrentQueue<Clock::time_point> queue_;
+};
+
+// Blocking wait on a wpi::condition_variable, which on the RIO is a
+// condition_variable_any over the priority inheriting wpi::mutex
+class CondVarChannel {
+   public:
+    static constexpr const char* kName = "wpi::condition_variable";
+    CondVarChannel() : buf_(kMessages) {}
+    void Send(Clock::time_point t) {
+        {
+            std::lock_guard<wpi::mutex> lock{mutex_};
+            buf_[sent_++ % buf_.size()] = t;
+        }
+        cond_.notify_one();
+    }
+    Clock::time_point Recv() {
+        std::unique_lock<wpi::mutex> lock{mutex_};
+        cond_.wait(lock, [this] { return sent_ != received_; });
+        return buf_[received_++ % buf_.size()];
+    }
+
+   private:
+    wpi::mutex mutex_;
+    wpi::condition_variable cond_;
+    std::vector<Clock::time_point> buf_;
+    size_t sent_ = 0;
+    size_t received_ = 0;
+};
+
+// The receiver polls under the lock, yielding between polls
+#ifdef WPI_HAVE_PRIORITY_MUTEX
+using PolledMutex = wpi::priority_mutex;
+constexpr const char* kPolledMutexName = "wpi::priority_mutex poll";
+#else
+using PolledMutex = std::mutex;
+constexpr const char* kPolledMutexName = "std::mutex poll (no priority_mutex)";
+#endif
+
+class PolledMutexChannel {
+   public:
+    static constexpr const char* kName = kPolledMutexName;
+    PolledMutexChannel() : buf_(kMessages) {}
+    void Send(Clock::time_point t) {
+        std::lock_guard<PolledMutex> lock{mutex_};
+        buf_[sent_++ % buf_.size()] = t;
+    }
+    Clock::time_point Recv() {
+        for (;;) {
+            {
+                std::lock_guard<PolledMutex> lock{mutex_};
+                if (sent_ != received_) {
+                    return buf_[received_++ % buf_.size()];
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+   private:
+    PolledMutex mutex_;
+    std::vector<Clock::time_point> buf_;
+    size_t sent_ = 0;
+    size_t received_ = 0;
+};
+
+// Lock-free queue for the data, the receiver sleeps in read() on an eventfd
+class EventfdChannel {
+   public:
+    static constexpr const char* kName = "eventfd";
+    EventfdChannel() : fd_{eventfd(0, 0)}, queue_{kMessages} {}
+    ~EventfdChannel() { close(fd_); }
+    void Send(Clock::time_point t) {
+        queue_.push(t);
+        uint64_t one = 1;
+        if (write(fd_, &one, sizeof(one)) != sizeof(one)) {
+            std::cerr << "eventfd write failed" << std::endl;
+        }
+    }
+    Clock::time_point Recv() {
+        Clock::time_point t;
+        while (!queue_.try_pop(t)) {
+            // the count may cover several messages, read() just resets it
+            uint64_t count;
+            if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+                std::cerr << "eventfd read failed" << std::endl;
+            }
+        }
+        return t;
+    }
+
+   private:
+    int fd_;
+    wpi::SpscRingQueue<Clock::time_point> queue_;
+};
+
+// Receiver busy waits on the lock-free queue, never sleeps
+class SpinChannel {
+   public:
+    static constexpr const char* kName = "wpi::SpscRingQueue spin";
+    SpinChannel() : queue_{kMessages} {}
+    void Send(Clock::time_point t) { queue_.push(t); }
+    Clock::time_point Recv() {
+        Clock::time_point t;
+        while (!queue_.try_pop(t)) {
+        }
+        return t;
+    }
+
+   private:
+    wpi::SpscRingQueue<Clock::time_point> queue_;
+};
+
+// Same queue, with its own spin-then-sleep pop
+class RingQueuePopChannel {
+   public:
+    static constexpr const char* kName = "wpi::SpscRingQueue pop";
+    RingQueuePopChannel() : queue_{kMessages} {}
+    void Send(Clock::time_point t) { queue_.push(t); }
+    Clock::time_point Recv() { return queue_.pop(); }
+
+   private:
+    wpi::SpscRingQueue<Clock::time_point> queue_;
+};
+
+template <typename Channel>
+void Bench(bool pin_prio) {
+    Channel channel;
+    std::vector<double> latencies_us;
+    latencies_us.reserve(kIters * kMessages);
+    ContextSwitches sender_csw;
+    ContextSwitches receiver_start = ThreadContextSwitches();
+
+    for (int iter = 0; iter < kIters; iter++) {
+        std::thread sender{[&] {
+            if (pin_prio) {
+                SetRealTime(kSenderPriority);
+                PinToCpu(kSenderCpu);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+            ContextSwitches start = ThreadContextSwitches();
+            for (int i = 0; i < kMessages; i++) {
+                channel.Send(Clock::now());
+                std::this_thread::sleep_for(kSendInterval);
+            }
+            ContextSwitches end = ThreadContextSwitches();
+            sender_csw.voluntary += end.voluntary - start.voluntary;
+            sender_csw.involuntary += end.involuntary - start.involuntary;
+        }};
+        for (int i = 0; i < kMessages; i++) {
+            Clock::time_point sent = channel.Recv();
+            latencies_us.push_back(
+                std::chrono::duration<double, std::micro>{Clock::now() - sent}
+                    .count());
+        }
+        sender.join();
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+
+    ContextSwitches receiver_end = ThreadContextSwitches();
+    double mean = 0.0;
+    for (double l : latencies_us) {
+        mean += l;
+    }
+    mean /= latencies_us.size();
+    double var = 0.0;
+    for (double l : latencies_us) {
+        var += (l - mean) * (l - mean);
+    }
+    double stddev = std::sqrt(var / latencies_us.size());
+    std::sort(latencies_us.begin(), latencies_us.end());
+    double p99 = latencies_us[latencies_us.size() * 99 / 100];
+    double max = latencies_us.back();
+
+    std::cout << std::fixed << std::setprecision(2) << Channel::kName
+              << "\n  mean: " << mean << "us stddev: " << stddev
+              << "us p99: " << p99 << "us max: " << max << "us"
+              << "\n  receiver nvcsw: "
+              << receiver_end.voluntary - receiver_start.voluntary
+              << " nivcsw: "
+              << receiver_end.involuntary - receiver_start.involuntary
+              << "\n  sender nvcsw: " << sender_csw.voluntary
+              << " nivcsw: " << sender_csw.involuntary << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bool pin_prio = !(argc > 1 && std::strcmp(argv[1], "--no-prio") == 0);
+    if (pin_prio) {
+        if (!SetRealTime(kReceiverPriority) || !PinToCpu(kReceiverCpu)) {
+            std::cerr << "could not set priority and pinning, run as root or "
+                         "pass --no-prio"
+                      << std::endl;
+            return 1;
+        }
+    }
+    std::cout << kIters << " x " << kMessages << " messages, "
+              << (pin_prio ? "with" : "without") << " priority and pinning"
+              << std::endl;
+    Bench<ConcurrentQueueChannel>(pin_prio);
+    Bench<CondVarChannel>(pin_prio);
+    Bench<PolledMutexChannel>(pin_prio);
+    Bench<EventfdChannel>(pin_prio);
+    Bench<SpinChannel>(pin_prio);
+    Bench<RingQueuePopChannel>(pin_prio);
+    return 0;
+}
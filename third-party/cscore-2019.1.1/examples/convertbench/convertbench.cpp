@@ -0,0 +1,89 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+// Times the Frame color conversions against the cv::cvtColor calls they
+// replace.  Needs the cscore private headers (src/main/native/cpp) on the
+// include path.
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <wpi/raw_ostream.h>
+#include <wpi/timestamp.h>
+
+#include "ColorConvert.h"
+
+namespace {
+
+constexpr int kIterations = 200;
+
+template <typename F>
+double Time(F func) {
+  func();  // warm up
+  uint64_t start = wpi::Now();
+  for (int i = 0; i < kIterations; ++i) func();
+  return (wpi::Now() - start) / double(kIterations);
+}
+
+void Report(const char* name, double cv, double kernel) {
+  wpi::outs() << "  " << name << ": cvtColor " << cv << " us, kernel "
+              << kernel << " us (" << cv / kernel << "x)\n";
+}
+
+void Bench(int width, int height) {
+  size_t pixels = width * height;
+  cv::Mat yuyv(height, width, CV_8UC2), bgr(height, width, CV_8UC3);
+  cv::Mat gray(height, width, CV_8UC1), rgb565(height, width, CV_8UC2);
+  cv::randu(yuyv, 0, 256);
+  cv::randu(bgr, 0, 256);
+  cv::randu(gray, 0, 256);
+  cv::randu(rgb565, 0, 256);
+  cv::Mat out3(height, width, CV_8UC3), out2(height, width, CV_8UC2);
+  cv::Mat out1(height, width, CV_8UC1);
+
+  wpi::outs() << width << "x" << height << ":\n";
+  Report("YUYV->BGR",
+         Time([&] { cv::cvtColor(yuyv, out3, cv::COLOR_YUV2BGR_YUYV); }),
+         Time([&] {
+           cs::ConvertYUYVToBGRPixels(yuyv.data, out3.data, pixels);
+         }));
+  Report("YUYV->Gray (via BGR)",
+         Time([&] {
+           cv::cvtColor(yuyv, out3, cv::COLOR_YUV2BGR_YUYV);
+           cv::cvtColor(out3, out1, cv::COLOR_BGR2GRAY);
+         }),
+         Time([&] {
+           cs::ConvertYUYVToGrayPixels(yuyv.data, out1.data, pixels);
+         }));
+  Report("BGR->Gray",
+         Time([&] { cv::cvtColor(bgr, out1, cv::COLOR_BGR2GRAY); }),
+         Time([&] {
+           cs::ConvertBGRToGrayPixels(bgr.data, out1.data, pixels);
+         }));
+  Report("BGR->RGB565",
+         Time([&] { cv::cvtColor(bgr, out2, cv::COLOR_RGB2BGR565); }),
+         Time([&] {
+           cs::ConvertBGRToRGB565Pixels(bgr.data, out2.data, pixels);
+         }));
+  Report("RGB565->BGR",
+         Time([&] { cv::cvtColor(rgb565, out3, cv::COLOR_BGR5652RGB); }),
+         Time([&] {
+           cs::ConvertRGB565ToBGRPixels(rgb565.data, out3.data, pixels);
+         }));
+  Report("Gray->BGR",
+         Time([&] { cv::cvtColor(gray, out3, cv::COLOR_GRAY2BGR); }),
+         Time([&] {
+           cs::ConvertGrayToBGRPixels(gray.data, out3.data, pixels);
+         }));
+}
+
+}  // namespace
+
+int main() {
+  Bench(320, 240);
+  Bench(640, 480);
+  Bench(1280, 720);
+}
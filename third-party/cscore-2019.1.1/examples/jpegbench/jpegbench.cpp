@@ -0,0 +1,97 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+// Times getting a smaller image out of a camera JPEG the way Frame used to
+// (full decode, then resize) against decoding straight to a fraction of the
+// size and resizing what's left.
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <wpi/raw_ostream.h>
+#include <wpi/timestamp.h>
+
+namespace {
+
+constexpr int kIterations = 100;
+
+template <typename F>
+double Time(F func) {
+  func();  // warm up
+  uint64_t start = wpi::Now();
+  for (int i = 0; i < kIterations; ++i) func();
+  return (wpi::Now() - start) / double(kIterations);
+}
+
+// Something with edges and gradients, compressing roughly like a scene
+std::vector<uchar> MakeJpeg(int width, int height) {
+  cv::Mat image(height, width, CV_8UC3);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      cv::Vec3b& p = image.at<cv::Vec3b>(y, x);
+      p[0] = x * 255 / width;
+      p[1] = y * 255 / height;
+      p[2] = ((x / 40) ^ (y / 40)) & 1 ? 200 : 40;
+    }
+  }
+  cv::Mat noise(height, width, CV_8UC3);
+  cv::randu(noise, 0, 16);
+  image += noise;
+  std::vector<uchar> jpeg;
+  cv::imencode(".jpg", image, jpeg, {cv::IMWRITE_JPEG_QUALITY, 80});
+  return jpeg;
+}
+
+int ReducedFlag(int scale, bool color) {
+  switch (scale) {
+    case 2:
+      return color ? cv::IMREAD_REDUCED_COLOR_2
+                   : cv::IMREAD_REDUCED_GRAYSCALE_2;
+    case 4:
+      return color ? cv::IMREAD_REDUCED_COLOR_4
+                   : cv::IMREAD_REDUCED_GRAYSCALE_4;
+    case 8:
+      return color ? cv::IMREAD_REDUCED_COLOR_8
+                   : cv::IMREAD_REDUCED_GRAYSCALE_8;
+    default:
+      return color ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE;
+  }
+}
+
+void Bench(int width, int height) {
+  auto jpeg = MakeJpeg(width, height);
+  wpi::outs() << width << "x" << height << " (" << jpeg.size()
+              << " byte JPEG):\n";
+  for (bool color : {true, false}) {
+    cv::Mat full, scaled, out;
+    for (int scale = 2; scale <= 8; scale *= 2) {
+      cv::Size size(width / scale, height / scale);
+      double resized = Time([&] {
+        cv::imdecode(jpeg, color ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE,
+                     &full);
+        cv::resize(full, out, size);
+      });
+      double direct = Time([&] {
+        cv::imdecode(jpeg, ReducedFlag(scale, color), &scaled);
+        if (scaled.size() != size) cv::resize(scaled, out, size);
+      });
+      wpi::outs() << "  " << (color ? "BGR " : "gray ") << size.width << "x"
+                  << size.height << ": decode+resize " << resized
+                  << " us, scaled decode " << direct << " us ("
+                  << resized / direct << "x)\n";
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  Bench(640, 480);
+  Bench(1280, 720);
+}
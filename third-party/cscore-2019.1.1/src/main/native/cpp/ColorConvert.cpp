@@ -0,0 +1,556 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "ColorConvert.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CSCORE_CONVERT_NEON
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#define CSCORE_CONVERT_SSE
+#endif
+
+using namespace cs;
+
+// ITU-R BT.601 YUV to RGB in 20 bit fixed point, as cv::cvtColor
+static constexpr int kCY = 1220542;
+static constexpr int kCUB = 2116026;
+static constexpr int kCUG = -409993;
+static constexpr int kCVG = -852492;
+static constexpr int kCVR = 1673527;
+static constexpr int kYUVShift = 20;
+static constexpr int kYUVRound = 1 << (kYUVShift - 1);
+
+// The same stretch of luma in 16 bits: (y - 16) * 149 + 62 >> 7 equals
+// (y - 16) * kCY + kYUVRound >> kYUVShift for every y, and stays below 2^16
+static constexpr int kYGray = 149;
+static constexpr int kYGrayRound = 62;
+static constexpr int kYGrayShift = 7;
+
+// RGB to gray weights in 14 bit fixed point, as cv::cvtColor
+static constexpr int kB2Y = 1868;
+static constexpr int kG2Y = 9617;
+static constexpr int kR2Y = 4899;
+static constexpr int kGrayShift = 14;
+static constexpr int kGrayRound = 1 << (kGrayShift - 1);
+
+static inline uint8_t Saturate(int v) {
+  return v < 0 ? 0 : (v > 255 ? 255 : static_cast<uint8_t>(v));
+}
+
+//
+// Scalar versions, for the pixels left over after the vector loops
+//
+
+static void YUYVToBGRScalar(const uint8_t* src, uint8_t* dst, size_t pairs) {
+  for (size_t i = 0; i < pairs; ++i, src += 4, dst += 6) {
+    int u = src[1] - 128;
+    int v = src[3] - 128;
+    int ruv = kYUVRound + kCVR * v;
+    int guv = kYUVRound + kCVG * v + kCUG * u;
+    int buv = kYUVRound + kCUB * u;
+    int y0 = (src[0] > 16 ? src[0] - 16 : 0) * kCY;
+    int y1 = (src[2] > 16 ? src[2] - 16 : 0) * kCY;
+    dst[0] = Saturate((y0 + buv) >> kYUVShift);
+    dst[1] = Saturate((y0 + guv) >> kYUVShift);
+    dst[2] = Saturate((y0 + ruv) >> kYUVShift);
+    dst[3] = Saturate((y1 + buv) >> kYUVShift);
+    dst[4] = Saturate((y1 + guv) >> kYUVShift);
+    dst[5] = Saturate((y1 + ruv) >> kYUVShift);
+  }
+}
+
+static void YUYVToGrayScalar(const uint8_t* src, uint8_t* dst, size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, src += 2) {
+    int y = src[0] > 16 ? src[0] - 16 : 0;
+    dst[i] = Saturate((y * kYGray + kYGrayRound) >> kYGrayShift);
+  }
+}
+
+static void BGRToGrayScalar(const uint8_t* src, uint8_t* dst, size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, src += 3) {
+    dst[i] = (src[0] * kB2Y + src[1] * kG2Y + src[2] * kR2Y + kGrayRound) >>
+             kGrayShift;
+  }
+}
+
+static void BGRToRGB565Scalar(const uint8_t* src, uint16_t* dst,
+                              size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, src += 3) {
+    dst[i] =
+        (src[2] >> 3) | ((src[1] << 3) & 0x07e0) | ((src[0] << 8) & 0xf800);
+  }
+}
+
+static void RGB565ToBGRScalar(const uint16_t* src, uint8_t* dst,
+                              size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, dst += 3) {
+    unsigned t = src[i];
+    dst[0] = (t >> 8) & 0xf8;
+    dst[1] = (t >> 3) & 0xfc;
+    dst[2] = (t << 3) & 0xf8;
+  }
+}
+
+static void GrayToBGRScalar(const uint8_t* src, uint8_t* dst, size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, dst += 3)
+    dst[0] = dst[1] = dst[2] = src[i];
+}
+
+#ifdef CSCORE_CONVERT_NEON
+
+// (y + c) >> kYUVShift for 4 pixels, narrowed with saturation
+static inline int16x4_t YUVShift(int32x4_t y, int32x4_t c) {
+  return vqmovn_s32(vshrq_n_s32(vaddq_s32(y, c), kYUVShift));
+}
+
+// B, G and R of the even and odd pixels of 4 pairs
+static inline void YUYVToBGR4(int16x4_t u, int16x4_t v, int16x4_t y0,
+                              int16x4_t y1, int16x4_t bgr0[3],
+                              int16x4_t bgr1[3]) {
+  int32x4_t u32 = vmovl_s16(u);
+  int32x4_t v32 = vmovl_s16(v);
+  int32x4_t round = vdupq_n_s32(kYUVRound);
+  int32x4_t ruv = vmlaq_n_s32(round, v32, kCVR);
+  int32x4_t guv = vmlaq_n_s32(vmlaq_n_s32(round, v32, kCVG), u32, kCUG);
+  int32x4_t buv = vmlaq_n_s32(round, u32, kCUB);
+  int32x4_t y032 = vmulq_n_s32(vmovl_s16(y0), kCY);
+  int32x4_t y132 = vmulq_n_s32(vmovl_s16(y1), kCY);
+  bgr0[0] = YUVShift(y032, buv);
+  bgr0[1] = YUVShift(y032, guv);
+  bgr0[2] = YUVShift(y032, ruv);
+  bgr1[0] = YUVShift(y132, buv);
+  bgr1[1] = YUVShift(y132, guv);
+  bgr1[2] = YUVShift(y132, ruv);
+}
+
+// 16 pairs, 32 pixels
+static inline void YUYVToBGR16(const uint8_t* src, uint8_t* dst) {
+  uint8x16x4_t yuyv = vld4q_u8(src);
+  uint8x8_t k16 = vdup_n_u8(16);
+  uint8x8_t k128 = vdup_n_u8(128);
+  // [even/odd pixel][channel][pairs 0-3, 4-7, 8-11, 12-15]
+  int16x4_t out[2][3][4];
+  for (int h = 0; h < 2; ++h) {
+    uint8x8_t y0 = h ? vget_high_u8(yuyv.val[0]) : vget_low_u8(yuyv.val[0]);
+    uint8x8_t u = h ? vget_high_u8(yuyv.val[1]) : vget_low_u8(yuyv.val[1]);
+    uint8x8_t y1 = h ? vget_high_u8(yuyv.val[2]) : vget_low_u8(yuyv.val[2]);
+    uint8x8_t v = h ? vget_high_u8(yuyv.val[3]) : vget_low_u8(yuyv.val[3]);
+    int16x8_t u16 = vreinterpretq_s16_u16(vsubl_u8(u, k128));
+    int16x8_t v16 = vreinterpretq_s16_u16(vsubl_u8(v, k128));
+    int16x8_t y016 = vreinterpretq_s16_u16(vmovl_u8(vqsub_u8(y0, k16)));
+    int16x8_t y116 = vreinterpretq_s16_u16(vmovl_u8(vqsub_u8(y1, k16)));
+    int16x4_t bgr0[3], bgr1[3];
+    YUYVToBGR4(vget_low_s16(u16), vget_low_s16(v16), vget_low_s16(y016),
+               vget_low_s16(y116), bgr0, bgr1);
+    for (int c = 0; c < 3; ++c) {
+      out[0][c][2 * h] = bgr0[c];
+      out[1][c][2 * h] = bgr1[c];
+    }
+    YUYVToBGR4(vget_high_s16(u16), vget_high_s16(v16), vget_high_s16(y016),
+               vget_high_s16(y116), bgr0, bgr1);
+    for (int c = 0; c < 3; ++c) {
+      out[0][c][2 * h + 1] = bgr0[c];
+      out[1][c][2 * h + 1] = bgr1[c];
+    }
+  }
+  // put the even and odd pixels back in order
+  uint8x16x3_t lo, hi;
+  for (int c = 0; c < 3; ++c) {
+    uint8x16_t even = vcombine_u8(
+        vqmovun_s16(vcombine_s16(out[0][c][0], out[0][c][1])),
+        vqmovun_s16(vcombine_s16(out[0][c][2], out[0][c][3])));
+    uint8x16_t odd = vcombine_u8(
+        vqmovun_s16(vcombine_s16(out[1][c][0], out[1][c][1])),
+        vqmovun_s16(vcombine_s16(out[1][c][2], out[1][c][3])));
+    uint8x16x2_t zipped = vzipq_u8(even, odd);
+    lo.val[c] = zipped.val[0];
+    hi.val[c] = zipped.val[1];
+  }
+  vst3q_u8(dst, lo);
+  vst3q_u8(dst + 48, hi);
+}
+
+// 8 pixels
+static inline uint8x8_t YUYVToGray8(uint8x8_t y) {
+  uint16x8_t t = vmull_u8(vqsub_u8(y, vdup_n_u8(16)), vdup_n_u8(kYGray));
+  return vqshrn_n_u16(vaddq_u16(t, vdupq_n_u16(kYGrayRound)), kYGrayShift);
+}
+
+static inline uint16x4_t BGRToGray4(uint16x4_t b, uint16x4_t g,
+                                    uint16x4_t r) {
+  uint32x4_t t = vmlal_n_u16(vdupq_n_u32(kGrayRound), b, kB2Y);
+  t = vmlal_n_u16(t, g, kG2Y);
+  t = vmlal_n_u16(t, r, kR2Y);
+  return vshrn_n_u32(t, kGrayShift);
+}
+
+static inline uint8x8_t BGRToGray8(uint8x8_t b, uint8x8_t g, uint8x8_t r) {
+  uint16x8_t b16 = vmovl_u8(b);
+  uint16x8_t g16 = vmovl_u8(g);
+  uint16x8_t r16 = vmovl_u8(r);
+  return vmovn_u16(vcombine_u16(
+      BGRToGray4(vget_low_u16(b16), vget_low_u16(g16), vget_low_u16(r16)),
+      BGRToGray4(vget_high_u16(b16), vget_high_u16(g16),
+                 vget_high_u16(r16))));
+}
+
+static inline uint16x8_t BGRToRGB5658(uint8x8_t b, uint8x8_t g, uint8x8_t r) {
+  uint16x8_t t = vmovl_u8(vshr_n_u8(r, 3));
+  t = vorrq_u16(t, vandq_u16(vshll_n_u8(g, 3), vdupq_n_u16(0x07e0)));
+  return vorrq_u16(t, vandq_u16(vshll_n_u8(b, 8), vdupq_n_u16(0xf800)));
+}
+
+static inline void RGB565ToBGR8(uint16x8_t t, uint8x8_t* b, uint8x8_t* g,
+                                uint8x8_t* r) {
+  *b = vand_u8(vshrn_n_u16(t, 8), vdup_n_u8(0xf8));
+  *g = vand_u8(vshrn_n_u16(t, 3), vdup_n_u8(0xfc));
+  *r = vshl_n_u8(vmovn_u16(t), 3);
+}
+
+#endif  // CSCORE_CONVERT_NEON
+
+#ifdef CSCORE_CONVERT_SSE
+
+// 16 pixels of BGR to planes and back
+static inline void LoadBGR16(const uint8_t* src, __m128i* b, __m128i* g,
+                             __m128i* r) {
+  __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+  __m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+  *b = _mm_or_si128(
+      _mm_or_si128(
+          _mm_shuffle_epi8(a0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -128, -128,
+                                             -128, -128, -128, -128, -128,
+                                             -128, -128, -128)),
+          _mm_shuffle_epi8(a1, _mm_setr_epi8(-128, -128, -128, -128, -128,
+                                             -128, 2, 5, 8, 11, 14, -128, -128,
+                                             -128, -128, -128))),
+      _mm_shuffle_epi8(a2, _mm_setr_epi8(-128, -128, -128, -128, -128, -128,
+                                         -128, -128, -128, -128, -128, 1, 4, 7,
+                                         10, 13)));
+  *g = _mm_or_si128(
+      _mm_or_si128(
+          _mm_shuffle_epi8(a0, _mm_setr_epi8(1, 4, 7, 10, 13, -128, -128,
+                                             -128, -128, -128, -128, -128,
+                                             -128, -128, -128, -128)),
+          _mm_shuffle_epi8(a1, _mm_setr_epi8(-128, -128, -128, -128, -128, 0,
+                                             3, 6, 9, 12, 15, -128, -128, -128,
+                                             -128, -128))),
+      _mm_shuffle_epi8(a2, _mm_setr_epi8(-128, -128, -128, -128, -128, -128,
+                                         -128, -128, -128, -128, -128, 2, 5, 8,
+                                         11, 14)));
+  *r = _mm_or_si128(
+      _mm_or_si128(
+          _mm_shuffle_epi8(a0, _mm_setr_epi8(2, 5, 8, 11, 14, -128, -128, -128,
+                                             -128, -128, -128, -128, -128,
+                                             -128, -128, -128)),
+          _mm_shuffle_epi8(a1, _mm_setr_epi8(-128, -128, -128, -128, -128, 1,
+                                             4, 7, 10, 13, -128, -128, -128,
+                                             -128, -128, -128))),
+      _mm_shuffle_epi8(a2, _mm_setr_epi8(-128, -128, -128, -128, -128, -128,
+                                         -128, -128, -128, -128, 0, 3, 6, 9,
+                                         12, 15)));
+}
+
+static inline void StoreBGR16(uint8_t* dst, __m128i b, __m128i g, __m128i r) {
+  __m128i o0 = _mm_or_si128(
+      _mm_or_si128(
+          _mm_shuffle_epi8(b, _mm_setr_epi8(0, -128, -128, 1, -128, -128, 2,
+                                            -128, -128, 3, -128, -128, 4, -128,
+                                            -128, 5)),
+          _mm_shuffle_epi8(g, _mm_setr_epi8(-128, 0, -128, -128, 1, -128,
+                                            -128, 2, -128, -128, 3, -128, -128,
+                                            4, -128, -128))),
+      _mm_shuffle_epi8(r, _mm_setr_epi8(-128, -128, 0, -128, -128, 1, -128,
+                                        -128, 2, -128, -128, 3, -128, -128, 4,
+                                        -128)));
+  __m128i o1 = _mm_or_si128(
+      _mm_or_si128(
+          _mm_shuffle_epi8(b, _mm_setr_epi8(-128, -128, 6, -128, -128, 7, -128,
+                                            -128, 8, -128, -128, 9, -128, -128,
+                                            10, -128)),
+          _mm_shuffle_epi8(g, _mm_setr_epi8(5, -128, -128, 6, -128, -128, 7,
+                                            -128, -128, 8, -128, -128, 9, -128,
+                                            -128, 10))),
+      _mm_shuffle_epi8(r, _mm_setr_epi8(-128, 5, -128, -128, 6, -128, -128, 7,
+                                        -128, -128, 8, -128, -128, 9, -128,
+                                        -128)));
+  __m128i o2 = _mm_or_si128(
+      _mm_or_si128(
+          _mm_shuffle_epi8(b, _mm_setr_epi8(-128, 11, -128, -128, 12, -128,
+                                            -128, 13, -128, -128, 14, -128,
+                                            -128, 15, -128, -128)),
+          _mm_shuffle_epi8(g, _mm_setr_epi8(-128, -128, 11, -128, -128, 12,
+                                            -128, -128, 13, -128, -128, 14,
+                                            -128, -128, 15, -128))),
+      _mm_shuffle_epi8(r, _mm_setr_epi8(10, -128, -128, 11, -128, -128, 12,
+                                        -128, -128, 13, -128, -128, 14, -128,
+                                        -128, 15)));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), o0);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), o1);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 32), o2);
+}
+
+static inline void StoreGrayAsBGR16(uint8_t* dst, __m128i g) {
+  __m128i o0 = _mm_shuffle_epi8(
+      g, _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5));
+  __m128i o1 = _mm_shuffle_epi8(
+      g, _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10));
+  __m128i o2 = _mm_shuffle_epi8(g, _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12,
+                                                 13, 13, 13, 14, 14, 14, 15,
+                                                 15, 15));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), o0);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), o1);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 32), o2);
+}
+
+// (y + c) >> kYUVShift for the even and odd pixels of 8 pairs, saturated and
+// put back in order
+static inline __m128i YUVShift(__m128i y0lo, __m128i y1lo, __m128i clo,
+                               __m128i y0hi, __m128i y1hi, __m128i chi) {
+  __m128i even = _mm_packs_epi32(
+      _mm_srai_epi32(_mm_add_epi32(y0lo, clo), kYUVShift),
+      _mm_srai_epi32(_mm_add_epi32(y0hi, chi), kYUVShift));
+  __m128i odd = _mm_packs_epi32(
+      _mm_srai_epi32(_mm_add_epi32(y1lo, clo), kYUVShift),
+      _mm_srai_epi32(_mm_add_epi32(y1hi, chi), kYUVShift));
+  return _mm_packus_epi16(_mm_unpacklo_epi16(even, odd),
+                          _mm_unpackhi_epi16(even, odd));
+}
+
+// 8 pairs, 16 pixels
+static inline void YUYVToBGR8(const uint8_t* src, uint8_t* dst) {
+  __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+  const __m128i lo16 = _mm_set1_epi32(0xffff);
+  const __m128i k16 = _mm_set1_epi16(16);
+  const __m128i k128 = _mm_set1_epi32(128);
+  const __m128i round = _mm_set1_epi32(kYUVRound);
+  // luma less 16 in 16 bit lanes, then the even and odd pixels of each pair
+  // in 32 bit lanes
+  __m128i ya = _mm_subs_epu16(_mm_and_si128(a, _mm_set1_epi16(0xff)), k16);
+  __m128i yb = _mm_subs_epu16(_mm_and_si128(b, _mm_set1_epi16(0xff)), k16);
+  __m128i y0lo = _mm_mullo_epi32(_mm_and_si128(ya, lo16), _mm_set1_epi32(kCY));
+  __m128i y1lo = _mm_mullo_epi32(_mm_srli_epi32(ya, 16), _mm_set1_epi32(kCY));
+  __m128i y0hi = _mm_mullo_epi32(_mm_and_si128(yb, lo16), _mm_set1_epi32(kCY));
+  __m128i y1hi = _mm_mullo_epi32(_mm_srli_epi32(yb, 16), _mm_set1_epi32(kCY));
+  // chroma, U in the low and V in the high half of each pair
+  __m128i uva = _mm_srli_epi16(a, 8);
+  __m128i uvb = _mm_srli_epi16(b, 8);
+  __m128i ulo = _mm_sub_epi32(_mm_and_si128(uva, lo16), k128);
+  __m128i vlo = _mm_sub_epi32(_mm_srli_epi32(uva, 16), k128);
+  __m128i uhi = _mm_sub_epi32(_mm_and_si128(uvb, lo16), k128);
+  __m128i vhi = _mm_sub_epi32(_mm_srli_epi32(uvb, 16), k128);
+
+  const __m128i cvr = _mm_set1_epi32(kCVR);
+  const __m128i cvg = _mm_set1_epi32(kCVG);
+  const __m128i cug = _mm_set1_epi32(kCUG);
+  const __m128i cub = _mm_set1_epi32(kCUB);
+  __m128i rlo = _mm_add_epi32(round, _mm_mullo_epi32(vlo, cvr));
+  __m128i rhi = _mm_add_epi32(round, _mm_mullo_epi32(vhi, cvr));
+  __m128i glo = _mm_add_epi32(_mm_add_epi32(round, _mm_mullo_epi32(vlo, cvg)),
+                              _mm_mullo_epi32(ulo, cug));
+  __m128i ghi = _mm_add_epi32(_mm_add_epi32(round, _mm_mullo_epi32(vhi, cvg)),
+                              _mm_mullo_epi32(uhi, cug));
+  __m128i blo = _mm_add_epi32(round, _mm_mullo_epi32(ulo, cub));
+  __m128i bhi = _mm_add_epi32(round, _mm_mullo_epi32(uhi, cub));
+
+  StoreBGR16(dst, YUVShift(y0lo, y1lo, blo, y0hi, y1hi, bhi),
+             YUVShift(y0lo, y1lo, glo, y0hi, y1hi, ghi),
+             YUVShift(y0lo, y1lo, rlo, y0hi, y1hi, rhi));
+}
+
+// 8 pixels in 16 bit lanes
+static inline __m128i YUYVToGray8(__m128i yuyv) {
+  __m128i y = _mm_subs_epu16(_mm_and_si128(yuyv, _mm_set1_epi16(0xff)),
+                             _mm_set1_epi16(16));
+  __m128i t = _mm_add_epi16(_mm_mullo_epi16(y, _mm_set1_epi16(kYGray)),
+                            _mm_set1_epi16(kYGrayRound));
+  return _mm_srli_epi16(t, kYGrayShift);
+}
+
+// 8 pixels, each channel in 16 bit lanes
+static inline __m128i BGRToGray8(__m128i b, __m128i g, __m128i r) {
+  const __m128i bg = _mm_set1_epi32((kG2Y << 16) | kB2Y);
+  const __m128i r1 = _mm_set1_epi32((kGrayRound << 16) | kR2Y);
+  const __m128i one = _mm_set1_epi16(1);
+  __m128i lo = _mm_add_epi32(
+      _mm_madd_epi16(_mm_unpacklo_epi16(b, g), bg),
+      _mm_madd_epi16(_mm_unpacklo_epi16(r, one), r1));
+  __m128i hi = _mm_add_epi32(
+      _mm_madd_epi16(_mm_unpackhi_epi16(b, g), bg),
+      _mm_madd_epi16(_mm_unpackhi_epi16(r, one), r1));
+  return _mm_packs_epi32(_mm_srli_epi32(lo, kGrayShift),
+                         _mm_srli_epi32(hi, kGrayShift));
+}
+
+// 8 pixels, each channel in 16 bit lanes
+static inline __m128i BGRToRGB5658(__m128i b, __m128i g, __m128i r) {
+  const __m128i gmask = _mm_set1_epi16(0x07e0);
+  const __m128i bmask = _mm_set1_epi16(static_cast<int16_t>(0xf800));
+  __m128i t = _mm_srli_epi16(r, 3);
+  t = _mm_or_si128(t, _mm_and_si128(_mm_slli_epi16(g, 3), gmask));
+  return _mm_or_si128(t, _mm_and_si128(_mm_slli_epi16(b, 8), bmask));
+}
+
+// 8 pixels, each channel in 16 bit lanes
+static inline void RGB565ToBGR8(__m128i t, __m128i* b, __m128i* g,
+                                __m128i* r) {
+  *b = _mm_and_si128(_mm_srli_epi16(t, 8), _mm_set1_epi16(0xf8));
+  *g = _mm_and_si128(_mm_srli_epi16(t, 3), _mm_set1_epi16(0xfc));
+  *r = _mm_and_si128(_mm_slli_epi16(t, 3), _mm_set1_epi16(0xf8));
+}
+
+#endif  // CSCORE_CONVERT_SSE
+
+void cs::ConvertYUYVToBGRPixels(const uint8_t* src, uint8_t* dst,
+                                size_t pixels) {
+  size_t pairs = pixels / 2;
+  size_t i = 0;
+#if defined(CSCORE_CONVERT_NEON)
+  for (; i + 16 <= pairs; i += 16) YUYVToBGR16(src + i * 4, dst + i * 6);
+#elif defined(CSCORE_CONVERT_SSE)
+  for (; i + 8 <= pairs; i += 8) YUYVToBGR8(src + i * 4, dst + i * 6);
+#endif
+  YUYVToBGRScalar(src + i * 4, dst + i * 6, pairs - i);
+}
+
+void cs::ConvertYUYVToGrayPixels(const uint8_t* src, uint8_t* dst,
+                                 size_t pixels) {
+  size_t i = 0;
+#if defined(CSCORE_CONVERT_NEON)
+  for (; i + 16 <= pixels; i += 16) {
+    uint8x16x2_t yuyv = vld2q_u8(src + i * 2);
+    vst1q_u8(dst + i, vcombine_u8(YUYVToGray8(vget_low_u8(yuyv.val[0])),
+                                  YUYVToGray8(vget_high_u8(yuyv.val[0]))));
+  }
+#elif defined(CSCORE_CONVERT_SSE)
+  for (; i + 16 <= pixels; i += 16) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+    __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2 + 16));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packus_epi16(YUYVToGray8(a), YUYVToGray8(b)));
+  }
+#endif
+  YUYVToGrayScalar(src + i * 2, dst + i, pixels - i);
+}
+
+void cs::ConvertBGRToGrayPixels(const uint8_t* src, uint8_t* dst,
+                                size_t pixels) {
+  size_t i = 0;
+#if defined(CSCORE_CONVERT_NEON)
+  for (; i + 16 <= pixels; i += 16) {
+    uint8x16x3_t bgr = vld3q_u8(src + i * 3);
+    vst1q_u8(dst + i,
+             vcombine_u8(BGRToGray8(vget_low_u8(bgr.val[0]),
+                                    vget_low_u8(bgr.val[1]),
+                                    vget_low_u8(bgr.val[2])),
+                         BGRToGray8(vget_high_u8(bgr.val[0]),
+                                    vget_high_u8(bgr.val[1]),
+                                    vget_high_u8(bgr.val[2]))));
+  }
+#elif defined(CSCORE_CONVERT_SSE)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= pixels; i += 16) {
+    __m128i b, g, r;
+    LoadBGR16(src + i * 3, &b, &g, &r);
+    __m128i lo = BGRToGray8(_mm_unpacklo_epi8(b, zero),
+                            _mm_unpacklo_epi8(g, zero),
+                            _mm_unpacklo_epi8(r, zero));
+    __m128i hi = BGRToGray8(_mm_unpackhi_epi8(b, zero),
+                            _mm_unpackhi_epi8(g, zero),
+                            _mm_unpackhi_epi8(r, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packus_epi16(lo, hi));
+  }
+#endif
+  BGRToGrayScalar(src + i * 3, dst + i, pixels - i);
+}
+
+void cs::ConvertBGRToRGB565Pixels(const uint8_t* src, uint8_t* dst,
+                                  size_t pixels) {
+  uint16_t* dst16 = reinterpret_cast<uint16_t*>(dst);
+  size_t i = 0;
+#if defined(CSCORE_CONVERT_NEON)
+  for (; i + 16 <= pixels; i += 16) {
+    uint8x16x3_t bgr = vld3q_u8(src + i * 3);
+    vst1q_u16(dst16 + i, BGRToRGB5658(vget_low_u8(bgr.val[0]),
+                                      vget_low_u8(bgr.val[1]),
+                                      vget_low_u8(bgr.val[2])));
+    vst1q_u16(dst16 + i + 8, BGRToRGB5658(vget_high_u8(bgr.val[0]),
+                                          vget_high_u8(bgr.val[1]),
+                                          vget_high_u8(bgr.val[2])));
+  }
+#elif defined(CSCORE_CONVERT_SSE)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= pixels; i += 16) {
+    __m128i b, g, r;
+    LoadBGR16(src + i * 3, &b, &g, &r);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst16 + i),
+                     BGRToRGB5658(_mm_unpacklo_epi8(b, zero),
+                                  _mm_unpacklo_epi8(g, zero),
+                                  _mm_unpacklo_epi8(r, zero)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst16 + i + 8),
+                     BGRToRGB5658(_mm_unpackhi_epi8(b, zero),
+                                  _mm_unpackhi_epi8(g, zero),
+                                  _mm_unpackhi_epi8(r, zero)));
+  }
+#endif
+  BGRToRGB565Scalar(src + i * 3, dst16 + i, pixels - i);
+}
+
+void cs::ConvertRGB565ToBGRPixels(const uint8_t* src, uint8_t* dst,
+                                  size_t pixels) {
+  const uint16_t* src16 = reinterpret_cast<const uint16_t*>(src);
+  size_t i = 0;
+#if defined(CSCORE_CONVERT_NEON)
+  for (; i + 16 <= pixels; i += 16) {
+    uint8x8_t blo, glo, rlo, bhi, ghi, rhi;
+    RGB565ToBGR8(vld1q_u16(src16 + i), &blo, &glo, &rlo);
+    RGB565ToBGR8(vld1q_u16(src16 + i + 8), &bhi, &ghi, &rhi);
+    uint8x16x3_t bgr;
+    bgr.val[0] = vcombine_u8(blo, bhi);
+    bgr.val[1] = vcombine_u8(glo, ghi);
+    bgr.val[2] = vcombine_u8(rlo, rhi);
+    vst3q_u8(dst + i * 3, bgr);
+  }
+#elif defined(CSCORE_CONVERT_SSE)
+  for (; i + 16 <= pixels; i += 16) {
+    __m128i blo, glo, rlo, bhi, ghi, rhi;
+    RGB565ToBGR8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src16 + i)), &blo,
+        &glo, &rlo);
+    RGB565ToBGR8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src16 + i + 8)),
+        &bhi, &ghi, &rhi);
+    StoreBGR16(dst + i * 3, _mm_packus_epi16(blo, bhi),
+               _mm_packus_epi16(glo, ghi), _mm_packus_epi16(rlo, rhi));
+  }
+#endif
+  RGB565ToBGRScalar(src16 + i, dst + i * 3, pixels - i);
+}
+
+void cs::ConvertGrayToBGRPixels(const uint8_t* src, uint8_t* dst,
+                                size_t pixels) {
+  size_t i = 0;
+#if defined(CSCORE_CONVERT_NEON)
+  for (; i + 16 <= pixels; i += 16) {
+    uint8x16x3_t bgr;
+    bgr.val[0] = bgr.val[1] = bgr.val[2] = vld1q_u8(src + i);
+    vst3q_u8(dst + i * 3, bgr);
+  }
+#elif defined(CSCORE_CONVERT_SSE)
+  for (; i + 16 <= pixels; i += 16) {
+    __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    StoreGrayAsBGR16(dst + i * 3, g);
+  }
+#endif
+  GrayToBGRScalar(src + i, dst + i * 3, pixels - i);
+}
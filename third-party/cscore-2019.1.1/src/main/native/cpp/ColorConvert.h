@@ -0,0 +1,44 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef CSCORE_COLORCONVERT_H_
+#define CSCORE_COLORCONVERT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace cs {
+
+// Pixel format conversions over contiguous images of the given number of
+// pixels, vectorized with NEON or SSE4.1 where the target has them.  Results
+// are bit for bit those of the cv::cvtColor codes noted, which Frame used to
+// call; the fixed point arithmetic is OpenCV's.
+
+// cv::COLOR_YUV2BGR_YUYV; pixels must be even
+void ConvertYUYVToBGRPixels(const uint8_t* src, uint8_t* dst, size_t pixels);
+
+// The luma of each pixel, stretched from video to full range the way
+// ConvertYUYVToBGRPixels() does, so a gray pixel comes out the same as going
+// through BGR; pixels must be even
+void ConvertYUYVToGrayPixels(const uint8_t* src, uint8_t* dst, size_t pixels);
+
+// cv::COLOR_BGR2GRAY
+void ConvertBGRToGrayPixels(const uint8_t* src, uint8_t* dst, size_t pixels);
+
+// cv::COLOR_RGB2BGR565 applied to BGR, as Frame always has; each pixel is a
+// native endian 16 bit value
+void ConvertBGRToRGB565Pixels(const uint8_t* src, uint8_t* dst, size_t pixels);
+
+// cv::COLOR_BGR5652RGB giving BGR, the inverse of the above
+void ConvertRGB565ToBGRPixels(const uint8_t* src, uint8_t* dst, size_t pixels);
+
+// cv::COLOR_GRAY2BGR
+void ConvertGrayToBGRPixels(const uint8_t* src, uint8_t* dst, size_t pixels);
+
+}  // namespace cs
+
+#endif  // CSCORE_COLORCONVERT_H_
@@ -7,18 +7,169 @@
 
 #include "Frame.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <limits>
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
+#include "ColorConvert.h"
 #include "Instance.h"
 #include "Log.h"
 #include "SourceImpl.h"
+#include "Telemetry.h"
 
 using namespace cs;
 
+namespace {
+
+constexpr int kNumFormats = VideoMode::kGray + 1;
+constexpr int kNoRoute = std::numeric_limits<int>::max() / 4;
+
+// Rough relative cost per pixel of each conversion Frame can do directly,
+// indexed [from][to]; 0 where there is none.  JPEG decode and encode dwarf
+// the color conversions, and decoding or encoding just the luma is cheaper
+// than the full color version.
+const int kConvertCost[kNumFormats][kNumFormats] = {
+    // to:  -, MJPEG, YUYV, RGB565, BGR, Gray
+    {0, 0, 0, 0, 0, 0},    // unknown
+    {0, 0, 0, 0, 12, 8},   // MJPEG
+    {0, 0, 0, 0, 2, 1},    // YUYV
+    {0, 0, 0, 0, 1, 0},    // RGB565
+    {0, 10, 0, 1, 0, 1},   // BGR
+    {0, 6, 0, 0, 1, 0}};   // Gray
+
+// Cost per output pixel of resizing.  Only BGR and gray are resized; the
+// packed formats would have neighbouring samples of different channels
+// blended together.
+const int kResizeCost[kNumFormats] = {0, 0, 0, 0, 3, 1};
+
+// libjpeg can decode at 1/2, 1/4 or 1/8 scale by doing a smaller IDCT per
+// block, which OpenCV exposes as the IMREAD_REDUCED flags.  The decoded size
+// rounds up.
+int ScaledJpegSize(int size, int scale) { return (size + scale - 1) / scale; }
+
+int ReducedJpegFlag(int flag, int scale) {
+  bool color = flag == cv::IMREAD_COLOR;
+  switch (scale) {
+    case 2:
+      return color ? cv::IMREAD_REDUCED_COLOR_2
+                   : cv::IMREAD_REDUCED_GRAYSCALE_2;
+    case 4:
+      return color ? cv::IMREAD_REDUCED_COLOR_4
+                   : cv::IMREAD_REDUCED_GRAYSCALE_4;
+    case 8:
+      return color ? cv::IMREAD_REDUCED_COLOR_8
+                   : cv::IMREAD_REDUCED_GRAYSCALE_8;
+    default:
+      return flag;
+  }
+}
+
+// The part of the cost of decoding a JPEG that doesn't shrink with the scale:
+// the entropy decoding of every coefficient
+const int kJpegEntropyCost = 4;
+
+// The formats a conversion passes through after its start, and its cost
+// per pixel
+struct Route {
+  int cost = kNoRoute;
+  int length = 0;
+  VideoMode::PixelFormat steps[kNumFormats] = {};
+};
+
+// Finds the cheapest route between two formats.  Intermediate images never
+// throw information away: nothing is routed through JPEG, and nothing is
+// routed through gray unless it started out gray.  A route from a format to
+// itself is what re-encoding a JPEG at another quality takes.
+Route FindRoute(VideoMode::PixelFormat from, VideoMode::PixelFormat to) {
+  int cost[kNumFormats];
+  int prev[kNumFormats];
+  bool done[kNumFormats] = {};
+  for (int i = 0; i < kNumFormats; ++i) {
+    cost[i] = kConvertCost[from][i] != 0 ? kConvertCost[from][i] : kNoRoute;
+    prev[i] = from;
+  }
+
+  for (;;) {
+    int cur = -1;
+    for (int i = 0; i < kNumFormats; ++i) {
+      if (!done[i] && cost[i] < kNoRoute && (cur < 0 || cost[i] < cost[cur]))
+        cur = i;
+    }
+    if (cur < 0) return Route{};
+    if (cur == to) break;
+    done[cur] = true;
+    if (cur == VideoMode::kMJPEG ||
+        (cur == VideoMode::kGray && from != VideoMode::kGray))
+      continue;
+    for (int i = 0; i < kNumFormats; ++i) {
+      int next = cost[cur] + kConvertCost[cur][i];
+      if (kConvertCost[cur][i] != 0 && next < cost[i]) {
+        cost[i] = next;
+        prev[i] = cur;
+      }
+    }
+  }
+
+  Route route;
+  route.cost = cost[to];
+  int at = to;
+  do {
+    route.steps[route.length++] = static_cast<VideoMode::PixelFormat>(at);
+    at = prev[at];
+  } while (at != from && route.length < kNumFormats);
+  std::reverse(route.steps, route.steps + route.length);
+  return route;
+}
+
+// Like FindRoute(), but staying put is free
+Route FindRouteOrStay(VideoMode::PixelFormat from,
+                      VideoMode::PixelFormat to) {
+  if (from != to) return FindRoute(from, to);
+  Route route;
+  route.cost = 0;
+  return route;
+}
+
+// How to get a requested image from one already in the frame: convert it at
+// its own size, resize it if needed, then convert again at the requested
+// size
+struct Plan {
+  Image* image = nullptr;
+  int64_t cost = std::numeric_limits<int64_t>::max();
+  Route before;
+  int decodeScale = 1;  // the first step of before decodes at 1/decodeScale
+  bool resize = false;
+  Route after;
+};
+
+CS_TelemetryKind ConversionKind(VideoMode::PixelFormat from,
+                                VideoMode::PixelFormat to) {
+  switch (from) {
+    case VideoMode::kMJPEG:
+      return to == VideoMode::kGray ? CS_CONVERT_MJPEG_TO_GRAY
+                                    : CS_CONVERT_MJPEG_TO_BGR;
+    case VideoMode::kYUYV:
+      return to == VideoMode::kGray ? CS_CONVERT_YUYV_TO_GRAY
+                                    : CS_CONVERT_YUYV_TO_BGR;
+    case VideoMode::kRGB565:
+      return CS_CONVERT_RGB565_TO_BGR;
+    case VideoMode::kGray:
+      return to == VideoMode::kMJPEG ? CS_CONVERT_GRAY_TO_MJPEG
+                                     : CS_CONVERT_GRAY_TO_BGR;
+    case VideoMode::kBGR:
+    default:
+      if (to == VideoMode::kMJPEG) return CS_CONVERT_BGR_TO_MJPEG;
+      return to == VideoMode::kGray ? CS_CONVERT_BGR_TO_GRAY
+                                    : CS_CONVERT_BGR_TO_RGB565;
+  }
+}
+
+}  // namespace
+
 Frame::Frame(SourceImpl& source, const wpi::Twine& error, Time time)
     : m_impl{source.AllocFrameImpl().release()} {
   m_impl->refcount = 1;
@@ -160,95 +311,99 @@ Image* Frame::GetNearestImage(int width, int height,
 }
 
 Image* Frame::ConvertImpl(Image* image, VideoMode::PixelFormat pixelFormat,
-                          int requiredJpegQuality, int defaultJpegQuality) {
+                          int requiredJpegQuality, int defaultJpegQuality,
+                          const SinkImpl* sink) {
   if (!image ||
       image->Is(image->width, image->height, pixelFormat, requiredJpegQuality))
     return image;
-  Image* cur = image;
-
-  // If the source image is a JPEG, we need to decode it before we can do
-  // anything else with it.  Note that if the destination format is JPEG, we
-  // still need to do this (unless it was already a JPEG, in which case we
-  // would have returned above).
-  if (cur->pixelFormat == VideoMode::kMJPEG) {
-    cur = ConvertMJPEGToBGR(cur);
-    if (pixelFormat == VideoMode::kBGR) return cur;
-  }
+  return GetImageImpl(image->width, image->height, pixelFormat,
+                      requiredJpegQuality, defaultJpegQuality, sink);
+}
 
-  // Color convert
-  switch (pixelFormat) {
-    case VideoMode::kRGB565:
-      // If source is YUYV or Gray, need to convert to BGR first
-      if (cur->pixelFormat == VideoMode::kYUYV) {
-        // Check to see if BGR version already exists...
-        if (Image* newImage =
-                GetExistingImage(cur->width, cur->height, VideoMode::kBGR))
-          cur = newImage;
-        else
-          cur = ConvertYUYVToBGR(cur);
-      } else if (cur->pixelFormat == VideoMode::kGray) {
-        // Check to see if BGR version already exists...
-        if (Image* newImage =
-                GetExistingImage(cur->width, cur->height, VideoMode::kBGR))
-          cur = newImage;
-        else
-          cur = ConvertGrayToBGR(cur);
-      }
-      return ConvertBGRToRGB565(cur);
-    case VideoMode::kGray:
-      // If source is YUYV or RGB565, need to convert to BGR first
-      if (cur->pixelFormat == VideoMode::kYUYV) {
-        // Check to see if BGR version already exists...
-        if (Image* newImage =
-                GetExistingImage(cur->width, cur->height, VideoMode::kBGR))
-          cur = newImage;
-        else
-          cur = ConvertYUYVToBGR(cur);
-      } else if (cur->pixelFormat == VideoMode::kRGB565) {
-        // Check to see if BGR version already exists...
-        if (Image* newImage =
-                GetExistingImage(cur->width, cur->height, VideoMode::kBGR))
-          cur = newImage;
-        else
-          cur = ConvertRGB565ToBGR(cur);
-      }
-      return ConvertBGRToGray(cur);
-    case VideoMode::kBGR:
+Image* Frame::ConvertStep(Image* image, VideoMode::PixelFormat pixelFormat,
+                          int jpegQuality, const SinkImpl* sink,
+                          int decodeScale) {
+  VideoMode::PixelFormat from = image->pixelFormat;
+  Image* rv = nullptr;
+  switch (from) {
     case VideoMode::kMJPEG:
-      if (cur->pixelFormat == VideoMode::kYUYV) {
-        cur = ConvertYUYVToBGR(cur);
-      } else if (cur->pixelFormat == VideoMode::kRGB565) {
-        cur = ConvertRGB565ToBGR(cur);
-      } else if (cur->pixelFormat == VideoMode::kGray) {
-        if (pixelFormat == VideoMode::kBGR)
-          return ConvertGrayToBGR(cur);
-        else
-          return ConvertGrayToMJPEG(cur, defaultJpegQuality);
-      }
+      rv = pixelFormat == VideoMode::kGray
+               ? ConvertMJPEGToGray(image, decodeScale)
+               : ConvertMJPEGToBGR(image, decodeScale);
       break;
     case VideoMode::kYUYV:
+      rv = pixelFormat == VideoMode::kGray ? ConvertYUYVToGray(image)
+                                           : ConvertYUYVToBGR(image);
+      break;
+    case VideoMode::kRGB565:
+      rv = ConvertRGB565ToBGR(image);
+      break;
+    case VideoMode::kBGR:
+      if (pixelFormat == VideoMode::kMJPEG)
+        rv = ConvertBGRToMJPEG(image, jpegQuality);
+      else if (pixelFormat == VideoMode::kGray)
+        rv = ConvertBGRToGray(image);
+      else
+        rv = ConvertBGRToRGB565(image);
+      break;
+    case VideoMode::kGray:
+      if (pixelFormat == VideoMode::kMJPEG)
+        rv = ConvertGrayToMJPEG(image, jpegQuality);
+      else
+        rv = ConvertGrayToBGR(image);
+      break;
     default:
-      return nullptr;  // Unsupported
+      return nullptr;
   }
+  if (rv)
+    m_impl->source.m_telemetry.RecordConversion(
+        m_impl->source, sink, ConversionKind(from, pixelFormat));
+  return rv;
+}
 
-  // Compress if destination is JPEG
-  if (pixelFormat == VideoMode::kMJPEG)
-    cur = ConvertBGRToMJPEG(cur, defaultJpegQuality);
+Image* Frame::Resize(Image* image, int width, int height,
+                     const SinkImpl* sink) {
+  // Allocate an image.
+  auto newImage = m_impl->source.AllocImage(
+      image->pixelFormat, width, height,
+      width * height * (image->size() / (image->width * image->height)));
 
-  return cur;
+  // Resize
+  cv::Mat newMat = newImage->AsMat();
+  cv::resize(image->AsMat(), newMat, newMat.size(), 0, 0);
+
+  // Save the result
+  Image* rv = newImage.release();
+  m_impl->images.push_back(rv);
+  m_impl->source.m_telemetry.RecordConversion(m_impl->source, sink,
+                                              CS_CONVERT_RESIZE);
+  return rv;
 }
 
-Image* Frame::ConvertMJPEGToBGR(Image* image) {
+Image* Frame::ConvertMJPEGToBGR(Image* image, int scale) {
   if (!image || image->pixelFormat != VideoMode::kMJPEG) return nullptr;
 
   // Allocate an BGR image
-  auto newImage =
-      m_impl->source.AllocImage(VideoMode::kBGR, image->width, image->height,
-                                image->width * image->height * 3);
+  int width = ScaledJpegSize(image->width, scale);
+  int height = ScaledJpegSize(image->height, scale);
+  auto newImage = m_impl->source.AllocImage(VideoMode::kBGR, width, height,
+                                            width * height * 3);
 
   // Decode
   cv::Mat newMat = newImage->AsMat();
-  cv::imdecode(image->AsInputArray(), cv::IMREAD_COLOR, &newMat);
+  cv::imdecode(image->AsInputArray(),
+               ReducedJpegFlag(cv::IMREAD_COLOR, scale), &newMat);
+  if (newMat.data != reinterpret_cast<uchar*>(newImage->data())) {
+    // The decoder disagreed about the size and allocated its own; keep what
+    // it decoded rather than decoding again
+    if (scale != 1) m_impl->source.m_scaledDecodeFailed = true;
+    m_impl->source.ReleaseImage(std::move(newImage));
+    newImage = m_impl->source.AllocImage(VideoMode::kBGR, newMat.cols,
+                                         newMat.rows,
+                                         newMat.cols * newMat.rows * 3);
+    cv::Mat fitted = newImage->AsMat();
+    newMat.copyTo(fitted);
+  }
 
   // Save the result
   Image* rv = newImage.release();
@@ -259,17 +414,30 @@ Image* Frame::ConvertMJPEGToBGR(Image* image) {
   return rv;
 }
 
-Image* Frame::ConvertMJPEGToGray(Image* image) {
+Image* Frame::ConvertMJPEGToGray(Image* image, int scale) {
   if (!image || image->pixelFormat != VideoMode::kMJPEG) return nullptr;
 
   // Allocate an grayscale image
-  auto newImage =
-      m_impl->source.AllocImage(VideoMode::kGray, image->width, image->height,
-                                image->width * image->height);
+  int width = ScaledJpegSize(image->width, scale);
+  int height = ScaledJpegSize(image->height, scale);
+  auto newImage = m_impl->source.AllocImage(VideoMode::kGray, width, height,
+                                            width * height);
 
   // Decode
   cv::Mat newMat = newImage->AsMat();
-  cv::imdecode(image->AsInputArray(), cv::IMREAD_GRAYSCALE, &newMat);
+  cv::imdecode(image->AsInputArray(),
+               ReducedJpegFlag(cv::IMREAD_GRAYSCALE, scale), &newMat);
+  if (newMat.data != reinterpret_cast<uchar*>(newImage->data())) {
+    // The decoder disagreed about the size and allocated its own; keep what
+    // it decoded rather than decoding again
+    if (scale != 1) m_impl->source.m_scaledDecodeFailed = true;
+    m_impl->source.ReleaseImage(std::move(newImage));
+    newImage = m_impl->source.AllocImage(VideoMode::kGray, newMat.cols,
+                                         newMat.rows,
+                                         newMat.cols * newMat.rows);
+    cv::Mat fitted = newImage->AsMat();
+    newMat.copyTo(fitted);
+  }
 
   // Save the result
   Image* rv = newImage.release();
@@ -289,7 +457,31 @@ Image* Frame::ConvertYUYVToBGR(Image* image) {
                                 image->width * image->height * 3);
 
   // Convert
-  cv::cvtColor(image->AsMat(), newImage->AsMat(), cv::COLOR_YUV2BGR_YUYV);
+  ConvertYUYVToBGRPixels(reinterpret_cast<const uint8_t*>(image->data()),
+                         reinterpret_cast<uint8_t*>(newImage->data()),
+                         image->width * image->height);
+
+  // Save the result
+  Image* rv = newImage.release();
+  if (m_impl) {
+    std::lock_guard<wpi::recursive_mutex> lock(m_impl->mutex);
+    m_impl->images.push_back(rv);
+  }
+  return rv;
+}
+
+Image* Frame::ConvertYUYVToGray(Image* image) {
+  if (!image || image->pixelFormat != VideoMode::kYUYV) return nullptr;
+
+  // Allocate a Grayscale image
+  auto newImage =
+      m_impl->source.AllocImage(VideoMode::kGray, image->width, image->height,
+                                image->width * image->height);
+
+  // Convert
+  ConvertYUYVToGrayPixels(reinterpret_cast<const uint8_t*>(image->data()),
+                          reinterpret_cast<uint8_t*>(newImage->data()),
+                          image->width * image->height);
 
   // Save the result
   Image* rv = newImage.release();
@@ -309,7 +501,9 @@ Image* Frame::ConvertBGRToRGB565(Image* image) {
                                 image->width * image->height * 2);
 
   // Convert
-  cv::cvtColor(image->AsMat(), newImage->AsMat(), cv::COLOR_RGB2BGR565);
+  ConvertBGRToRGB565Pixels(reinterpret_cast<const uint8_t*>(image->data()),
+                           reinterpret_cast<uint8_t*>(newImage->data()),
+                           image->width * image->height);
 
   // Save the result
   Image* rv = newImage.release();
@@ -329,7 +523,9 @@ Image* Frame::ConvertRGB565ToBGR(Image* image) {
                                 image->width * image->height * 3);
 
   // Convert
-  cv::cvtColor(image->AsMat(), newImage->AsMat(), cv::COLOR_BGR5652RGB);
+  ConvertRGB565ToBGRPixels(reinterpret_cast<const uint8_t*>(image->data()),
+                           reinterpret_cast<uint8_t*>(newImage->data()),
+                           image->width * image->height);
 
   // Save the result
   Image* rv = newImage.release();
@@ -349,7 +545,9 @@ Image* Frame::ConvertBGRToGray(Image* image) {
                                 image->width * image->height);
 
   // Convert
-  cv::cvtColor(image->AsMat(), newImage->AsMat(), cv::COLOR_BGR2GRAY);
+  ConvertBGRToGrayPixels(reinterpret_cast<const uint8_t*>(image->data()),
+                         reinterpret_cast<uint8_t*>(newImage->data()),
+                         image->width * image->height);
 
   // Save the result
   Image* rv = newImage.release();
@@ -361,7 +559,7 @@ Image* Frame::ConvertBGRToGray(Image* image) {
 }
 
 Image* Frame::ConvertGrayToBGR(Image* image) {
-  if (!image || image->pixelFormat != VideoMode::kBGR) return nullptr;
+  if (!image || image->pixelFormat != VideoMode::kGray) return nullptr;
 
   // Allocate a BGR image
   auto newImage =
@@ -369,7 +567,9 @@ Image* Frame::ConvertGrayToBGR(Image* image) {
                                 image->width * image->height * 3);
 
   // Convert
-  cv::cvtColor(image->AsMat(), newImage->AsMat(), cv::COLOR_GRAY2BGR);
+  ConvertGrayToBGRPixels(reinterpret_cast<const uint8_t*>(image->data()),
+                         reinterpret_cast<uint8_t*>(newImage->data()),
+                         image->width * image->height);
 
   // Save the result
   Image* rv = newImage.release();
@@ -444,47 +644,110 @@ Image* Frame::ConvertGrayToMJPEG(Image* image, int quality) {
 
 Image* Frame::GetImageImpl(int width, int height,
                            VideoMode::PixelFormat pixelFormat,
-                           int requiredJpegQuality, int defaultJpegQuality) {
+                           int requiredJpegQuality, int defaultJpegQuality,
+                           const SinkImpl* sink) {
   if (!m_impl) return nullptr;
   std::lock_guard<wpi::recursive_mutex> lock(m_impl->mutex);
-  Image* cur = GetNearestImage(width, height, pixelFormat, requiredJpegQuality);
-  if (!cur || cur->Is(width, height, pixelFormat, requiredJpegQuality))
-    return cur;
+  if (Image* found =
+          GetExistingImage(width, height, pixelFormat, requiredJpegQuality))
+    return found;
+  if (pixelFormat <= VideoMode::kUnknown || pixelFormat >= kNumFormats)
+    return nullptr;
+
+  // Price getting there from each image we already have.  Sizing up loses
+  // detail, so it's only done when no image is at least as large as asked.
+  bool haveLarger = false;
+  for (auto i : m_impl->images) {
+    if (i->IsLarger(width, height)) haveLarger = true;
+  }
+  int64_t outPixels = static_cast<int64_t>(width) * height;
+  Plan plan;
+  for (auto i : m_impl->images) {
+    if (i->pixelFormat <= VideoMode::kUnknown ||
+        i->pixelFormat >= kNumFormats)
+      continue;
+    if (i->Is(width, height)) {
+      Route route = FindRoute(i->pixelFormat, pixelFormat);
+      int64_t cost = route.cost * outPixels;
+      if (route.cost < kNoRoute && cost < plan.cost) {
+        plan = Plan{};
+        plan.image = i;
+        plan.cost = cost;
+        plan.after = route;
+      }
+      continue;
+    }
+    if (haveLarger && !i->IsLarger(width, height)) continue;
+    int64_t inPixels = static_cast<int64_t>(i->width) * i->height;
+    for (auto via : {VideoMode::kBGR, VideoMode::kGray}) {
+      // only lose color if it was never there or isn't wanted
+      if (via == VideoMode::kGray && i->pixelFormat != VideoMode::kGray &&
+          pixelFormat != VideoMode::kGray)
+        continue;
+      Route before = FindRouteOrStay(i->pixelFormat, via);
+      Route after = FindRouteOrStay(via, pixelFormat);
+      if (before.cost >= kNoRoute || after.cost >= kNoRoute) continue;
+      int64_t cost = before.cost * inPixels +
+                     (kResizeCost[via] + after.cost) * outPixels;
+      if (cost < plan.cost) {
+        plan.image = i;
+        plan.cost = cost;
+        plan.before = before;
+        plan.decodeScale = 1;
+        plan.resize = true;
+        plan.after = after;
+      }
+
+      // A JPEG can instead be decoded straight to a fraction of its size,
+      // as long as that is still no smaller than asked
+      if (i->pixelFormat != VideoMode::kMJPEG ||
+          m_impl->source.m_scaledDecodeFailed)
+        continue;
+      for (int scale = 2; scale <= 8; scale *= 2) {
+        int scaledWidth = ScaledJpegSize(i->width, scale);
+        int scaledHeight = ScaledJpegSize(i->height, scale);
+        if (scaledWidth < width || scaledHeight < height) break;
+        int64_t scaledPixels =
+            static_cast<int64_t>(scaledWidth) * scaledHeight;
+        bool resize = scaledWidth != width || scaledHeight != height;
+        cost = kJpegEntropyCost * inPixels +
+               (before.cost - kJpegEntropyCost) * scaledPixels +
+               ((resize ? kResizeCost[via] : 0) + after.cost) * outPixels;
+        if (cost < plan.cost) {
+          plan.image = i;
+          plan.cost = cost;
+          plan.before = before;
+          plan.decodeScale = scale;
+          plan.resize = resize;
+          plan.after = after;
+        }
+      }
+    }
+  }
+  if (!plan.image) return nullptr;  // Unsupported
 
   WPI_DEBUG4(Instance::GetInstance().logger,
-             "converting image from " << cur->width << "x" << cur->height
-                                      << " type " << cur->pixelFormat << " to "
+             "converting image from " << plan.image->width << "x"
+                                      << plan.image->height << " type "
+                                      << plan.image->pixelFormat << " to "
                                       << width << "x" << height << " type "
                                       << pixelFormat);
 
-  // If the source image is a JPEG, we need to decode it before we can do
-  // anything else with it.  Note that if the destination format is JPEG, we
-  // still need to do this (unless the width/height/compression were the same,
-  // in which case we already returned the existing JPEG above).
-  if (cur->pixelFormat == VideoMode::kMJPEG) cur = ConvertMJPEGToBGR(cur);
-
-  // Resize
-  if (!cur->Is(width, height)) {
-    // Allocate an image.
-    auto newImage = m_impl->source.AllocImage(
-        cur->pixelFormat, width, height,
-        width * height * (cur->size() / (cur->width * cur->height)));
-
-    // Resize
-    cv::Mat newMat = newImage->AsMat();
-    cv::resize(cur->AsMat(), newMat, newMat.size(), 0, 0);
-
-    // Save the result
-    cur = newImage.release();
-    m_impl->images.push_back(cur);
-  }
-
-  // Convert to output format
-  return ConvertImpl(cur, pixelFormat, requiredJpegQuality, defaultJpegQuality);
+  Image* cur = plan.image;
+  for (int i = 0; cur && i < plan.before.length; ++i)
+    cur = ConvertStep(cur, plan.before.steps[i], defaultJpegQuality, sink,
+                      i == 0 ? plan.decodeScale : 1);
+  // A scaled decode may have come out at full size instead
+  if (cur && (plan.resize || !cur->Is(width, height)))
+    cur = Resize(cur, width, height, sink);
+  for (int i = 0; cur && i < plan.after.length; ++i)
+    cur = ConvertStep(cur, plan.after.steps[i], defaultJpegQuality, sink);
+  return cur;
 }
 
-bool Frame::GetCv(cv::Mat& image, int width, int height) {
-  Image* rawImage = GetImage(width, height, VideoMode::kBGR);
+bool Frame::GetCv(cv::Mat& image, int width, int height,
+                  const SinkImpl* sink) {
+  Image* rawImage = GetImage(width, height, VideoMode::kBGR, sink);
   if (!rawImage) return false;
   rawImage->AsMat().copyTo(image);
   return true;
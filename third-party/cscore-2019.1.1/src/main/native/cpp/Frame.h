@@ -23,6 +23,7 @@
 
 namespace cs {
 
+class SinkImpl;
 class SourceImpl;
 
 class Frame {
@@ -148,18 +149,24 @@ class Frame {
                          VideoMode::PixelFormat pixelFormat,
                          int jpegQuality = -1) const;
 
-  Image* Convert(Image* image, VideoMode::PixelFormat pixelFormat) {
+  // The conversions below are counted in telemetry against the frame's
+  // source and, when given, the sink asking for them.
+  Image* Convert(Image* image, VideoMode::PixelFormat pixelFormat,
+                 const SinkImpl* sink = nullptr) {
     if (pixelFormat == VideoMode::kMJPEG) return nullptr;
-    return ConvertImpl(image, pixelFormat, -1, 80);
+    return ConvertImpl(image, pixelFormat, -1, 80, sink);
   }
   Image* ConvertToMJPEG(Image* image, int requiredQuality,
-                        int defaultQuality = 80) {
+                        int defaultQuality = 80,
+                        const SinkImpl* sink = nullptr) {
     return ConvertImpl(image, VideoMode::kMJPEG, requiredQuality,
-                       defaultQuality);
+                       defaultQuality, sink);
   }
-  Image* ConvertMJPEGToBGR(Image* image);
-  Image* ConvertMJPEGToGray(Image* image);
+  // A scale of 2, 4 or 8 decodes at that fraction of the full size
+  Image* ConvertMJPEGToBGR(Image* image, int scale = 1);
+  Image* ConvertMJPEGToGray(Image* image, int scale = 1);
   Image* ConvertYUYVToBGR(Image* image);
+  Image* ConvertYUYVToGray(Image* image);
   Image* ConvertBGRToRGB565(Image* image);
   Image* ConvertRGB565ToBGR(Image* image);
   Image* ConvertBGRToGray(Image* image);
@@ -167,26 +174,35 @@ class Frame {
   Image* ConvertBGRToMJPEG(Image* image, int quality);
   Image* ConvertGrayToMJPEG(Image* image, int quality);
 
-  Image* GetImage(int width, int height, VideoMode::PixelFormat pixelFormat) {
+  Image* GetImage(int width, int height, VideoMode::PixelFormat pixelFormat,
+                  const SinkImpl* sink = nullptr) {
     if (pixelFormat == VideoMode::kMJPEG) return nullptr;
-    return GetImageImpl(width, height, pixelFormat, -1, 80);
+    return GetImageImpl(width, height, pixelFormat, -1, 80, sink);
   }
   Image* GetImageMJPEG(int width, int height, int requiredQuality,
-                       int defaultQuality = 80) {
+                       int defaultQuality = 80,
+                       const SinkImpl* sink = nullptr) {
     return GetImageImpl(width, height, VideoMode::kMJPEG, requiredQuality,
-                        defaultQuality);
+                        defaultQuality, sink);
   }
 
-  bool GetCv(cv::Mat& image) {
-    return GetCv(image, GetOriginalWidth(), GetOriginalHeight());
+  bool GetCv(cv::Mat& image, const SinkImpl* sink = nullptr) {
+    return GetCv(image, GetOriginalWidth(), GetOriginalHeight(), sink);
   }
-  bool GetCv(cv::Mat& image, int width, int height);
+  bool GetCv(cv::Mat& image, int width, int height,
+             const SinkImpl* sink = nullptr);
 
  private:
   Image* ConvertImpl(Image* image, VideoMode::PixelFormat pixelFormat,
-                     int requiredJpegQuality, int defaultJpegQuality);
+                     int requiredJpegQuality, int defaultJpegQuality,
+                     const SinkImpl* sink);
   Image* GetImageImpl(int width, int height, VideoMode::PixelFormat pixelFormat,
-                      int requiredJpegQuality, int defaultJpegQuality);
+                      int requiredJpegQuality, int defaultJpegQuality,
+                      const SinkImpl* sink);
+  Image* ConvertStep(Image* image, VideoMode::PixelFormat pixelFormat,
+                     int jpegQuality, const SinkImpl* sink,
+                     int decodeScale = 1);
+  Image* Resize(Image* image, int width, int height, const SinkImpl* sink);
   void DecRef() {
     if (m_impl && --(m_impl->refcount) == 0) ReleaseFrame();
   }
@@ -0,0 +1,71 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef CSCORE_FREESLOTS_H_
+#define CSCORE_FREESLOTS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace cs {
+
+// A fixed number of slots holding objects kept for reuse, which any thread
+// can take from or give to without locking.  An object is claimed by
+// exchanging its slot with null, so a slot is never read after another
+// thread may have taken it (no ABA problem).  Giving to full slots fails,
+// which bounds what is retained.
+template <typename T, size_t N>
+class FreeSlots {
+ public:
+  FreeSlots() {
+    for (auto& slot : m_slots) slot.store(nullptr, std::memory_order_relaxed);
+  }
+  ~FreeSlots() { Clear(); }
+
+  FreeSlots(const FreeSlots&) = delete;
+  FreeSlots& operator=(const FreeSlots&) = delete;
+
+  // Takes any object held, or returns null if there are none.
+  std::unique_ptr<T> Take() {
+    for (auto& slot : m_slots) {
+      if (!slot.load(std::memory_order_relaxed)) continue;
+      if (T* obj = slot.exchange(nullptr, std::memory_order_acquire))
+        return std::unique_ptr<T>{obj};
+    }
+    return nullptr;
+  }
+
+  // Gives an object to the first free slot.  If there is none, the object
+  // is handed back to the caller and false is returned.
+  bool Give(std::unique_ptr<T>& obj) {
+    for (auto& slot : m_slots) {
+      T* expected = nullptr;
+      if (slot.load(std::memory_order_relaxed)) continue;
+      if (slot.compare_exchange_strong(expected, obj.get(),
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+        obj.release();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Frees everything held.
+  void Clear() {
+    for (auto& slot : m_slots)
+      delete slot.exchange(nullptr, std::memory_order_acquire);
+  }
+
+ private:
+  std::atomic<T*> m_slots[N];
+};
+
+}  // namespace cs
+
+#endif  // CSCORE_FREESLOTS_H_
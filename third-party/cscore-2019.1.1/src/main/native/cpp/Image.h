@@ -8,6 +8,8 @@
 #ifndef CSCORE_IMAGE_H_
 #define CSCORE_IMAGE_H_
 
+#include <functional>
+#include <utility>
 #include <vector>
 
 #include <opencv2/core/core.hpp>
@@ -33,6 +35,17 @@ class Image {
   }
 #endif
 
+  // Borrows data owned elsewhere, such as a mapped driver buffer, instead of
+  // holding a copy.  release is called when the image is destroyed.
+  Image(char* data, size_t size, std::function<void()> release)
+      : m_borrowed{reinterpret_cast<uchar*>(data)},
+        m_borrowedSize{size},
+        m_release{std::move(release)} {}
+
+  ~Image() {
+    if (m_release) m_release();
+  }
+
   Image(const Image&) = delete;
   Image& operator=(const Image&) = delete;
 
@@ -41,10 +54,16 @@ class Image {
   wpi::StringRef str() const { return wpi::StringRef(data(), size()); }
   size_t capacity() const { return m_data.capacity(); }
   const char* data() const {
-    return reinterpret_cast<const char*>(m_data.data());
+    return reinterpret_cast<const char*>(m_borrowed ? m_borrowed
+                                                    : m_data.data());
   }
-  char* data() { return reinterpret_cast<char*>(m_data.data()); }
-  size_t size() const { return m_data.size(); }
+  char* data() {
+    return reinterpret_cast<char*>(m_borrowed ? m_borrowed : m_data.data());
+  }
+  size_t size() const { return m_borrowed ? m_borrowedSize : m_data.size(); }
+
+  // Borrowed images can't be resized or pooled, only given back
+  bool IsBorrowed() const { return m_borrowed != nullptr; }
 
   const std::vector<uchar>& vec() const { return m_data; }
   std::vector<uchar>& vec() { return m_data; }
@@ -68,10 +87,14 @@ class Image {
         type = CV_8UC1;
         break;
     }
-    return cv::Mat{height, width, type, m_data.data()};
+    return cv::Mat{height, width, type, data()};
   }
 
-  cv::_InputArray AsInputArray() { return cv::_InputArray{m_data}; }
+  cv::_InputArray AsInputArray() {
+    if (m_borrowed)
+      return cv::_InputArray{m_borrowed, static_cast<int>(m_borrowedSize)};
+    return cv::_InputArray{m_data};
+  }
 
   bool Is(int width_, int height_) {
     return width == width_ && height == height_;
@@ -98,6 +121,9 @@ class Image {
 
  private:
   std::vector<uchar> m_data;
+  uchar* m_borrowed{nullptr};
+  size_t m_borrowedSize{0};
+  std::function<void()> m_release;
 
  public:
   VideoMode::PixelFormat pixelFormat{VideoMode::kUnknown};
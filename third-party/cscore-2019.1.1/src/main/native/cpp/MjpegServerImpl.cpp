@@ -7,11 +7,15 @@
 
 #include "MjpegServerImpl.h"
 
+#include <algorithm>
 #include <chrono>
 
 #include <wpi/HttpUtil.h>
+#include <wpi/ArrayRef.h>
 #include <wpi/SmallString.h>
 #include <wpi/TCPAcceptor.h>
+#include <wpi/condition_variable.h>
+#include <wpi/mutex.h>
 #include <wpi/raw_socket_istream.h>
 #include <wpi/raw_socket_ostream.h>
 
@@ -73,6 +77,59 @@ static const char* startRootPage =
     "<div class=\"settings\">\n";
 static const char* endRootPage = "</div></body></html>";
 
+// A frame encoded for streaming, shared by every client that asked for it.
+// Holding the frame keeps the image alive.
+struct MjpegServerImpl::EncodedFrame {
+  EncodedFrame(const Frame& frame_, Image* image_)
+      : frame{frame_}, image{image_} {}
+
+  Frame frame;
+  Image* image;
+};
+
+// What a streaming client asked for, and the next frame waiting to be sent
+// to it.  A client that sends slower than the source delivers only ever has
+// the newest frame waiting; those it had no time for are dropped rather than
+// holding up the encoder.
+struct MjpegServerImpl::Subscription {
+  int width = 0;  // 0 for the source's size
+  int height = 0;
+  int compression = -1;
+  int defaultCompression = 80;
+  Frame::Time timePerFrame = 0;
+  Frame::Time lastFrameTime = 0;  // only touched by the encoder
+
+  wpi::mutex mutex;
+  wpi::condition_variable cond;
+  std::shared_ptr<EncodedFrame> pending;
+  int dropped = 0;
+};
+
+// The streaming clients, shared between the encoder and the connection
+// threads.  Connection threads are detached when the server stops and may
+// finish after it is gone, so they reach the encoder only through this, and
+// a client is unsubscribed simply by dropping its subscription.
+struct MjpegServerImpl::Subscribers {
+  wpi::mutex mutex;
+  wpi::condition_variable cond;
+  std::vector<std::weak_ptr<Subscription>> subscriptions;
+};
+
+class MjpegServerImpl::EncodeThread : public wpi::SafeThread {
+ public:
+  explicit EncodeThread(MjpegServerImpl& server)
+      : m_server(server), m_subscribers(server.m_subscribers) {}
+
+  void Main();
+
+ private:
+  void Encode(Frame& frame,
+              wpi::ArrayRef<std::shared_ptr<Subscription>> subscriptions);
+
+  MjpegServerImpl& m_server;
+  std::shared_ptr<Subscribers> m_subscribers;
+};
+
 class MjpegServerImpl::ConnThread : public wpi::SafeThread {
  public:
   explicit ConnThread(const wpi::Twine& name, wpi::Logger& logger)
@@ -90,6 +147,7 @@ class MjpegServerImpl::ConnThread : public wpi::SafeThread {
 
   std::unique_ptr<wpi::NetworkStream> m_stream;
   std::shared_ptr<SourceImpl> m_source;
+  std::shared_ptr<Subscribers> m_subscribers;
   bool m_streaming = false;
   bool m_noStreaming = false;
   int m_width = 0;
@@ -596,6 +654,8 @@ MjpegServerImpl::MjpegServerImpl(const wpi::Twine& name, wpi::Logger& logger,
     return std::make_unique<PropertyImpl>("fps", CS_PROP_INTEGER, 1, 0, 0);
   });
 
+  m_subscribers = std::make_shared<Subscribers>();
+  m_encodeThread.Start(*this);
   m_serverThread = std::thread(&MjpegServerImpl::ServerThreadMain, this);
 }
 
@@ -618,8 +678,15 @@ void MjpegServerImpl::Stop() {
     connThread.Stop();
   }
 
-  // wake up connection threads by forcing an empty frame to be sent
+  // wake up the encoder, waiting either for clients or (by forcing an empty
+  // frame to be sent) for a frame, and wait for it as it refers back to us
+  if (auto thr = m_encodeThread.GetThread()) thr->m_active = false;
+  {
+    std::lock_guard<wpi::mutex> lock(m_subscribers->mutex);
+    m_subscribers->cond.notify_all();
+  }
   if (auto source = GetSource()) source->Wakeup();
+  m_encodeThread.Join();
 }
 
 // Send HTTP response and a stream of JPG-frames
@@ -640,47 +707,38 @@ void MjpegServerImpl::ConnThread::SendStream(wpi::raw_socket_ostream& os) {
 
   SDEBUG("Headers send, sending stream now");
 
-  Frame::Time lastFrameTime = 0;
-  Frame::Time timePerFrame = 0;
-  if (m_fps != 0) timePerFrame = 1000000.0 / m_fps;
+  auto subscription = std::make_shared<Subscription>();
+  subscription->width = m_width;
+  subscription->height = m_height;
+  subscription->compression = m_compression;
+  subscription->defaultCompression = m_defaultCompression;
+  if (m_fps != 0) subscription->timePerFrame = 1000000.0 / m_fps;
   // Allow fudge factor of 1 ms in frame rate
-  if (timePerFrame >= 1000) timePerFrame -= 1000;
+  if (subscription->timePerFrame >= 1000) subscription->timePerFrame -= 1000;
 
   StartStream();
+  {
+    std::lock_guard<wpi::mutex> lock(m_subscribers->mutex);
+    m_subscribers->subscriptions.emplace_back(subscription);
+  }
+  m_subscribers->cond.notify_one();
   while (m_active && !os.has_error()) {
-    auto source = GetSource();
-    if (!source) {
-      // Source disconnected; sleep so we don't consume all processor time.
-      os << "\r\n";  // Keep connection alive
-      std::this_thread::sleep_for(std::chrono::milliseconds(200));
-      continue;
-    }
     SDEBUG4("waiting for frame");
-    Frame frame = source->GetNextFrame(0.225);  // blocks
+    std::shared_ptr<EncodedFrame> encoded;
+    {
+      std::unique_lock<wpi::mutex> lock(subscription->mutex);
+      subscription->cond.wait_for(
+          lock, std::chrono::milliseconds(225),
+          [&] { return subscription->pending != nullptr; });
+      encoded = std::move(subscription->pending);
+    }
     if (!m_active) break;
-    if (!frame) {
-      // Bad frame; sleep for 20 ms so we don't consume all processor time.
+    if (!encoded) {
+      // No frame, or the source is disconnected
       os << "\r\n";  // Keep connection alive
-      std::this_thread::sleep_for(std::chrono::milliseconds(20));
-      continue;
-    }
-
-    if (frame.GetTime() < (lastFrameTime + timePerFrame)) {
-      // Limit FPS; sleep for 10 ms so we don't consume all processor time
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      continue;
-    }
-
-    int width = m_width != 0 ? m_width : frame.GetOriginalWidth();
-    int height = m_height != 0 ? m_height : frame.GetOriginalHeight();
-    Image* image = frame.GetImageMJPEG(
-        width, height, m_compression,
-        m_compression == -1 ? m_defaultCompression : m_compression);
-    if (!image) {
-      // Shouldn't happen, but just in case...
-      std::this_thread::sleep_for(std::chrono::milliseconds(20));
       continue;
     }
+    Image* image = encoded->image;
 
     const char* data = image->data();
     size_t size = image->size();
@@ -705,8 +763,7 @@ void MjpegServerImpl::ConnThread::SendStream(wpi::raw_socket_ostream& os) {
     // print the individual mimetype and the length
     // sending the content-length fixes random stream disruption observed
     // with firefox
-    lastFrameTime = frame.GetTime();
-    double timestamp = lastFrameTime / 1000000.0;
+    double timestamp = encoded->frame.GetTime() / 1000000.0;
     header.clear();
     oss << "\r\n--" BOUNDARY "\r\n"
         << "Content-Type: image/jpeg\r\n"
@@ -725,6 +782,99 @@ void MjpegServerImpl::ConnThread::SendStream(wpi::raw_socket_ostream& os) {
     // os.flush();
   }
   StopStream();
+  std::lock_guard<wpi::mutex> lock(subscription->mutex);
+  SDEBUG("stream dropped " << subscription->dropped
+                           << " frames the client was too slow for");
+}
+
+void MjpegServerImpl::EncodeThread::Main() {
+  std::vector<std::shared_ptr<Subscription>> subscriptions;
+  while (m_active) {
+    subscriptions.clear();
+    {
+      std::unique_lock<wpi::mutex> lock(m_subscribers->mutex);
+      auto& weak = m_subscribers->subscriptions;
+      for (;;) {
+        // forget clients that have gone away
+        weak.erase(std::remove_if(weak.begin(), weak.end(),
+                                  [](const std::weak_ptr<Subscription>& w) {
+                                    return w.expired();
+                                  }),
+                   weak.end());
+        if (!m_active) return;
+        if (!weak.empty()) break;
+        m_subscribers->cond.wait(lock);
+      }
+      for (auto&& w : weak) {
+        if (auto subscription = w.lock())
+          subscriptions.emplace_back(std::move(subscription));
+      }
+    }
+
+    auto source = m_server.GetSource();
+    if (!source) {
+      // Source disconnected; sleep so we don't consume all processor time.
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    } else if (Frame frame = source->GetNextFrame(0.225)) {  // blocks
+      if (m_active) Encode(frame, subscriptions);
+    } else {
+      // Bad frame; sleep for 20 ms so we don't consume all processor time.
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+  }
+}
+
+void MjpegServerImpl::EncodeThread::Encode(
+    Frame& frame, wpi::ArrayRef<std::shared_ptr<Subscription>> subscriptions) {
+  struct Encoding {
+    int width;
+    int height;
+    int compression;
+    int defaultCompression;
+    std::shared_ptr<EncodedFrame> encoded;
+  };
+  wpi::SmallVector<Encoding, 4> encodings;
+
+  for (auto&& subscription : subscriptions) {
+    // Limit FPS
+    if (frame.GetTime() <
+        subscription->lastFrameTime + subscription->timePerFrame)
+      continue;
+
+    int width = subscription->width != 0 ? subscription->width
+                                         : frame.GetOriginalWidth();
+    int height = subscription->height != 0 ? subscription->height
+                                           : frame.GetOriginalHeight();
+
+    // Encode once for everyone asking for the same thing
+    auto it = std::find_if(
+        encodings.begin(), encodings.end(), [&](const Encoding& e) {
+          return e.width == width && e.height == height &&
+                 e.compression == subscription->compression &&
+                 e.defaultCompression == subscription->defaultCompression;
+        });
+    if (it == encodings.end()) {
+      int compression = subscription->compression;
+      Image* image = frame.GetImageMJPEG(
+          width, height, compression,
+          compression == -1 ? subscription->defaultCompression : compression,
+          &m_server);
+      encodings.push_back(Encoding{
+          width, height, compression, subscription->defaultCompression,
+          image ? std::make_shared<EncodedFrame>(frame, image) : nullptr});
+      it = std::prev(encodings.end());
+    }
+    if (!it->encoded) continue;  // Shouldn't happen, but just in case...
+
+    // Hand it over, replacing any the client hasn't gotten to
+    subscription->lastFrameTime = frame.GetTime();
+    {
+      std::lock_guard<wpi::mutex> lock(subscription->mutex);
+      if (subscription->pending) ++subscription->dropped;
+      subscription->pending = it->encoded;
+    }
+    subscription->cond.notify_one();
+  }
 }
 
 void MjpegServerImpl::ConnThread::ProcessRequest() {
@@ -907,6 +1057,7 @@ void MjpegServerImpl::ServerThreadMain() {
     auto thr = it->GetThread();
     thr->m_stream = std::move(stream);
     thr->m_source = source;
+    thr->m_subscribers = m_subscribers;
     thr->m_noStreaming = nstreams >= 10;
     thr->m_width = GetProperty(m_widthProp)->value;
     thr->m_height = GetProperty(m_heightProp)->value;
@@ -47,6 +47,10 @@ class MjpegServerImpl : public SinkImpl {
   void ServerThreadMain();
 
   class ConnThread;
+  class EncodeThread;
+  struct EncodedFrame;
+  struct Subscription;
+  struct Subscribers;
 
   // Never changed, so not protected by mutex
   std::string m_listenAddress;
@@ -58,6 +62,11 @@ class MjpegServerImpl : public SinkImpl {
 
   std::vector<wpi::SafeThreadOwner<ConnThread>> m_connThreads;
 
+  // Encodes each frame once for every distinct setting the streaming
+  // clients ask for
+  std::shared_ptr<Subscribers> m_subscribers;
+  wpi::SafeThreadOwner<EncodeThread> m_encodeThread;
+
   // property indices
   int m_widthProp;
   int m_heightProp;
@@ -7,7 +7,7 @@
 
 #include "SourceImpl.h"
 
-#include <algorithm>
+#include <array>
 #include <cstring>
 
 #include <wpi/STLExtras.h>
@@ -20,7 +20,13 @@
 
 using namespace cs;
 
-static constexpr size_t kMaxImagesAvail = 32;
+static constexpr int kMaxImagesAvail = 32;
+
+constexpr int SourceImpl::kNumPixelFormats;
+constexpr int SourceImpl::kNumCapacityClasses;
+constexpr size_t SourceImpl::kMinPooledImage;
+constexpr size_t SourceImpl::kImageSlots;
+constexpr size_t SourceImpl::kFrameSlots;
 
 SourceImpl::SourceImpl(const wpi::Twine& name, wpi::Logger& logger,
                        Notifier& notifier, Telemetry& telemetry)
@@ -36,11 +42,8 @@ SourceImpl::~SourceImpl() {
   // which is good because its destructor will call back into the class.
   Wakeup();
   // Set a flag so ReleaseFrame() doesn't re-add them to m_framesAvail.
-  // Put in a block so we destroy before the destructor ends.
-  {
-    m_destroyFrames = true;
-    auto frames = std::move(m_framesAvail);
-  }
+  m_destroyFrames = true;
+  m_framesAvail.Clear();
   // Everything else can clean up itself.
 }
 
@@ -436,30 +439,55 @@ std::vector<VideoMode> SourceImpl::EnumerateVideoModes(
   return m_videoModes;
 }
 
+// The pool a pixel format's images are kept in
+static int PoolFormat(VideoMode::PixelFormat pixelFormat) {
+  if (pixelFormat < 0 || pixelFormat > VideoMode::kGray)
+    return VideoMode::kUnknown;
+  return pixelFormat;
+}
+
+// The capacity class holding a buffer of the given capacity
+static int CapacityClass(size_t capacity, size_t minPooled, int numClasses) {
+  int c = 0;
+  while (c < numClasses - 1 && capacity >= (minPooled << (c + 1))) ++c;
+  return c;
+}
+
 std::unique_ptr<Image> SourceImpl::AllocImage(
     VideoMode::PixelFormat pixelFormat, int width, int height, size_t size) {
+  // Buffers in the size's own class may be too small, anything in the next
+  // class up is big enough.
+  auto& pools = m_imagesAvail[PoolFormat(pixelFormat)];
+  int c = CapacityClass(size, kMinPooledImage, kNumCapacityClasses);
   std::unique_ptr<Image> image;
-  {
-    std::lock_guard<wpi::mutex> lock{m_poolMutex};
-    // find the smallest existing frame that is at least big enough.
-    int found = -1;
-    for (size_t i = 0; i < m_imagesAvail.size(); ++i) {
-      // is it big enough?
-      if (m_imagesAvail[i] && m_imagesAvail[i]->capacity() >= size) {
-        // is it smaller than the last found?
-        if (found < 0 ||
-            m_imagesAvail[i]->capacity() < m_imagesAvail[found]->capacity()) {
-          // yes, update
-          found = i;
-        }
+  // Too small ones are held aside until the search is done, as giving them
+  // back right away would only have them taken again.
+  std::array<std::unique_ptr<Image>, kImageSlots> tooSmall;
+  size_t numTooSmall = 0;
+  for (int i = c; !image && i <= c + 1 && i < kNumCapacityClasses; ++i) {
+    for (;;) {
+      image = pools[i].Take();
+      if (!image) break;
+      --m_imagesPooled;
+      m_poolBytes -= image->capacity();
+      if (image->capacity() >= size) break;
+      if (numTooSmall == tooSmall.size()) {
+        // only if others gave more meanwhile; move on to the next class
+        ReleaseImage(std::move(image));
+        break;
       }
+      tooSmall[numTooSmall++] = std::move(image);
     }
+  }
+  for (size_t i = 0; i < numTooSmall; ++i)
+    ReleaseImage(std::move(tooSmall[i]));
 
+  if (image) {
+    ++m_poolHits;
+  } else {
     // if nothing found, allocate a new buffer
-    if (found < 0)
-      image.reset(new Image{size});
-    else
-      image = std::move(m_imagesAvail[found]);
+    ++m_poolMisses;
+    image.reset(new Image{size});
   }
 
   // Initialize image
@@ -489,6 +517,9 @@ void SourceImpl::PutFrame(std::unique_ptr<Image> image, Frame::Time time) {
   // Update telemetry
   m_telemetry.RecordSourceFrames(*this, 1);
   m_telemetry.RecordSourceBytes(*this, static_cast<int>(image->size()));
+  m_telemetry.RecordSourcePool(*this, m_poolHits.exchange(0),
+                               m_poolMisses.exchange(0),
+                               m_poolPeakBytes.exchange(m_poolBytes));
 
   // Update frame
   {
@@ -541,39 +572,53 @@ void SourceImpl::UpdatePropertyValue(int property, bool setString, int value,
 }
 
 void SourceImpl::ReleaseImage(std::unique_ptr<Image> image) {
-  std::lock_guard<wpi::mutex> lock{m_poolMutex};
+  // Borrowed images go back to their owner as they are destroyed
+  if (image->IsBorrowed()) return;
   if (m_destroyFrames) return;
-  // Return the frame to the pool.  First try to find an empty slot, otherwise
-  // add it to the end.
-  auto it = std::find(m_imagesAvail.begin(), m_imagesAvail.end(), nullptr);
-  if (it != m_imagesAvail.end()) {
-    *it = std::move(image);
-  } else if (m_imagesAvail.size() > kMaxImagesAvail) {
-    // Replace smallest buffer; don't need to check for null because the above
-    // find would have found it.
-    auto it2 = std::min_element(
-        m_imagesAvail.begin(), m_imagesAvail.end(),
-        [](const std::unique_ptr<Image>& a, const std::unique_ptr<Image>& b) {
-          return a->capacity() < b->capacity();
-        });
-    if ((*it2)->capacity() < image->capacity()) *it2 = std::move(image);
-  } else {
-    m_imagesAvail.emplace_back(std::move(image));
+
+  // Return the image to the pool, unless that already holds as many as we
+  // keep, or as many as we keep of its kind.  A full pool makes room by
+  // freeing a larger buffer; those are left over from a bigger resolution
+  // and would otherwise never be reused or let go.
+  size_t capacity = image->capacity();
+  int c = CapacityClass(capacity, kMinPooledImage, kNumCapacityClasses);
+  while (++m_imagesPooled > kMaxImagesAvail) {
+    --m_imagesPooled;
+    if (!EvictImageAbove(c)) return;
+  }
+  size_t bytes = m_poolBytes += capacity;
+  if (!m_imagesAvail[PoolFormat(image->pixelFormat)][c].Give(image)) {
+    --m_imagesPooled;
+    m_poolBytes -= capacity;
+    return;
+  }
+  size_t peak = m_poolPeakBytes;
+  while (bytes > peak && !m_poolPeakBytes.compare_exchange_weak(peak, bytes)) {
   }
 }
 
-std::unique_ptr<Frame::Impl> SourceImpl::AllocFrameImpl() {
-  std::lock_guard<wpi::mutex> lock{m_poolMutex};
-
-  if (m_framesAvail.empty()) return wpi::make_unique<Frame::Impl>(*this);
+// Frees the largest pooled image of a capacity class above the given one.
+// Returns false if there is none.
+bool SourceImpl::EvictImageAbove(int capacityClass) {
+  for (int c = kNumCapacityClasses - 1; c > capacityClass; --c) {
+    for (auto& pools : m_imagesAvail) {
+      auto image = pools[c].Take();
+      if (!image) continue;
+      --m_imagesPooled;
+      m_poolBytes -= image->capacity();
+      return true;
+    }
+  }
+  return false;
+}
 
-  auto impl = std::move(m_framesAvail.back());
-  m_framesAvail.pop_back();
+std::unique_ptr<Frame::Impl> SourceImpl::AllocFrameImpl() {
+  auto impl = m_framesAvail.Take();
+  if (!impl) return wpi::make_unique<Frame::Impl>(*this);
   return impl;
 }
 
 void SourceImpl::ReleaseFrameImpl(std::unique_ptr<Frame::Impl> impl) {
-  std::lock_guard<wpi::mutex> lock{m_poolMutex};
   if (m_destroyFrames) return;
-  m_framesAvail.push_back(std::move(impl));
+  m_framesAvail.Give(impl);
 }
@@ -22,6 +22,7 @@
 #include <wpi/mutex.h>
 
 #include "Frame.h"
+#include "FreeSlots.h"
 #include "Handle.h"
 #include "Image.h"
 #include "PropertyContainer.h"
@@ -169,6 +170,7 @@ class SourceImpl : public PropertyContainer {
 
  private:
   void ReleaseImage(std::unique_ptr<Image> image);
+  bool EvictImageAbove(int capacityClass);
   std::unique_ptr<Frame::Impl> AllocFrameImpl();
   void ReleaseFrameImpl(std::unique_ptr<Frame::Impl> data);
 
@@ -181,19 +183,38 @@ class SourceImpl : public PropertyContainer {
   wpi::mutex m_frameMutex;
   wpi::condition_variable m_frameCv;
 
-  bool m_destroyFrames{false};
-
-  // Pool of frames/images to reduce malloc traffic.
-  wpi::mutex m_poolMutex;
-  std::vector<std::unique_ptr<Frame::Impl>> m_framesAvail;
-  std::vector<std::unique_ptr<Image>> m_imagesAvail;
+  std::atomic_bool m_destroyFrames{false};
+
+  // Pools of frames/images to reduce malloc traffic, taken from and returned
+  // to without locking.  Images are kept by pixel format and by capacity
+  // class, class c holding capacities from kMinPooledImage << c up to twice
+  // that (the last class holds everything larger).
+  static constexpr int kNumPixelFormats = VideoMode::kGray + 1;
+  static constexpr int kNumCapacityClasses = 16;
+  static constexpr size_t kMinPooledImage = 1024;
+  static constexpr size_t kImageSlots = 4;
+  static constexpr size_t kFrameSlots = 16;
+  FreeSlots<Frame::Impl, kFrameSlots> m_framesAvail;
+  FreeSlots<Image, kImageSlots> m_imagesAvail[kNumPixelFormats]
+                                             [kNumCapacityClasses];
+  std::atomic_int m_imagesPooled{0};
+
+  // Pool statistics, reported to telemetry with each frame
+  std::atomic_int m_poolHits{0};
+  std::atomic_int m_poolMisses{0};
+  std::atomic<size_t> m_poolBytes{0};
+  std::atomic<size_t> m_poolPeakBytes{0};
+
+  // Set once the JPEG decoder has ignored a request to decode at a fraction
+  // of full size, so later frames don't plan on it
+  std::atomic_bool m_scaledDecodeFailed{false};
 
   std::atomic_bool m_connected{false};
 
   // Most recent frame (returned to callers of GetNextFrame)
   // Access protected by m_frameMutex.
-  // MUST be located below m_poolMutex as the Frame destructor calls back
-  // into SourceImpl::ReleaseImage, which locks m_poolMutex.
+  // MUST be located below the pools as the Frame destructor calls back
+  // into SourceImpl::ReleaseImage, which returns images to them.
   Frame m_frame;
 };
 
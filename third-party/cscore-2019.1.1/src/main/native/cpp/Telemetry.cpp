@@ -7,6 +7,7 @@
 
 #include "Telemetry.h"
 
+#include <algorithm>
 #include <chrono>
 #include <limits>
 
@@ -16,6 +17,7 @@
 #include "Handle.h"
 #include "Instance.h"
 #include "Notifier.h"
+#include "SinkImpl.h"
 #include "SourceImpl.h"
 #include "cscore_cpp.h"
 
@@ -134,3 +136,34 @@ void Telemetry::RecordSourceFrames(const SourceImpl& source, int quantity) {
                                 static_cast<int>(CS_SOURCE_FRAMES_RECEIVED))] +=
       quantity;
 }
+
+void Telemetry::RecordSourcePool(const SourceImpl& source, int hits,
+                                 int misses, size_t peakBytes) {
+  auto thr = m_owner.GetThread();
+  if (!thr) return;
+  auto handleData = Instance::GetInstance().FindSource(source);
+  Handle handle{handleData.first, Handle::kSource};
+  thr->m_current[std::make_pair(handle,
+                                static_cast<int>(CS_SOURCE_POOL_HITS))] +=
+      hits;
+  thr->m_current[std::make_pair(handle,
+                                static_cast<int>(CS_SOURCE_POOL_MISSES))] +=
+      misses;
+  // a peak rather than a total over the period
+  auto& peak = thr->m_current[std::make_pair(
+      handle, static_cast<int>(CS_SOURCE_POOL_PEAK_BYTES))];
+  peak = std::max(peak, static_cast<int64_t>(peakBytes));
+}
+
+void Telemetry::RecordConversion(const SourceImpl& source, const SinkImpl* sink,
+                                 CS_TelemetryKind kind) {
+  auto thr = m_owner.GetThread();
+  if (!thr) return;
+  auto sourceData = Instance::GetInstance().FindSource(source);
+  ++thr->m_current[std::make_pair(Handle{sourceData.first, Handle::kSource},
+                                  static_cast<int>(kind))];
+  if (!sink) return;
+  auto sinkData = Instance::GetInstance().FindSink(*sink);
+  ++thr->m_current[std::make_pair(Handle{sinkData.first, Handle::kSink},
+                                  static_cast<int>(kind))];
+}
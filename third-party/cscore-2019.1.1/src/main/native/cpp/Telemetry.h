@@ -15,6 +15,7 @@
 namespace cs {
 
 class Notifier;
+class SinkImpl;
 class SourceImpl;
 
 class Telemetry {
@@ -37,6 +38,10 @@ class Telemetry {
   // Telemetry events
   void RecordSourceBytes(const SourceImpl& source, int quantity);
   void RecordSourceFrames(const SourceImpl& source, int quantity);
+  void RecordSourcePool(const SourceImpl& source, int hits, int misses,
+                        size_t peakBytes);
+  void RecordConversion(const SourceImpl& source, const SinkImpl* sink,
+                        CS_TelemetryKind kind);
 
  private:
   Notifier& m_notifier;
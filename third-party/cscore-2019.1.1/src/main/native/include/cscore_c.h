@@ -176,7 +176,30 @@ enum CS_EventKind {
  */
 enum CS_TelemetryKind {
   CS_SOURCE_BYTES_RECEIVED = 1,
-  CS_SOURCE_FRAMES_RECEIVED = 2
+  CS_SOURCE_FRAMES_RECEIVED = 2,
+  /**
+   * Image conversions done on frames, counted against both the source and
+   * the sink that asked for them
+   */
+  CS_CONVERT_MJPEG_TO_BGR = 3,
+  CS_CONVERT_MJPEG_TO_GRAY = 4,
+  CS_CONVERT_YUYV_TO_BGR = 5,
+  CS_CONVERT_YUYV_TO_GRAY = 6,
+  CS_CONVERT_RGB565_TO_BGR = 7,
+  CS_CONVERT_BGR_TO_RGB565 = 8,
+  CS_CONVERT_BGR_TO_GRAY = 9,
+  CS_CONVERT_GRAY_TO_BGR = 10,
+  CS_CONVERT_BGR_TO_MJPEG = 11,
+  CS_CONVERT_GRAY_TO_MJPEG = 12,
+  CS_CONVERT_RESIZE = 13,
+  /**
+   * Source image buffers reused from its pool, and newly allocated because
+   * the pool had none to fit
+   */
+  CS_SOURCE_POOL_HITS = 14,
+  CS_SOURCE_POOL_MISSES = 15,
+  /** Most memory held in a source's image pool at once */
+  CS_SOURCE_POOL_PEAK_BYTES = 16
 };
 
 /** Connection strategy */
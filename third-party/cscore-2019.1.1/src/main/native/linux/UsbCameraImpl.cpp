@@ -13,16 +13,19 @@
 #include <linux/kernel.h>
 #include <linux/types.h>
 #include <linux/videodev2.h>
+#include <sys/epoll.h>
 #include <sys/eventfd.h>
 #include <sys/inotify.h>
 #include <sys/ioctl.h>
-#include <sys/select.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <chrono>
+#include <thread>
 
 #include <wpi/FileSystem.h>
 #include <wpi/Path.h>
@@ -49,6 +52,8 @@ static constexpr char const* kPropExValue = "exposure_absolute";
 static constexpr char const* kPropBrValue = "brightness";
 static constexpr char const* kPropConnectVerbose = "connect_verbose";
 static constexpr unsigned kPropConnectVerboseId = 0;
+static constexpr char const* kPropZeroCopy = "zero_copy";
+static constexpr unsigned kPropZeroCopyId = 1;
 
 // Conversions v4l2_fract time per frame from/to frames per second (fps)
 static inline int FractToFPS(const struct v4l2_fract& timeperframe) {
@@ -219,7 +224,9 @@ UsbCameraImpl::UsbCameraImpl(const wpi::Twine& name, wpi::Logger& logger,
       m_path{path.str()},
       m_fd{-1},
       m_command_fd{eventfd(0, 0)},
+      m_returns{std::make_shared<UsbCameraReturns>()},
       m_active{true} {
+  m_returns->wakeFd = m_command_fd;
   SetDescription(GetDescriptionImpl(m_path.c_str()));
   SetQuirks();
 
@@ -228,6 +235,10 @@ UsbCameraImpl::UsbCameraImpl(const wpi::Twine& name, wpi::Logger& logger,
                                                kPropConnectVerboseId,
                                                CS_PROP_INTEGER, 0, 1, 1, 1, 1);
   });
+  CreateProperty(kPropZeroCopy, [] {
+    return std::make_unique<UsbCameraProperty>(
+        kPropZeroCopy, kPropZeroCopyId, CS_PROP_BOOLEAN, 0, 1, 1, 0, 0);
+  });
 }
 
 UsbCameraImpl::~UsbCameraImpl() {
@@ -236,23 +247,47 @@ UsbCameraImpl::~UsbCameraImpl() {
   // Just in case anyone is waiting...
   m_responseCv.notify_all();
 
-  // Send message to wake up thread; select timeout will wake us up anyway,
+  // Send message to wake up thread; wait timeout will wake us up anyway,
   // but this speeds shutdown.
   Send(Message{Message::kNone});
 
   // join camera thread
   if (m_cameraThread.joinable()) m_cameraThread.join();
 
+  // Frames still holding buffers must not signal the fd once it is closed
+  {
+    std::lock_guard<wpi::mutex> lock(m_returns->mutex);
+    m_returns->wakeFd = -1;
+  }
+
   // close command fd
   int fd = m_command_fd.exchange(-1);
   if (fd >= 0) close(fd);
 }
 
-static inline void DoFdSet(int fd, fd_set* set, int* nfds) {
-  if (fd >= 0) {
-    FD_SET(fd, set);
-    if ((fd + 1) > *nfds) *nfds = fd + 1;
-  }
+// Frames older than this by their driver timestamp are assumed to have a bad
+// one, and are stamped with the time they were dequeued instead
+static constexpr int64_t kMaxFrameAge = 1000000;  // us
+
+// The wpi clock time the driver captured the frame in buf.  The driver's clock
+// may not be the one wpi::Now() uses, so this goes by how long ago the
+// capture was on the driver's clock.
+static Frame::Time GetFrameTime(const struct v4l2_buffer& buf) {
+  Frame::Time now = wpi::Now();
+#ifdef V4L2_BUF_FLAG_TIMESTAMP_MASK
+  if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) !=
+      V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC)
+    return now;
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) return now;
+  int64_t age =
+      (static_cast<int64_t>(ts.tv_sec) - buf.timestamp.tv_sec) * 1000000 +
+      (ts.tv_nsec / 1000 - buf.timestamp.tv_usec);
+  if (age < 0 || age > kMaxFrameAge) return now;
+  return now - age;
+#else
+  return now;
+#endif
 }
 
 void UsbCameraImpl::Start() {
@@ -285,6 +320,23 @@ void UsbCameraImpl::CameraThreadMain() {
   pathCopy.push_back('\0');
   wpi::SmallString<64> base{basename(pathCopy.data())};
 
+  // Wait on the command and notify fds throughout; DeviceStreamOn() adds the
+  // device while it is streaming
+  m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (m_epoll_fd < 0) {
+    SERROR("epoll_create1(): " << std::strerror(errno));
+    return;
+  }
+  for (int waitFd : {m_command_fd.load(), notify_fd}) {
+    if (waitFd < 0) continue;
+    struct epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = waitFd;
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, waitFd, &event) < 0)
+      SERROR("epoll_ctl(): " << std::strerror(errno));
+  }
+
   // Used to restart streaming on reconnect
   bool wasStreaming = false;
 
@@ -316,34 +368,33 @@ void UsbCameraImpl::CameraThreadMain() {
       DeviceStreamOn();
     }
 
-    // The select timeout can be long unless we're trying to reconnect
-    struct timeval tv;
-    if (fd < 0 && notified) {
-      tv.tv_sec = 0;
-      tv.tv_usec = 300000;
-    } else {
-      tv.tv_sec = 2;
-      tv.tv_usec = 0;
-    }
-
-    // select on applicable read descriptors
-    int nfds = 0;
-    fd_set readfds;
-    FD_ZERO(&readfds);
-    DoFdSet(command_fd, &readfds, &nfds);
-    if (m_streaming) DoFdSet(fd, &readfds, &nfds);
-    DoFdSet(notify_fd, &readfds, &nfds);
+    // The wait timeout can be long unless we're trying to reconnect
+    int timeout = (fd < 0 && notified) ? 300 : 2000;  // ms
 
-    if (select(nfds, &readfds, nullptr, nullptr, &tv) < 0) {
-      SERROR("select(): " << std::strerror(errno));
+    struct epoll_event events[3];
+    int nevents = epoll_wait(m_epoll_fd, events, 3, timeout);
+    if (nevents < 0) {
+      if (errno == EINTR) continue;
+      SERROR("epoll_wait(): " << std::strerror(errno));
       break;  // XXX: is this the right thing to do here?
     }
+    bool notifyReady = false;
+    bool commandReady = false;
+    bool frameReady = false;
+    for (int i = 0; i < nevents; ++i) {
+      if (events[i].data.fd == notify_fd)
+        notifyReady = true;
+      else if (events[i].data.fd == command_fd)
+        commandReady = true;
+      else if (events[i].data.fd == fd)
+        frameReady = true;
+    }
 
     // Double-check to see if we're shutting down
     if (!m_active) break;
 
     // Handle notify events
-    if (notify_fd >= 0 && FD_ISSET(notify_fd, &readfds)) {
+    if (notify_fd >= 0 && notifyReady) {
       SDEBUG4("notify event");
       struct inotify_event event;
       do {
@@ -373,17 +424,18 @@ void UsbCameraImpl::CameraThreadMain() {
     }
 
     // Handle commands
-    if (command_fd >= 0 && FD_ISSET(command_fd, &readfds)) {
+    if (command_fd >= 0 && commandReady) {
       SDEBUG4("got command");
       // Read it to clear
       eventfd_t val;
       eventfd_read(command_fd, &val);
+      DeviceRequeueBuffers();
       DeviceProcessCommands();
       continue;
     }
 
     // Handle frames
-    if (m_streaming && fd >= 0 && FD_ISSET(fd, &readfds)) {
+    if (m_streaming && fd >= 0 && frameReady) {
       SDEBUG4("grabbing image");
 
       // Dequeue buffer
@@ -403,13 +455,14 @@ void UsbCameraImpl::CameraThreadMain() {
       if ((buf.flags & V4L2_BUF_FLAG_ERROR) == 0) {
         SDEBUG4("got image size=" << buf.bytesused << " index=" << buf.index);
 
-        if (buf.index >= kNumBuffers || !m_buffers[buf.index].m_data) {
+        if (buf.index >= static_cast<unsigned>(m_numBuffers) ||
+            !m_buffers[buf.index]) {
           SWARNING("invalid buffer" << buf.index);
           continue;
         }
 
         wpi::StringRef image{
-            static_cast<const char*>(m_buffers[buf.index].m_data),
+            static_cast<const char*>(m_buffers[buf.index]->m_data),
             static_cast<size_t>(buf.bytesused)};
         int width = m_mode.width;
         int height = m_mode.height;
@@ -419,9 +472,20 @@ void UsbCameraImpl::CameraThreadMain() {
           SWARNING("invalid JPEG image received from camera");
           good = false;
         }
+        // Lend only while enough stay queued for the driver to keep
+        // capturing; past that, copy so this buffer goes straight back
+        int queued = m_numBuffers - 1 -
+                     static_cast<int>(std::count(m_lent.begin(),
+                                                 m_lent.end(), true));
+        if (good && m_zeroCopy && queued >= kMinQueuedBuffers) {
+          // Requeued by DeviceRequeueBuffers() once the frame is released
+          PutFrame(DeviceLendBuffer(buf.index, image.size(), width, height),
+                   GetFrameTime(buf));
+          continue;
+        }
         if (good) {
           PutFrame(static_cast<VideoMode::PixelFormat>(m_mode.pixelFormat),
-                   width, height, image, wpi::Now());  // TODO: time
+                   width, height, image, GetFrameTime(buf));
         }
       }
 
@@ -440,15 +504,33 @@ void UsbCameraImpl::CameraThreadMain() {
   // close camera connection
   DeviceStreamOff();
   DeviceDisconnect();
+
+  close(m_epoll_fd);
+  m_epoll_fd = -1;
 }
 
 void UsbCameraImpl::DeviceDisconnect() {
   int fd = m_fd.exchange(-1);
   if (fd < 0) return;  // already disconnected
 
+  // Mappings keep the device file open past close(), so it has to be taken
+  // out of the wait set explicitly.  The stream goes with the fd, even if
+  // turning it off failed.
+  epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+  m_streaming = false;
+
+  // Buffers lent to frames now belong to a mapping that is going away; they
+  // are unmapped when the last frame is released rather than requeued
+  {
+    std::lock_guard<wpi::mutex> lock(m_returns->mutex);
+    ++m_returns->generation;
+    m_returns->indices.clear();
+  }
+  m_lent.fill(false);
+
   // Unmap buffers
-  for (int i = 0; i < kNumBuffers; ++i)
-    m_buffers[i] = std::move(UsbCameraBuffer{});
+  for (auto& buffer : m_buffers) buffer.reset();
+  m_numBuffers = 0;
 
   // Close device
   close(fd);
@@ -457,6 +539,15 @@ void UsbCameraImpl::DeviceDisconnect() {
   SetConnected(false);
 }
 
+void UsbCameraImpl::DeviceReconnect() {
+  bool lent = std::find(m_lent.begin(), m_lent.end(), true) != m_lent.end();
+  DeviceDisconnect();
+  // The driver won't allocate new buffers while frames still map old ones,
+  // so replace the current frame and wake the sinks to get them let go of
+  if (lent) PutError("camera reconnecting", wpi::Now());
+  DeviceConnect();
+}
+
 void UsbCameraImpl::DeviceConnect() {
   if (m_fd >= 0) return;
 
@@ -507,19 +598,30 @@ void UsbCameraImpl::DeviceConnect() {
   SDEBUG3("allocating buffers");
   struct v4l2_requestbuffers rb;
   std::memset(&rb, 0, sizeof(rb));
-  rb.count = kNumBuffers;
   rb.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
   rb.memory = V4L2_MEMORY_MMAP;
-  if (DoIoctl(fd, VIDIOC_REQBUFS, &rb) != 0) {
+  // Buffers lent out on a previous connection are busy until the frames
+  // holding them are released, which may take a moment
+  int rc;
+  for (int tries = 0;; ++tries) {
+    rb.count = m_zeroCopy ? kNumZeroCopyBuffers : kNumBuffers;
+    rc = TryIoctl(fd, VIDIOC_REQBUFS, &rb);
+    if (rc == 0 || errno != EBUSY || tries >= kReqBufsTries) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  if (rc != 0 || rb.count == 0) {
+    if (rc != 0) SWARNING("VIDIOC_REQBUFS: " << std::strerror(errno));
     SWARNING("could not allocate buffers");
     close(fd);
     m_fd = -1;
     return;
   }
+  // The driver may give us a different number than we asked for
+  m_numBuffers = std::min(static_cast<int>(rb.count), kNumZeroCopyBuffers);
 
   // Map buffers
   SDEBUG3("mapping buffers");
-  for (int i = 0; i < kNumBuffers; ++i) {
+  for (int i = 0; i < m_numBuffers; ++i) {
     struct v4l2_buffer buf;
     std::memset(&buf, 0, sizeof(buf));
     buf.index = i;
@@ -534,17 +636,19 @@ void UsbCameraImpl::DeviceConnect() {
     SDEBUG4("buf " << i << " length=" << buf.length
                    << " offset=" << buf.m.offset);
 
-    m_buffers[i] = std::move(UsbCameraBuffer(fd, buf.length, buf.m.offset));
-    if (!m_buffers[i].m_data) {
+    m_buffers[i] =
+        std::make_shared<UsbCameraBuffer>(fd, buf.length, buf.m.offset);
+    if (!m_buffers[i]->m_data) {
       SWARNING("could not map buffer " << i);
       // release other buffers
-      for (int j = 0; j < i; ++j) m_buffers[j] = std::move(UsbCameraBuffer{});
+      for (int j = 0; j <= i; ++j) m_buffers[j].reset();
+      m_numBuffers = 0;
       close(fd);
       m_fd = -1;
       return;
     }
 
-    SDEBUG4("buf " << i << " address=" << m_buffers[i].m_data);
+    SDEBUG4("buf " << i << " address=" << m_buffers[i]->m_data);
   }
 
   // Update description (as it may have changed)
@@ -562,9 +666,10 @@ bool UsbCameraImpl::DeviceStreamOn() {
   int fd = m_fd.load();
   if (fd < 0) return false;
 
-  // Queue buffers
+  // Queue buffers, other than those frames are still using
   SDEBUG3("queuing buffers");
-  for (int i = 0; i < kNumBuffers; ++i) {
+  for (int i = 0; i < m_numBuffers; ++i) {
+    if (m_lent[i]) continue;
     struct v4l2_buffer buf;
     std::memset(&buf, 0, sizeof(buf));
     buf.index = i;
@@ -593,9 +698,61 @@ bool UsbCameraImpl::DeviceStreamOn() {
   }
   SDEBUG4("enabled streaming");
   m_streaming = true;
+
+  // Wake the camera thread as frames arrive
+  struct epoll_event event;
+  std::memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.fd = fd;
+  if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0 && errno != EEXIST)
+    SERROR("epoll_ctl(): " << std::strerror(errno));
   return true;
 }
 
+std::unique_ptr<Image> UsbCameraImpl::DeviceLendBuffer(int index, size_t size,
+                                                       int width, int height) {
+  m_lent[index] = true;
+  // The image keeps the mapping alive even if the camera disconnects first
+  auto buffer = m_buffers[index];
+  auto returns = m_returns;
+  int generation = m_returns->generation;
+  auto image = wpi::make_unique<Image>(
+      static_cast<char*>(buffer->m_data), size,
+      [buffer, returns, generation, index] {
+        std::lock_guard<wpi::mutex> lock(returns->mutex);
+        if (returns->generation != generation || returns->wakeFd < 0) return;
+        returns->indices.push_back(index);
+        eventfd_write(returns->wakeFd, 1);
+      });
+  image->pixelFormat = static_cast<VideoMode::PixelFormat>(m_mode.pixelFormat);
+  image->width = width;
+  image->height = height;
+  return image;
+}
+
+void UsbCameraImpl::DeviceRequeueBuffers() {
+  wpi::SmallVector<int, kNumZeroCopyBuffers> indices;
+  {
+    std::lock_guard<wpi::mutex> lock(m_returns->mutex);
+    indices.append(m_returns->indices.begin(), m_returns->indices.end());
+    m_returns->indices.clear();
+  }
+
+  int fd = m_fd.load();
+  for (int i : indices) {
+    m_lent[i] = false;
+    // If not streaming, DeviceStreamOn() will queue it
+    if (!m_streaming || fd < 0) continue;
+    struct v4l2_buffer buf;
+    std::memset(&buf, 0, sizeof(buf));
+    buf.index = i;
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if (DoIoctl(fd, VIDIOC_QBUF, &buf) != 0)
+      SWARNING("could not requeue buffer " << i);
+  }
+}
+
 bool UsbCameraImpl::DeviceStreamOff() {
   if (!m_streaming) return false;  // ignore if already disabled
   int fd = m_fd.load();
@@ -604,6 +761,7 @@ bool UsbCameraImpl::DeviceStreamOff() {
   if (DoIoctl(fd, VIDIOC_STREAMOFF, &type) != 0) return false;
   SDEBUG4("disabled streaming");
   m_streaming = false;
+  epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
   return true;
 }
 
@@ -641,10 +799,7 @@ CS_StatusValue UsbCameraImpl::DeviceCmdSetMode(
     lock.unlock();
     bool wasStreaming = m_streaming;
     if (wasStreaming) DeviceStreamOff();
-    if (m_fd >= 0) {
-      DeviceDisconnect();
-      DeviceConnect();
-    }
+    if (m_fd >= 0) DeviceReconnect();
     if (wasStreaming) DeviceStreamOn();
     m_notifier.NotifySourceVideoMode(*this, newMode);
     lock.lock();
@@ -703,7 +858,18 @@ CS_StatusValue UsbCameraImpl::DeviceCmdSetProperty(
 
   // Actually set the new value on the device (if possible)
   if (!prop->device) {
-    if (prop->id == kPropConnectVerboseId) m_connectVerbose = value;
+    if (prop->id == kPropConnectVerboseId) {
+      m_connectVerbose = value;
+    } else if (prop->id == kPropZeroCopyId && (value != 0) != m_zeroCopy) {
+      // Takes a different number of buffers, so reconnect
+      m_zeroCopy = value != 0;
+      lock.unlock();
+      bool wasStreaming = m_streaming;
+      if (wasStreaming) DeviceStreamOff();
+      if (m_fd >= 0) DeviceReconnect();
+      if (wasStreaming) DeviceStreamOn();
+      lock.lock();
+    }
   } else {
     if (!prop->DeviceSet(lock, m_fd, value, valueStr))
       return CS_PROPERTY_WRITE_FAILED;
@@ -10,6 +10,7 @@
 
 #include <linux/videodev2.h>
 
+#include <array>
 #include <atomic>
 #include <memory>
 #include <string>
@@ -34,6 +35,15 @@ namespace cs {
 class Notifier;
 class Telemetry;
 
+// Buffers given back by frames in zero-copy mode.  Frames can be released on
+// any thread and can outlive the camera, so this is shared with them.
+struct UsbCameraReturns {
+  wpi::mutex mutex;
+  std::vector<int> indices;  // to be requeued by the camera thread
+  int generation{0};         // bumped whenever the buffers are unmapped
+  int wakeFd{-1};            // command eventfd, -1 once the camera is gone
+};
+
 class UsbCameraImpl : public SourceImpl {
  public:
   UsbCameraImpl(const wpi::Twine& name, wpi::Logger& logger, Notifier& notifier,
@@ -115,6 +125,7 @@ class UsbCameraImpl : public SourceImpl {
   // Functions used by CameraThreadMain()
   void DeviceDisconnect();
   void DeviceConnect();
+  void DeviceReconnect();
   bool DeviceStreamOn();
   bool DeviceStreamOff();
   void DeviceProcessCommands();
@@ -124,6 +135,9 @@ class UsbCameraImpl : public SourceImpl {
   void DeviceCacheProperty(std::unique_ptr<UsbCameraProperty> rawProp);
   void DeviceCacheProperties();
   void DeviceCacheVideoModes();
+  std::unique_ptr<Image> DeviceLendBuffer(int index, size_t size, int width,
+                                          int height);
+  void DeviceRequeueBuffers();
 
   // Command helper functions
   CS_StatusValue DeviceProcessCommand(std::unique_lock<wpi::mutex>& lock,
@@ -147,10 +161,22 @@ class UsbCameraImpl : public SourceImpl {
   bool m_modeSetResolution{false};
   bool m_modeSetFPS{false};
   int m_connectVerbose{1};
+  int m_epoll_fd{-1};
   unsigned m_capabilities = 0;
   // Number of buffers to ask OS for
   static constexpr int kNumBuffers = 4;
-  std::array<UsbCameraBuffer, kNumBuffers> m_buffers;
+  // In zero-copy mode frames hold on to buffers while they are in use, so
+  // more are needed to keep the driver supplied
+  static constexpr int kNumZeroCopyBuffers = 8;
+  // Buffers kept queued to the driver rather than lent to frames
+  static constexpr int kMinQueuedBuffers = 2;
+  // Times to retry allocating buffers still held by frames (50 ms apart)
+  static constexpr int kReqBufsTries = 20;
+  std::array<std::shared_ptr<UsbCameraBuffer>, kNumZeroCopyBuffers> m_buffers;
+  int m_numBuffers{0};
+  bool m_zeroCopy{false};
+  // Buffers referenced by frames rather than queued to the driver
+  std::array<bool, kNumZeroCopyBuffers> m_lent{};
 
   //
   // Path never changes, so not protected by mutex.
@@ -159,6 +185,7 @@ class UsbCameraImpl : public SourceImpl {
 
   std::atomic_int m_fd;
   std::atomic_int m_command_fd;  // for command eventfd
+  std::shared_ptr<UsbCameraReturns> m_returns;
 
   std::atomic_bool m_active;  // set to false to terminate thread
   std::thread m_cameraThread;
@@ -0,0 +1,158 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "ColorConvert.h"
+#include "gtest/gtest.h"
+
+namespace cs {
+
+// Written out the way OpenCV's scalar cvtColor code does it, to check the
+// vector kernels against.
+static uint8_t Sat(int v) { return std::min(255, std::max(0, v)); }
+
+static void RefYUYVToBGR(const uint8_t* src, uint8_t* dst, size_t pixels) {
+  for (size_t i = 0; i < pixels / 2; ++i) {
+    const uint8_t* p = src + 4 * i;
+    uint8_t* row = dst + 6 * i;
+    int u = int(p[1]) - 128;
+    int v = int(p[3]) - 128;
+    int ruv = (1 << 19) + 1673527 * v;
+    int guv = (1 << 19) - 852492 * v - 409993 * u;
+    int buv = (1 << 19) + 2116026 * u;
+    for (int k = 0; k < 2; ++k) {
+      int y = std::max(0, int(p[2 * k]) - 16) * 1220542;
+      row[3 * k + 2] = Sat((y + ruv) >> 20);
+      row[3 * k + 1] = Sat((y + guv) >> 20);
+      row[3 * k + 0] = Sat((y + buv) >> 20);
+    }
+  }
+}
+
+static void RefBGRToGray(const uint8_t* src, uint8_t* dst, size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i) {
+    const uint8_t* p = src + 3 * i;
+    dst[i] = (p[0] * 1868 + p[1] * 9617 + p[2] * 4899 + (1 << 13)) >> 14;
+  }
+}
+
+static void RefBGRToRGB565(const uint8_t* src, uint8_t* dst, size_t pixels) {
+  uint16_t* d = reinterpret_cast<uint16_t*>(dst);
+  for (size_t i = 0; i < pixels; ++i) {
+    // COLOR_RGB2BGR565: blue index 2, so "blue" is the third byte
+    int b = src[3 * i + 2], g = src[3 * i + 1], r = src[3 * i];
+    d[i] = (b >> 3) | ((g << 3) & ~31) | ((r << 8) & 0xf800);
+  }
+}
+
+static void RefRGB565ToBGR(const uint8_t* src, uint8_t* dst, size_t pixels) {
+  const uint16_t* s = reinterpret_cast<const uint16_t*>(src);
+  for (size_t i = 0; i < pixels; ++i) {
+    unsigned t = s[i];
+    dst[3 * i + 2] = uint8_t(t << 3);
+    dst[3 * i + 1] = (t >> 3) & ~3;
+    dst[3 * i] = (t >> 8) & ~7;
+  }
+}
+
+static std::vector<uint8_t> Random(size_t size, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> dist(0, 255);
+  std::vector<uint8_t> v(size);
+  for (auto& x : v) x = dist(gen);
+  // the extremes, where saturation happens
+  for (size_t i = 0; i < size && i < 8; ++i) v[i] = (i & 1) ? 255 : 0;
+  return v;
+}
+
+// Sizes around the vector widths, and a camera frame
+static const size_t kSizes[] = {0,  2,  6,  14, 16, 18,
+                                 30, 32, 34, 62, 66, 640 * 480};
+
+typedef void (*Kernel)(const uint8_t*, uint8_t*, size_t);
+
+static void ExpectSame(Kernel kernel, Kernel ref, size_t srcBytes,
+                       size_t dstBytes) {
+  for (size_t pixels : kSizes) {
+    auto src = Random(pixels * srcBytes, pixels);
+    // poisoned past the end to catch overruns
+    std::vector<uint8_t> got(pixels * dstBytes + 64, 0xa5);
+    std::vector<uint8_t> want(pixels * dstBytes + 64, 0xa5);
+    kernel(src.data(), got.data(), pixels);
+    ref(src.data(), want.data(), pixels);
+    ASSERT_EQ(want, got) << pixels << " pixels";
+  }
+}
+
+TEST(ColorConvertTest, YUYVToBGR) {
+  ExpectSame(ConvertYUYVToBGRPixels, RefYUYVToBGR, 2, 3);
+}
+
+TEST(ColorConvertTest, BGRToGray) {
+  ExpectSame(ConvertBGRToGrayPixels, RefBGRToGray, 3, 1);
+}
+
+TEST(ColorConvertTest, BGRToRGB565) {
+  ExpectSame(ConvertBGRToRGB565Pixels, RefBGRToRGB565, 3, 2);
+}
+
+TEST(ColorConvertTest, RGB565ToBGR) {
+  ExpectSame(ConvertRGB565ToBGRPixels, RefRGB565ToBGR, 2, 3);
+}
+
+TEST(ColorConvertTest, GrayToBGR) {
+  ExpectSame(ConvertGrayToBGRPixels,
+             [](const uint8_t* src, uint8_t* dst, size_t pixels) {
+               for (size_t i = 0; i < pixels; ++i)
+                 dst[3 * i] = dst[3 * i + 1] = dst[3 * i + 2] = src[i];
+             },
+             1, 3);
+}
+
+// Direct from YUYV is the luma alone, which for colorless pixels is exactly
+// what going through BGR gives
+TEST(ColorConvertTest, YUYVToGrayMatchesBGRWhenColorless) {
+  std::vector<uint8_t> yuyv(256 * 2);
+  for (int y = 0; y < 256; ++y) {
+    yuyv[2 * y] = y;
+    yuyv[2 * y + 1] = 128;
+  }
+  std::vector<uint8_t> bgr(256 * 3), viaBGR(256), direct(256);
+  RefYUYVToBGR(yuyv.data(), bgr.data(), 256);
+  RefBGRToGray(bgr.data(), viaBGR.data(), 256);
+  ConvertYUYVToGrayPixels(yuyv.data(), direct.data(), 256);
+  ASSERT_EQ(viaBGR, direct);
+}
+
+TEST(ColorConvertTest, YUYVToGrayIgnoresChroma) {
+  for (size_t pixels : kSizes) {
+    auto yuyv = Random(pixels * 2, pixels);
+    auto flat = yuyv;
+    for (size_t i = 1; i < flat.size(); i += 2) flat[i] = 128;
+    std::vector<uint8_t> got(pixels + 64, 0xa5), want(pixels + 64, 0xa5);
+    ConvertYUYVToGrayPixels(yuyv.data(), got.data(), pixels);
+    ConvertYUYVToGrayPixels(flat.data(), want.data(), pixels);
+    ASSERT_EQ(want, got) << pixels << " pixels";
+  }
+}
+
+TEST(ColorConvertTest, RGB565RoundTrip) {
+  auto bgr = Random(640 * 480 * 3, 1);
+  std::vector<uint8_t> rgb565(640 * 480 * 2), back(640 * 480 * 3);
+  ConvertBGRToRGB565Pixels(bgr.data(), rgb565.data(), 640 * 480);
+  ConvertRGB565ToBGRPixels(rgb565.data(), back.data(), 640 * 480);
+  for (size_t i = 0; i < bgr.size(); i += 3) {
+    ASSERT_EQ(bgr[i] & 0xf8, back[i]);
+    ASSERT_EQ(bgr[i + 1] & 0xfc, back[i + 1]);
+    ASSERT_EQ(bgr[i + 2] & 0xf8, back[i + 2]);
+  }
+}
+
+}  // namespace cs
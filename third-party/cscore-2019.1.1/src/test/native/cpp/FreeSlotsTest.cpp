@@ -0,0 +1,72 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2018 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "FreeSlots.h"
+#include "gtest/gtest.h"
+
+namespace cs {
+
+namespace {
+struct Counted {
+  explicit Counted(std::atomic_int& live_) : live(live_) { ++live; }
+  ~Counted() { --live; }
+  std::atomic_int& live;
+  int owner = -1;
+};
+}  // namespace
+
+TEST(FreeSlotsTest, HoldsUpToCapacity) {
+  std::atomic_int live{0};
+  {
+    FreeSlots<Counted, 2> slots;
+    EXPECT_EQ(nullptr, slots.Take());
+    for (int i = 0; i < 3; ++i) {
+      auto obj = std::make_unique<Counted>(live);
+      bool given = slots.Give(obj);
+      EXPECT_EQ(i < 2, given);
+      EXPECT_EQ(!given, obj != nullptr);
+    }
+    EXPECT_EQ(2, live);  // the third was handed back and freed
+    EXPECT_NE(nullptr, slots.Take());
+    EXPECT_EQ(1, live);
+  }
+  EXPECT_EQ(0, live);  // the rest freed with the slots
+}
+
+// Threads pass objects through the slots, each marking what it holds; an
+// object handed to two threads at once would be seen with another's mark.
+TEST(FreeSlotsTest, NeverSharesAnObject) {
+  std::atomic_int live{0};
+  std::atomic_bool shared{false};
+  {
+    FreeSlots<Counted, 4> slots;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&, t] {
+        for (int i = 0; i < 100000; ++i) {
+          auto obj = slots.Take();
+          if (!obj) obj = std::make_unique<Counted>(live);
+          obj->owner = t;
+          std::this_thread::yield();
+          if (obj->owner != t) shared = true;
+          slots.Give(obj);
+        }
+      });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_LE(live, 4);
+  }
+  EXPECT_FALSE(shared);
+  EXPECT_EQ(0, live);
+}
+
+}  // namespace cs
@@ -0,0 +1,366 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2019 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "wpi/MathExtras.h"
+#include "wpi/condition_variable.h"
+#include "wpi/mutex.h"
+
+namespace wpi {
+
+namespace detail {
+
+// Assumed cache line size, used to keep the producer and consumer indices from
+// sharing a line.
+constexpr size_t kRingQueueCacheLine = 64;
+
+// A queue index, padded off whatever precedes it. Padding rather than alignas
+// so queues can be heap allocated without C++17 aligned new.
+struct RingQueueIndex {
+  char pad[kRingQueueCacheLine];
+  std::atomic<size_t> pos{0};
+  // the other side's index as last loaded, saves touching its cache line
+  size_t cached = 0;
+};
+
+inline size_t RingQueueCapacity(size_t capacity) {
+  if (capacity < 2) return 2;
+  return isPowerOf2_64(capacity) ? capacity
+                                 : static_cast<size_t>(NextPowerOf2(capacity));
+}
+
+// Lets a consumer block on an empty queue without producers paying for a
+// mutex or syscall on every push: only the first push after the consumer has
+// said it is (about to be) asleep locks and notifies.
+class RingQueueWaiter {
+ public:
+  template <typename Ready>
+  void Wait(Ready ready) {
+    // spinning catches a producer that is mid push, yielding lets one on the
+    // same core finish
+    for (int i = 0; i < 64; ++i) {
+      if (ready()) return;
+    }
+    for (int i = 0; i < 8; ++i) {
+      std::this_thread::yield();
+      if (ready()) return;
+    }
+    std::unique_lock<wpi::mutex> lock(m_mutex);
+    for (;;) {
+      m_waiting.store(true, std::memory_order_relaxed);
+      // pairs with the fence in Notify(): either it sees m_waiting or we see
+      // the item
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (ready()) break;
+      m_cond.wait(lock);
+      if (ready()) break;
+    }
+    m_waiting.store(false, std::memory_order_relaxed);
+  }
+
+  // Call after making an item visible.
+  void Notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiting.load(std::memory_order_relaxed) &&
+        m_waiting.exchange(false, std::memory_order_relaxed)) {
+      // taking the lock orders this with the consumer's ready() check
+      { std::lock_guard<wpi::mutex> lock(m_mutex); }
+      m_cond.notify_one();
+    }
+  }
+
+ private:
+  std::atomic<bool> m_waiting{false};
+  wpi::mutex m_mutex;
+  wpi::condition_variable m_cond;
+};
+
+}  // namespace detail
+
+/**
+ * Bounded lock-free queue for exactly one producer thread and one consumer
+ * thread.
+ *
+ * Has the same push/pop/emplace interface as ConcurrentQueue, plus
+ * non-blocking try_push/try_emplace/try_pop and drain() to consume everything
+ * available at once. Storage is allocated once at construction; the capacity
+ * is rounded up to a power of two. push() and emplace() spin (yielding) while
+ * the queue is full. pop() blocks while the queue is empty; producers only
+ * make a syscall to wake it if it is actually asleep.
+ */
+template <typename T>
+class SpscRingQueue {
+ public:
+  explicit SpscRingQueue(size_t capacity)
+      : m_mask(detail::RingQueueCapacity(capacity) - 1),
+        m_slots(new Slot[m_mask + 1]) {}
+
+  ~SpscRingQueue() { drain([](T&&) {}); }
+
+  SpscRingQueue(const SpscRingQueue&) = delete;
+  SpscRingQueue& operator=(const SpscRingQueue&) = delete;
+
+  size_t capacity() const { return m_mask + 1; }
+
+  bool empty() const { return size() == 0; }
+
+  size_t size() const {
+    size_t tail = m_tail.pos.load(std::memory_order_acquire);
+    size_t head = m_head.pos.load(std::memory_order_acquire);
+    return tail - head;
+  }
+
+  // Producer side
+
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    size_t tail = m_tail.pos.load(std::memory_order_relaxed);
+    if (tail - m_tail.cached == capacity()) {
+      m_tail.cached = m_head.pos.load(std::memory_order_acquire);
+      if (tail - m_tail.cached == capacity()) return false;
+    }
+    new (&m_slots[tail & m_mask]) T(std::forward<Args>(args)...);
+    m_tail.pos.store(tail + 1, std::memory_order_release);
+    m_waiter.Notify();
+    return true;
+  }
+
+  bool try_push(const T& item) { return try_emplace(item); }
+  bool try_push(T&& item) { return try_emplace(std::move(item)); }
+
+  template <typename... Args>
+  void emplace(Args&&... args) {
+    // args are only consumed on success, so forwarding repeatedly is safe
+    while (!try_emplace(std::forward<Args>(args)...)) {
+      std::this_thread::yield();
+    }
+  }
+
+  void push(const T& item) { emplace(item); }
+  void push(T&& item) { emplace(std::move(item)); }
+
+  // Consumer side
+
+  bool try_pop(T& item) {
+    size_t head = m_head.pos.load(std::memory_order_relaxed);
+    if (head == m_head.cached) {
+      m_head.cached = m_tail.pos.load(std::memory_order_acquire);
+      if (head == m_head.cached) return false;
+    }
+    T* slot = Get(head);
+    item = std::move(*slot);
+    slot->~T();
+    m_head.pos.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  void pop(T& item) {
+    if (try_pop(item)) return;
+    m_waiter.Wait([&] { return try_pop(item); });
+  }
+
+  T pop() {
+    T item;
+    pop(item);
+    return item;
+  }
+
+  /**
+   * Calls func(T&&) for each item available now, up to max, and returns how
+   * many that was. Space is handed back to the producer once, at the end.
+   */
+  template <typename F>
+  size_t drain(F func, size_t max = std::numeric_limits<size_t>::max()) {
+    size_t head = m_head.pos.load(std::memory_order_relaxed);
+    m_head.cached = m_tail.pos.load(std::memory_order_acquire);
+    size_t count = m_head.cached - head;
+    if (count > max) count = max;
+    for (size_t i = 0; i < count; ++i) {
+      T* slot = Get(head + i);
+      func(std::move(*slot));
+      slot->~T();
+    }
+    m_head.pos.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+ private:
+  using Slot = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+  T* Get(size_t pos) { return reinterpret_cast<T*>(&m_slots[pos & m_mask]); }
+
+  const size_t m_mask;
+  std::unique_ptr<Slot[]> m_slots;
+
+  // written by the consumer, cached is the tail
+  detail::RingQueueIndex m_head;
+  // written by the producer, cached is the head
+  detail::RingQueueIndex m_tail;
+  detail::RingQueueWaiter m_waiter;
+};
+
+/**
+ * Bounded lock-free queue for any number of producer threads and one consumer
+ * thread.
+ *
+ * Same interface and blocking behavior as SpscRingQueue. Each slot carries a
+ * sequence number, so producers claim a slot with a single compare-exchange
+ * and never wait on each other to finish writing.
+ */
+template <typename T>
+class MpscRingQueue {
+ public:
+  explicit MpscRingQueue(size_t capacity)
+      : m_mask(detail::RingQueueCapacity(capacity) - 1),
+        m_cells(new Cell[m_mask + 1]) {
+    for (size_t i = 0; i <= m_mask; ++i) {
+      m_cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ~MpscRingQueue() { drain([](T&&) {}); }
+
+  MpscRingQueue(const MpscRingQueue&) = delete;
+  MpscRingQueue& operator=(const MpscRingQueue&) = delete;
+
+  size_t capacity() const { return m_mask + 1; }
+
+  bool empty() const { return size() == 0; }
+
+  size_t size() const {
+    size_t tail = m_tail.pos.load(std::memory_order_acquire);
+    size_t head = m_head.pos.load(std::memory_order_acquire);
+    // a producer may have claimed a slot it has not filled yet
+    return tail > head ? tail - head : 0;
+  }
+
+  // Producer side, any thread
+
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    size_t pos = m_tail.pos.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &m_cells[pos & m_mask];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      auto diff = static_cast<ptrdiff_t>(seq - pos);
+      if (diff == 0) {
+        if (m_tail.pos.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // the consumer has not freed this slot from the last lap: full
+        return false;
+      } else {
+        pos = m_tail.pos.load(std::memory_order_relaxed);
+      }
+    }
+    new (&cell->storage) T(std::forward<Args>(args)...);
+    cell->seq.store(pos + 1, std::memory_order_release);
+    m_waiter.Notify();
+    return true;
+  }
+
+  bool try_push(const T& item) { return try_emplace(item); }
+  bool try_push(T&& item) { return try_emplace(std::move(item)); }
+
+  template <typename... Args>
+  void emplace(Args&&... args) {
+    while (!try_emplace(std::forward<Args>(args)...)) {
+      std::this_thread::yield();
+    }
+  }
+
+  void push(const T& item) { emplace(item); }
+  void push(T&& item) { emplace(std::move(item)); }
+
+  // Consumer side, one thread
+
+  bool try_pop(T& item) {
+    size_t pos = m_head.pos.load(std::memory_order_relaxed);
+    Cell* cell = TakeReady(pos);
+    if (!cell) return false;
+    item = std::move(*cell->Get());
+    Release(cell, pos);
+    m_head.pos.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  void pop(T& item) {
+    if (try_pop(item)) return;
+    m_waiter.Wait([&] { return try_pop(item); });
+  }
+
+  T pop() {
+    T item;
+    pop(item);
+    return item;
+  }
+
+  /**
+   * Calls func(T&&) for each item available now, in order, up to max, and
+   * returns how many that was. Stops at the first slot a producer has claimed
+   * but not yet filled.
+   */
+  template <typename F>
+  size_t drain(F func, size_t max = std::numeric_limits<size_t>::max()) {
+    size_t head = m_head.pos.load(std::memory_order_relaxed);
+    size_t count = 0;
+    for (; count < max; ++count) {
+      Cell* cell = TakeReady(head + count);
+      if (!cell) break;
+      func(std::move(*cell->Get()));
+      Release(cell, head + count);
+    }
+    m_head.pos.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> seq;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+    T* Get() { return reinterpret_cast<T*>(&storage); }
+  };
+
+  Cell* TakeReady(size_t pos) {
+    Cell* cell = &m_cells[pos & m_mask];
+    if (cell->seq.load(std::memory_order_acquire) != pos + 1) return nullptr;
+    return cell;
+  }
+
+  void Release(Cell* cell, size_t pos) {
+    cell->Get()->~T();
+    // ready for the producer one lap ahead
+    cell->seq.store(pos + m_mask + 1, std::memory_order_release);
+  }
+
+  const size_t m_mask;
+  std::unique_ptr<Cell[]> m_cells;
+
+  // written by the consumer
+  detail::RingQueueIndex m_head;
+  // contended by producers
+  detail::RingQueueIndex m_tail;
+  detail::RingQueueWaiter m_waiter;
+};
+
+}  // namespace wpi
@@ -0,0 +1,122 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2019 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "wpi/RingQueue.h"  // NOLINT(build/include_order)
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace wpi {
+
+template <typename Q>
+class RingQueueTest : public ::testing::Test {};
+
+using RingQueueTypes =
+    ::testing::Types<SpscRingQueue<int>, MpscRingQueue<int>>;
+TYPED_TEST_CASE(RingQueueTest, RingQueueTypes);
+
+TYPED_TEST(RingQueueTest, Capacity) {
+  TypeParam q(5);
+  ASSERT_EQ(q.capacity(), 8u);
+  for (int i = 0; i < 8; ++i) ASSERT_TRUE(q.try_push(i));
+  ASSERT_FALSE(q.try_push(8));
+  ASSERT_EQ(q.size(), 8u);
+}
+
+TYPED_TEST(RingQueueTest, Fifo) {
+  TypeParam q(4);
+  ASSERT_TRUE(q.empty());
+  int item;
+  ASSERT_FALSE(q.try_pop(item));
+  // go around the ring a few times
+  for (int i = 0; i < 20; ++i) {
+    q.push(i);
+    q.emplace(i + 100);
+    ASSERT_EQ(q.pop(), i);
+    ASSERT_TRUE(q.try_pop(item));
+    ASSERT_EQ(item, i + 100);
+  }
+  ASSERT_TRUE(q.empty());
+}
+
+TYPED_TEST(RingQueueTest, Drain) {
+  TypeParam q(8);
+  for (int i = 0; i < 6; ++i) q.push(i);
+  std::vector<int> out;
+  ASSERT_EQ(q.drain([&](int&& v) { out.push_back(v); }, 4), 4u);
+  ASSERT_EQ(q.drain([&](int&& v) { out.push_back(v); }), 2u);
+  ASSERT_EQ(q.drain([&](int&& v) { out.push_back(v); }), 0u);
+  ASSERT_EQ(out, (std::vector<int>{0, 1, 2, 3, 4, 5}));
+}
+
+TYPED_TEST(RingQueueTest, BlockingPop) {
+  TypeParam q(2);
+  std::thread producer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    q.push(42);
+  });
+  ASSERT_EQ(q.pop(), 42);
+  producer.join();
+}
+
+TEST(RingQueueTest, MoveOnlyAndDestroy) {
+  auto counted = std::make_shared<int>(0);
+  {
+    SpscRingQueue<std::shared_ptr<int>> spsc(4);
+    MpscRingQueue<std::shared_ptr<int>> mpsc(4);
+    spsc.push(counted);
+    spsc.push(counted);
+    mpsc.push(counted);
+    std::shared_ptr<int> out;
+    ASSERT_TRUE(spsc.try_pop(out));
+    out.reset();
+    ASSERT_EQ(counted.use_count(), 3);
+  }
+  // whatever was still queued is destroyed with the queue
+  ASSERT_EQ(counted.use_count(), 1);
+
+  SpscRingQueue<std::unique_ptr<int>> q(2);
+  q.push(std::make_unique<int>(7));
+  ASSERT_EQ(*q.pop(), 7);
+}
+
+TEST(RingQueueTest, SpscThreaded) {
+  constexpr int kCount = 100000;
+  SpscRingQueue<int> q(64);
+  std::thread producer([&] {
+    for (int i = 0; i < kCount; ++i) q.push(i);
+  });
+  for (int i = 0; i < kCount; ++i) ASSERT_EQ(q.pop(), i);
+  producer.join();
+}
+
+TEST(RingQueueTest, MpscThreaded) {
+  // every item arrives once, and each producer's items arrive in order
+  constexpr int kProducers = 4;
+  constexpr int kCount = 50000;
+  MpscRingQueue<int> q(64);
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&q, p] {
+      for (int i = 0; i < kCount; ++i) q.push(p * kCount + i);
+    });
+  }
+  std::vector<int> next(kProducers, 0);
+  for (int n = 0; n < kProducers * kCount; ++n) {
+    int item = q.pop();
+    int p = item / kCount;
+    ASSERT_EQ(item % kCount, next[p]);
+    ++next[p];
+  }
+  for (auto& thr : producers) thr.join();
+  ASSERT_TRUE(q.empty());
+}
+
+}  // namespace wpi
@@ -0,0 +1,67 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) 2019 FIRST. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "wpi/RingQueue.h"  // NOLINT(build/include_order)
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "wpi/ConcurrentQueue.h"
+
+namespace {
+
+constexpr int kItems = 1000000;
+constexpr size_t kCapacity = 1024;
+
+// Pushes kItems spread over producers threads while the calling thread pops
+// them all, and prints the wall time.
+template <typename Q>
+void Bench(const char* name, Q& q, int producers) {
+  using std::chrono::duration_cast;
+  using std::chrono::high_resolution_clock;
+  using std::chrono::microseconds;
+
+  int per_producer = kItems / producers;
+  auto start = high_resolution_clock::now();
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&q, per_producer] {
+      for (int i = 0; i < per_producer; ++i) q.push(i);
+    });
+  }
+  int64_t sum = 0;
+  for (int i = 0; i < per_producer * producers; ++i) sum += q.pop();
+  auto stop = high_resolution_clock::now();
+  for (auto& thr : threads) thr.join();
+
+  auto us = duration_cast<microseconds>(stop - start).count();
+  std::cout << name << " producers: " << producers << " time: " << us
+            << " ns/item: " << us * 1000.0 / (per_producer * producers)
+            << " sum: " << sum << "\n";
+}
+
+}  // namespace
+
+TEST(RingQueueTest, Benchmark) {
+  for (int producers : {1, 2, 4}) {
+    {
+      wpi::ConcurrentQueue<int> q;
+      Bench("ConcurrentQueue", q, producers);
+    }
+    {
+      wpi::MpscRingQueue<int> q(kCapacity);
+      Bench("MpscRingQueue", q, producers);
+    }
+    if (producers == 1) {
+      wpi::SpscRingQueue<int> q(kCapacity);
+      Bench("SpscRingQueue", q, producers);
+    }
+  }
+}